@@ -102,6 +102,22 @@
 #define HASP_USE_HTTP_ASYNC 0 //(HASP_HAS_NETWORK)
 #endif
 
+#ifndef HASP_USE_REMOTE_VIEW
+#if defined(ARDUINO_ARCH_ESP32)
+#define HASP_USE_REMOTE_VIEW (HASP_USE_HTTP) // live view of the display in the browser
+#else
+#define HASP_USE_REMOTE_VIEW 0 // the web server must be able to hand over the client socket
+#endif
+#endif
+
+#ifndef HASP_USE_EVENT_STREAM
+#if defined(ARDUINO_ARCH_ESP32)
+#define HASP_USE_EVENT_STREAM (HASP_USE_HTTP) // state messages as server-sent events
+#else
+#define HASP_USE_EVENT_STREAM 0 // the web server must be able to hand over the client socket
+#endif
+#endif
+
 #ifndef HASP_START_HTTP
 #define HASP_START_HTTP 1
 #endif
@@ -181,6 +197,54 @@
 #define HASP_USE_JPGDECODE 0
 #endif
 
+#ifndef HASP_USE_IMAGE_CACHE
+#define HASP_USE_IMAGE_CACHE 1 // decoded and downloaded images shared by all objects
+#endif
+
+#ifndef HASP_USE_IMAGE_STREAM
+#if defined(ARDUINO_ARCH_ESP32)
+#define HASP_USE_IMAGE_STREAM 1 // PNG and JPEG decoded while they are read
+#else
+#define HASP_USE_IMAGE_STREAM 0
+#endif
+#endif
+
+#ifndef HASP_USE_IMAGE_FETCH
+#if defined(ARDUINO_ARCH_ESP32) && HASP_USE_IMAGE_STREAM > 0
+#define HASP_USE_IMAGE_FETCH 1 // http(s):// and Z: images are loaded by a worker task
+#else
+#define HASP_USE_IMAGE_FETCH 0
+#endif
+#endif
+
+#ifndef HASP_USE_ASSETS
+#if defined(ARDUINO_ARCH_ESP32) || HASP_TARGET_PC
+#define HASP_USE_ASSETS 1 // images and fonts used in place from the mapped assets partition or image file
+#else
+#define HASP_USE_ASSETS 0
+#endif
+#endif
+
+#ifndef HASP_USE_FONT_SUBSET
+#if defined(ARDUINO_ARCH_ESP32) && (HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0)
+#define HASP_USE_FONT_SUBSET 1 // binary fonts reduced to the characters used in the pages
+#else
+#define HASP_USE_FONT_SUBSET 0
+#endif
+#endif
+
+#ifndef HASP_USE_DMA2D
+#define HASP_USE_DMA2D 0 // Chrom-ART accelerator of the STM32F429/F7
+#endif
+
+#ifndef HASP_USE_SHADOW_FB
+#if defined(ESP32) || HASP_TARGET_PC
+#define HASP_USE_SHADOW_FB 1 // copy of the screen for screenshots, remote view and antiburn, PSram only on ESP32
+#else
+#define HASP_USE_SHADOW_FB 0
+#endif
+#endif
+
 #ifndef HASP_NUM_GPIO_CONFIG
 #define HASP_NUM_GPIO_CONFIG 8
 #endif
@@ -40,8 +40,13 @@
 #define LV_COLOR_DEPTH     16
 
  /* Swap the 2 bytes of RGB565 color.
-  * Useful if the display has a 8 bit interface (e.g. SPI)*/
+  * Useful if the display has a 8 bit interface (e.g. SPI)
+  * TFT_eSPI and LovyanGFX panels expect the high byte first, with -D LV_COLOR_16_SWAP=1 the driver pushes
+  * the draw buffer as-is instead of swapping every pixel in flush_pixels(). Screenshots are converted back.
+  * True color .bin images must then be converted for the swapped byte order as well */
+#ifndef LV_COLOR_16_SWAP
 #define LV_COLOR_16_SWAP   0
+#endif
 
   /* 1: Enable screen transparency.
    * Useful for OSD or other overlapping GUIs.
@@ -205,7 +210,7 @@ typedef void* lv_group_user_data_t;
 #endif  /*LV_USE_GROUP*/
 
 /* 1: Enable GPU interface*/
-#define LV_USE_GPU              0
+#define LV_USE_GPU              1 /* fill and blend through haspGpu, see src/drv/gpu */
 
 /* 1: Enable file system (might be required for images */
 #define LV_USE_FILESYSTEM       1
@@ -306,6 +311,20 @@ typedef void* lv_img_decoder_user_data_t;
 #define LV_TICK_CUSTOM_SYS_TIME_EXPR (millis())     /*Expression evaluating to current systime in ms*/
 #endif   /*LV_TICK_CUSTOM*/
 
+#elif defined(POSIX) && USE_FBDEV
+
+/* Use the monotonic clock of the POSIX device, no tick thread needed */
+#define LV_TICK_CUSTOM     1
+#if LV_TICK_CUSTOM == 1
+#ifdef __cplusplus
+extern "C" unsigned long PosixMillis(void);
+#else
+unsigned long PosixMillis(void);
+#endif
+#define LV_TICK_CUSTOM_INCLUDE  <stdint.h>          /*Header for the sys time function*/
+#define LV_TICK_CUSTOM_SYS_TIME_EXPR ((uint32_t)PosixMillis())  /*Expression evaluating to current systime in ms*/
+#endif   /*LV_TICK_CUSTOM*/
+
 #else
 #define LV_TICK_CUSTOM     0
 #endif
@@ -20,6 +20,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
+#include "esp_heap_caps.h"
 
 #if CONFIG_FREERTOS_UNICORE
 #define ARDUINO_RUNNING_CORE 0
@@ -58,6 +59,7 @@ typedef bool FT_glyph_dsc_response;
 /*********************
  *      DEFINES
  *********************/
+#define LV_FT_ATLAS_BUCKETS 128
 
 /**********************
  *      TYPEDEFS
@@ -67,6 +69,25 @@ typedef struct
     lv_ll_t face_ll;
 } lv_faces_control_t;
 
+/* Rendered glyph in an atlas page, followed by its 8 bpp bitmap */
+typedef struct atlas_glyph_t
+{
+    struct atlas_glyph_t* chain; /* next glyph in the same hash bucket */
+    struct atlas_page_t* page;
+    const lv_font_t* font; /* NULL when the font was destroyed */
+    uint32_t letter;
+    uint32_t size; /* glyph and bitmap, pointer aligned */
+    lv_font_glyph_dsc_t dsc;
+} atlas_glyph_t;
+
+typedef struct atlas_page_t
+{
+    struct atlas_page_t* prev; /* most recently used first */
+    struct atlas_page_t* next;
+    uint32_t used;
+    uintptr_t data[LV_FT_ATLAS_PAGE_SIZE / sizeof(uintptr_t)]; /* glyphs, pointer aligned */
+} atlas_page_t;
+
 typedef struct name_refer_t
 {
     const char* name; /* point to font name string */
@@ -81,6 +102,12 @@ static void face_generic_finalizer_cache(void* object);
 static FT_Error font_face_requester(FTC_FaceID face_id, FT_Library library_is, FT_Pointer req_data, FT_Face* aface);
 static bool lv_ft_font_init_cache(lv_ft_info_t* info);
 static void lv_ft_font_destroy_cache(lv_font_t* font);
+static bool get_glyph_dsc_cb(const lv_font_t* font, lv_font_glyph_dsc_t* dsc_out, uint32_t unicode_letter,
+                             uint32_t unicode_letter_next);
+static const uint8_t* get_glyph_bitmap_cb_cache(const lv_font_t* font, uint32_t unicode_letter);
+static void atlas_remove_font(const lv_font_t* font);
+static void atlas_page_unlink(atlas_page_t* page);
+static void atlas_page_reset(atlas_page_t* page);
 #else
 static FT_Face face_find_in_list(lv_ft_info_t* info);
 static void face_add_to_list(FT_Face face);
@@ -113,6 +140,12 @@ static FTC_ImageCache image_cache;
 static FT_Glyph image_glyph;
 #endif
 
+static atlas_page_t* atlas_head; /* pages, most recently used first */
+static atlas_page_t* atlas_tail;
+static atlas_page_t* atlas_fill; /* page new glyphs are added to */
+static atlas_glyph_t* atlas_buckets[LV_FT_ATLAS_BUCKETS];
+static lv_ft_atlas_stats_t atlas_stats;
+
 #else
 static lv_faces_control_t face_control;
 #endif
@@ -214,6 +247,52 @@ void lv_ft_font_destroy(lv_font_t* font)
 #endif
 }
 
+void lv_ft_atlas_set_budget(uint32_t max_bytes)
+{
+#if LV_FREETYPE_CACHE_SIZE >= 0
+    atlas_stats.budget = max_bytes / LV_FT_ATLAS_PAGE_SIZE * LV_FT_ATLAS_PAGE_SIZE;
+
+    /* Free the least recently used pages over the new budget */
+    while(atlas_tail && atlas_stats.pages * LV_FT_ATLAS_PAGE_SIZE > atlas_stats.budget) {
+        atlas_page_t* page = atlas_tail;
+        atlas_page_reset(page);
+        atlas_page_unlink(page);
+        if(page == atlas_fill) atlas_fill = NULL;
+        heap_caps_free(page);
+        atlas_stats.pages--;
+        atlas_stats.used -= sizeof(atlas_page_t);
+    }
+#else
+    LV_UNUSED(max_bytes);
+#endif
+}
+
+void lv_ft_font_prewarm(const lv_font_t* font, const char* txt)
+{
+#if LV_FREETYPE_CACHE_SIZE >= 0
+    if(!font || !txt || font->get_glyph_dsc != get_glyph_dsc_cb) return;
+
+    uint32_t i = 0;
+    while(txt[i] != '\0') {
+        uint32_t letter = _lv_txt_encoded_next(txt, &i);
+        lv_font_glyph_dsc_t dsc;
+        get_glyph_dsc_cb(font, &dsc, letter, ' '); /* not the last letter, italic advance is not adjusted */
+    }
+#else
+    LV_UNUSED(font);
+    LV_UNUSED(txt);
+#endif
+}
+
+void lv_ft_atlas_get_stats(lv_ft_atlas_stats_t* stats)
+{
+#if LV_FREETYPE_CACHE_SIZE >= 0
+    *stats = atlas_stats;
+#else
+    _lv_memset_00(stats, sizeof(lv_ft_atlas_stats_t));
+#endif
+}
+
 size_t lv_ft_freetype_high_watermark()
 {
     return uxTaskGetStackHighWaterMark(FTTaskHandle);
@@ -396,22 +475,189 @@ static const uint8_t* get_glyph_bitmap_cb_cache(const lv_font_t* font, uint32_t
 #endif
 }
 
+/* ===== Glyph atlas ===== */
+
+static void atlas_page_unlink(atlas_page_t* page)
+{
+    if(page->prev)
+        page->prev->next = page->next;
+    else
+        atlas_head = page->next;
+    if(page->next)
+        page->next->prev = page->prev;
+    else
+        atlas_tail = page->prev;
+}
+
+static void atlas_page_to_front(atlas_page_t* page)
+{
+    if(page == atlas_head) return;
+    atlas_page_unlink(page);
+    page->prev = NULL;
+    page->next = atlas_head;
+    if(atlas_head)
+        atlas_head->prev = page;
+    else
+        atlas_tail = page;
+    atlas_head = page;
+}
+
+static inline uint8_t atlas_bucket(const lv_font_t* font, uint32_t letter)
+{
+    return (((uintptr_t)font >> 4) ^ (letter * 2654435761u)) % LV_FT_ATLAS_BUCKETS;
+}
+
+static void atlas_glyph_unhash(atlas_glyph_t* glyph)
+{
+    atlas_glyph_t** link = &atlas_buckets[atlas_bucket(glyph->font, glyph->letter)];
+    while(*link && *link != glyph) link = &(*link)->chain;
+    if(*link) *link = glyph->chain;
+    glyph->font = NULL;
+    atlas_stats.glyphs--;
+}
+
+/* Drop the glyphs of a page and reuse it */
+static void atlas_page_reset(atlas_page_t* page)
+{
+    uint32_t pos = 0;
+    while(pos < page->used) {
+        atlas_glyph_t* glyph = (atlas_glyph_t*)((uint8_t*)page->data + pos);
+        if(glyph->font) atlas_glyph_unhash(glyph);
+        pos += glyph->size;
+    }
+    page->used = 0;
+}
+
+static atlas_glyph_t* atlas_find(const lv_font_t* font, uint32_t letter)
+{
+    for(atlas_glyph_t* glyph = atlas_buckets[atlas_bucket(font, letter)]; glyph; glyph = glyph->chain) {
+        if(glyph->font == font && glyph->letter == letter) {
+            atlas_page_to_front(glyph->page);
+            return glyph;
+        }
+    }
+    return NULL;
+}
+
+/* Space for a glyph in the page being filled, a new page or the least recently used one */
+static atlas_glyph_t* atlas_alloc(uint32_t size)
+{
+    if(size > LV_FT_ATLAS_PAGE_SIZE) return NULL;
+
+    if(!atlas_fill || atlas_fill->used + size > LV_FT_ATLAS_PAGE_SIZE) {
+        atlas_page_t* page = NULL;
+        if((atlas_stats.pages + 1) * LV_FT_ATLAS_PAGE_SIZE <= atlas_stats.budget) {
+            page = heap_caps_malloc(sizeof(atlas_page_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if(!page) page = heap_caps_malloc(sizeof(atlas_page_t), MALLOC_CAP_8BIT);
+            if(page) {
+                page->used = 0;
+                page->prev = NULL;
+                page->next = NULL;
+                if(atlas_tail) {
+                    atlas_tail->next = page;
+                    page->prev       = atlas_tail;
+                } else {
+                    atlas_head = page;
+                }
+                atlas_tail = page;
+                atlas_stats.pages++;
+                atlas_stats.used += sizeof(atlas_page_t);
+            }
+        }
+        if(!page) {
+            page = atlas_tail;
+            if(!page) return NULL;
+            atlas_page_reset(page);
+            atlas_stats.evictions++;
+        }
+        atlas_fill = page;
+    }
+
+    atlas_page_to_front(atlas_fill);
+    atlas_glyph_t* glyph = (atlas_glyph_t*)((uint8_t*)atlas_fill->data + atlas_fill->used);
+    glyph->page          = atlas_fill;
+    glyph->size          = size;
+    atlas_fill->used += size;
+    return glyph;
+}
+
+/* Copy a glyph FreeType has just rendered */
+static void atlas_add(const lv_font_t* font, uint32_t letter, const lv_font_glyph_dsc_t* dsc)
+{
+    const uint8_t* bitmap = get_glyph_bitmap_cb_cache(font, letter);
+    uint32_t bitmap_size  = (uint32_t)dsc->box_w * dsc->box_h; /* 8 bpp */
+    if(bitmap_size && !bitmap) return;
+
+    uint32_t size = (sizeof(atlas_glyph_t) + bitmap_size + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+    atlas_glyph_t* glyph = atlas_alloc(size);
+    if(!glyph) return;
+
+    glyph->font   = font;
+    glyph->letter = letter;
+    glyph->dsc    = *dsc;
+    if(bitmap_size) memcpy(glyph + 1, bitmap, bitmap_size);
+
+    uint8_t bucket        = atlas_bucket(font, letter);
+    glyph->chain          = atlas_buckets[bucket];
+    atlas_buckets[bucket] = glyph;
+    atlas_stats.glyphs++;
+}
+
+/* Forget the glyphs of a destroyed font, their space is reused with the page */
+static void atlas_remove_font(const lv_font_t* font)
+{
+    for(uint16_t bucket = 0; bucket < LV_FT_ATLAS_BUCKETS; bucket++) {
+        atlas_glyph_t* glyph = atlas_buckets[bucket];
+        while(glyph) {
+            atlas_glyph_t* chain = glyph->chain;
+            if(glyph->font == font) atlas_glyph_unhash(glyph);
+            glyph = chain;
+        }
+    }
+}
+
+static const uint8_t* get_glyph_bitmap_cb_atlas(const lv_font_t* font, uint32_t unicode_letter)
+{
+    atlas_glyph_t* glyph = atlas_find(font, unicode_letter);
+    if(glyph) return (const uint8_t*)(glyph + 1);
+
+    return get_glyph_bitmap_cb_cache(font, unicode_letter); /* not in the atlas, still the last rendered glyph */
+}
+
 static bool get_glyph_dsc_cb(const lv_font_t* font, lv_font_glyph_dsc_t* dsc_out, uint32_t unicode_letter,
                              uint32_t unicode_letter_next)
 {
     static FT_glyph_dsc_request request;
     static FT_glyph_dsc_response response;
 
+    lv_font_fmt_ft_dsc_t* dsc = (lv_font_fmt_ft_dsc_t*)(font->dsc);
+    bool italic_end           = (dsc->style & FT_FONT_STYLE_ITALIC) && (unicode_letter_next == '\0');
+
+    if(unicode_letter >= 0x20) {
+        atlas_glyph_t* glyph = atlas_find(font, unicode_letter);
+        if(glyph) {
+            atlas_stats.hits++;
+            *dsc_out = glyph->dsc;
+            if(italic_end) dsc_out->adv_w = dsc_out->box_w + dsc_out->ofs_x;
+            return true;
+        }
+    }
+
     request.font                = font;
     request.dsc_out             = dsc_out;
     request.unicode_letter      = unicode_letter;
     request.unicode_letter_next = unicode_letter_next;
     xQueueSendToBack(FTRequestQueue, &request, portMAX_DELAY);
-    if(xQueueReceive(FTResponseQueue, &response, portMAX_DELAY)) {
-        return response;
-    } else {
+    if(!xQueueReceive(FTResponseQueue, &response, portMAX_DELAY)) {
         return false; // should never happen
     }
+
+    /* The italic advance of the last letter is not kept */
+    if(response && unicode_letter >= 0x20 && atlas_stats.budget > 0) {
+        atlas_stats.misses++;
+        if(!italic_end) atlas_add(font, unicode_letter, dsc_out);
+    }
+    return response;
 }
 
 void FT_loop_task(void* pvParameters)
@@ -466,7 +712,7 @@ static bool lv_ft_font_init_cache(lv_ft_info_t* info)
     font->dsc       = dsc;
     // font->get_glyph_dsc = get_glyph_dsc_cb_cache;
     font->get_glyph_dsc    = get_glyph_dsc_cb;
-    font->get_glyph_bitmap = get_glyph_bitmap_cb_cache;
+    font->get_glyph_bitmap = get_glyph_bitmap_cb_atlas;
     font->line_height      = ((32 + face_size->face->size->metrics.height) >> 6);
     font->base_line        = ((32 - face_size->face->size->metrics.descender) >> 6);
     font->subpx            = LV_FONT_SUBPX_NONE;
@@ -503,10 +749,10 @@ void lv_ft_font_destroy_cache(lv_font_t* font)
     if(dsc) {
         LV_LOG_WARN("RemoveFaceID : %s %u", dsc->name, dsc->height);
 
+        atlas_remove_font(font);
         FTC_Manager_RemoveFaceID(cache_manager, (FTC_FaceID)dsc);
         name_refer_del(dsc->name);
-        lv_mem_free(dsc);
-        font->dsc = NULL;
+        lv_mem_free(dsc); /* font is part of the same allocation */
     }
 }
 #else /* LV_FREETYPE_CACHE_SIZE */
@@ -18,6 +18,9 @@ extern "C" {
 /*********************
  *      DEFINES
  *********************/
+#ifndef LV_FT_ATLAS_PAGE_SIZE
+#define LV_FT_ATLAS_PAGE_SIZE (8 * 1024) /* rendered glyphs are packed into pages of this size */
+#endif
 
 /**********************
  *      TYPEDEFS
@@ -47,6 +50,17 @@ typedef struct
     uint16_t height;
 } lv_font_fmt_ft_dsc_t;
 
+typedef struct
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions; /* pages dropped to stay within the budget */
+    uint32_t used;      /* bytes of the allocated pages */
+    uint32_t budget;
+    uint16_t pages;
+    uint16_t glyphs;
+} lv_ft_atlas_stats_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -80,6 +94,25 @@ bool lv_ft_font_init(lv_ft_info_t* info);
  */
 void lv_ft_font_destroy(lv_font_t* font);
 
+/**
+ * Set the memory for the rendered glyphs of all FreeType fonts, 0 disables the atlas.
+ * @param max_bytes the bytes of the atlas pages, rounded down to whole pages
+ */
+void lv_ft_atlas_set_budget(uint32_t max_bytes);
+
+/**
+ * Render the characters of a text into the atlas, so drawing it later does not call FreeType.
+ * @param font a font created by lv_ft_font_init, other fonts are ignored
+ * @param txt UTF-8 text
+ */
+void lv_ft_font_prewarm(const lv_font_t* font, const char* txt);
+
+/**
+ * Get the counters of the glyph atlas.
+ * @param stats filled with the counters
+ */
+void lv_ft_atlas_get_stats(lv_ft_atlas_stats_t* stats);
+
 // Unsed Task memory
 size_t lv_ft_freetype_high_watermark();
 
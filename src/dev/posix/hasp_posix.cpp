@@ -283,10 +283,10 @@ long PosixDevice::get_uptime()
 
 static time_t tv_sec_start = 0;
 
-unsigned long PosixMillis()
+unsigned long PosixMillis(void)
 {
     struct timespec spec;
-    clock_gettime(CLOCK_REALTIME, &spec);
+    clock_gettime(CLOCK_MONOTONIC, &spec); // not affected by NTP or manual clock changes
     if(tv_sec_start == 0) {
         tv_sec_start = spec.tv_sec;
     }
@@ -79,7 +79,7 @@ class PosixDevice : public BaseDevice {
 
 } // namespace dev
 
-extern unsigned long PosixMillis();
+extern "C" unsigned long PosixMillis(void); // monotonic, also used as LVGL tick source
 extern void msleep(unsigned long millis);
 
 using dev::PosixDevice;
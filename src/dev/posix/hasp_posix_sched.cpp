@@ -0,0 +1,148 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#if defined(POSIX) && USE_FBDEV && HASP_TARGET_PC
+
+#include <atomic>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+
+#include "hasp_conf.h"
+#include "hasp_debug.h"
+#include "hasp_posix_sched.h"
+
+#define SCHED_MAX_SLEEP 1000  // [ms] check pc_is_running at least once per second
+#define SCHED_INPUT_GRACE 500 // [ms] keep reading an input device after its last event, for drag throw etc.
+
+struct sched_task_t
+{
+    lv_task_t* task;
+    uint8_t prio; // priority to restore on resume
+    bool paused;
+};
+
+struct sched_input_t
+{
+    lv_indev_t* indev;
+    int fd; // our own evdev handle, only used to wait for activity
+    uint32_t last_event;
+    sched_task_t read;
+};
+
+static std::vector<sched_input_t> sched_inputs;
+static sched_task_t sched_refr = {NULL, 0, false};
+static int sched_pipe[2]       = {-1, -1}; // self-pipe to wake up poll() from other threads
+static std::atomic<uint32_t> sched_next_due(0); // lv_tick of the next lv_task, read by the main loop
+
+static bool sched_task_pause(sched_task_t& item, bool pause)
+{
+    if(!item.task || item.paused == pause) return false;
+
+    if(pause) {
+        item.prio = item.task->prio;
+        lv_task_set_prio(item.task, LV_TASK_PRIO_OFF);
+    } else {
+        lv_task_set_prio(item.task, (lv_task_prio_t)item.prio);
+    }
+    item.paused = pause;
+    return true;
+}
+
+/* Pause the display refresh and input read tasks when they have nothing to do
+ * Returns true when a task was paused or resumed and the task handler must be called again */
+static bool sched_update_tasks(void)
+{
+    bool changed    = false;
+    lv_disp_t* disp = lv_disp_get_default();
+
+    if(disp && disp->refr_task != sched_refr.task) sched_refr = {disp->refr_task, 0, false};
+    if(disp) changed |= sched_task_pause(sched_refr, disp->inv_p == 0);
+
+    uint32_t now = lv_tick_get();
+    for(auto& input : sched_inputs) {
+        bool idle = input.indev->proc.state == LV_INDEV_STATE_REL && !lv_indev_is_dragging(input.indev) &&
+                    now - input.last_event > SCHED_INPUT_GRACE;
+        changed |= sched_task_pause(input.read, idle);
+    }
+
+    return changed;
+}
+
+static void sched_drain(int fd)
+{
+    uint8_t buffer[256];
+    while(read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+void posix_sched_init(void)
+{
+    if(sched_pipe[0] != -1) return;
+
+    if(pipe(sched_pipe) == -1) {
+        LOG_ERROR(TAG_GUI, F("Scheduler wakeup pipe failed"));
+        sched_pipe[0] = sched_pipe[1] = -1;
+        return;
+    }
+    for(int fd : sched_pipe) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/* Register an evdev input device, its lvgl read task only runs while the device is active */
+void posix_sched_add_input(lv_indev_t* indev, const char* dev_path)
+{
+    if(!indev) return;
+
+    // Each evdev client receives its own copy of the events, so this does not steal input from lvgl
+    int fd = open(dev_path, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    if(fd == -1) {
+        LOG_WARNING(TAG_GUI, F("Scheduler can't watch %s, polling it instead"), dev_path);
+        return;
+    }
+
+    sched_input_t input = {indev, fd, 0, {indev->driver.read_task, 0, false}};
+    sched_inputs.push_back(input);
+}
+
+/* Thread-safe, makes the GUI task re-evaluate its tasks, e.g. after an MQTT command changed the screen */
+void posix_sched_wakeup(void)
+{
+    if(sched_pipe[1] == -1) return;
+    ssize_t res = write(sched_pipe[1], "", 1); // a full pipe already guarantees a wakeup
+    (void)res;
+}
+
+/* Thread-safe, milliseconds until the GUI task runs its next lvgl task, at least 1 to not spin */
+uint32_t posix_sched_time_till_next(void)
+{
+    int32_t remaining = (int32_t)(sched_next_due - lv_tick_get());
+    return remaining > 1 ? remaining : 1;
+}
+
+/* Run the due lvgl tasks and sleep until the next task, input event or wakeup */
+void posix_sched_run(uint32_t (*task_handler)(void))
+{
+    uint32_t timeout;
+    do {
+        timeout = task_handler();
+    } while(sched_update_tasks());
+    if(timeout > SCHED_MAX_SLEEP) timeout = SCHED_MAX_SLEEP; // also covers LV_NO_TASK_READY
+    sched_next_due = lv_tick_get() + timeout;
+
+    size_t count = sched_inputs.size() + 1;
+    std::vector<struct pollfd> fds(count);
+    fds[0] = {sched_pipe[0], POLLIN, 0};
+    for(size_t i = 1; i < count; i++) fds[i] = {sched_inputs[i - 1].fd, POLLIN, 0};
+
+    if(poll(fds.data(), count, timeout) <= 0) return; // timeout, error or signal
+
+    if(fds[0].revents & POLLIN) sched_drain(fds[0].fd);
+    for(size_t i = 1; i < count; i++) {
+        if(!(fds[i].revents & POLLIN)) continue;
+        sched_drain(fds[i].fd);
+        sched_inputs[i - 1].last_event = lv_tick_get(); // resumes the read task in sched_update_tasks()
+    }
+}
+
+#endif // POSIX && USE_FBDEV
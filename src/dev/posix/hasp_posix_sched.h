@@ -0,0 +1,27 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_POSIX_SCHED_H
+#define HASP_POSIX_SCHED_H
+
+#if defined(POSIX) && USE_FBDEV && HASP_TARGET_PC
+
+#include <cstdint>
+
+#include "lvgl.h"
+
+/* Event driven LVGL scheduler
+ *
+ * Instead of polling lv_task_handler() at a fixed rate, the GUI task sleeps in poll() until
+ * the next lv_task is due, an input device has data or another thread requests a wakeup.
+ * Idle display refresh and input read tasks are paused, so an idle screen causes no wakeups.
+ */
+void posix_sched_init(void);
+void posix_sched_add_input(lv_indev_t* indev, const char* dev_path);
+void posix_sched_wakeup(void);
+void posix_sched_run(uint32_t (*task_handler)(void)); // lv_task_handler or a wrapper of it
+uint32_t posix_sched_time_till_next(void);
+
+#endif // POSIX && USE_FBDEV
+
+#endif // HASP_POSIX_SCHED_H
@@ -0,0 +1,47 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#include "gpu_driver.h"
+#include "pixel_kernels.h"
+
+namespace dev {
+
+const char* BaseGpu::get_name()
+{
+    return pixel_kernels->name;
+}
+
+void IRAM_ATTR BaseGpu::fill(lv_color_t* dest_buf, lv_coord_t dest_width, const lv_area_t* fill_area,
+                             lv_color_t color)
+{
+#if LV_COLOR_DEPTH == 16
+    dest_buf += dest_width * fill_area->y1 + fill_area->x1;
+    pixel_fill_rect(pixel_kernels, (uint16_t*)dest_buf, dest_width, lv_area_get_width(fill_area),
+                    lv_area_get_height(fill_area), color.full);
+#else
+    dest_buf += dest_width * fill_area->y1;
+    for(lv_coord_t y = fill_area->y1; y <= fill_area->y2; y++, dest_buf += dest_width)
+        for(lv_coord_t x = fill_area->x1; x <= fill_area->x2; x++) dest_buf[x] = color;
+#endif
+}
+
+void IRAM_ATTR BaseGpu::blend(lv_color_t* dest, const lv_color_t* src, uint32_t length, lv_opa_t opa)
+{
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0
+    pixel_kernels->blend((uint16_t*)dest, (const uint16_t*)src, length, opa);
+#else
+    if(opa > LV_OPA_MAX) {
+        memcpy(dest, src, length * sizeof(lv_color_t));
+        return;
+    }
+    for(uint32_t i = 0; i < length; i++) dest[i] = lv_color_mix(src[i], dest[i], opa);
+#endif
+}
+
+} // namespace dev
+
+#if HASP_USE_DMA2D == 0 || !(defined(STM32F4) || defined(STM32F7))
+dev::BaseGpu haspGpu;
+#endif
@@ -0,0 +1,41 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_BASE_GPU_DRIVER_H
+#define HASP_BASE_GPU_DRIVER_H
+
+#include "lvgl.h"
+
+namespace dev {
+
+/* 2D acceleration hooks for the LVGL draw buffer
+ *
+ * The base class is the software reference, it renders with the pixel kernels and is used on
+ * every target without a 2D accelerator, including the PC builds.
+ * Derived drivers may return before an operation is finished, lvgl calls wait() before it
+ * touches the draw buffer again.
+ */
+class BaseGpu {
+  public:
+    virtual void init()
+    {}
+    virtual const char* get_name();
+
+    // Fill an area of the draw buffer, fill_area is relative to the buffer which is dest_width pixels wide
+    virtual void fill(lv_color_t* dest_buf, lv_coord_t dest_width, const lv_area_t* fill_area, lv_color_t color);
+    // Blend a row of pixels onto the draw buffer, an opa above LV_OPA_MAX is a plain copy
+    virtual void blend(lv_color_t* dest, const lv_color_t* src, uint32_t length, lv_opa_t opa);
+    virtual void wait()
+    {}
+};
+
+} // namespace dev
+
+#if HASP_USE_DMA2D > 0 && (defined(STM32F4) || defined(STM32F7))
+#include "gpu_driver_dma2d.h"
+#else
+using dev::BaseGpu;
+extern dev::BaseGpu haspGpu;
+#endif
+
+#endif // HASP_BASE_GPU_DRIVER_H
@@ -0,0 +1,144 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if HASP_USE_DMA2D > 0 && (defined(STM32F4) || defined(STM32F7))
+#include "gpu_driver_dma2d.h"
+
+// Register bits, spelled out because the CMSIS names differ between the F4 and F7 headers
+#define DMA2D_MODE_M2M (0UL << 16)       // memory-to-memory
+#define DMA2D_MODE_M2M_BLEND (2UL << 16) // memory-to-memory with blending
+#define DMA2D_MODE_R2M (3UL << 16)       // register-to-memory, fill with OCOLR
+#define DMA2D_START (1UL << 0)
+#define DMA2D_FLAG_TE (1UL << 0) // transfer error
+#define DMA2D_FLAG_TC (1UL << 1) // transfer complete
+#define DMA2D_FLAG_CE (1UL << 5) // configuration error
+#define DMA2D_CM_RGB565 2UL
+#define DMA2D_AM_REPLACE (1UL << 16) // replace the foreground alpha with ALPHA
+#define DMA2D_CACHE_LINE 32
+
+namespace dev {
+
+// The accelerator is an AHB master that can't reach the core coupled memory of the F4
+static inline bool dma2d_reachable(const void* ptr)
+{
+#if defined(STM32F4) && defined(CCMDATARAM_BASE)
+    return (uint32_t)ptr < CCMDATARAM_BASE || (uint32_t)ptr >= CCMDATARAM_BASE + 0x10000;
+#else
+    return true;
+#endif
+}
+
+static inline void dma2d_cache_clean_invalidate(const void* ptr, uint32_t size)
+{
+#if defined(STM32F7)
+    if(!(SCB->CCR & SCB_CCR_DC_Msk)) return;
+    uint32_t start = (uint32_t)ptr & ~(DMA2D_CACHE_LINE - 1);
+    uint32_t end   = (uint32_t)ptr + size;
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t*)start, end - start);
+#endif
+}
+
+static inline void dma2d_cache_invalidate(const void* ptr, uint32_t size)
+{
+#if defined(STM32F7)
+    if(!(SCB->CCR & SCB_CCR_DC_Msk)) return;
+    uint32_t start = (uint32_t)ptr & ~(DMA2D_CACHE_LINE - 1);
+    uint32_t end   = (uint32_t)ptr + size;
+    SCB_InvalidateDCache_by_Addr((uint32_t*)start, end - start);
+#endif
+}
+
+void GpuDma2d::init()
+{
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2DEN;
+    volatile uint32_t delay = RCC->AHB1ENR; // wait for the peripheral clock
+    (void)delay;
+
+    DMA2D->OPFCCR  = DMA2D_CM_RGB565;
+    DMA2D->BGPFCCR = DMA2D_CM_RGB565;
+    _busy          = false;
+}
+
+const char* GpuDma2d::get_name()
+{
+    return "dma2d";
+}
+
+void GpuDma2d::wait()
+{
+    if(!_busy) return;
+
+    while(DMA2D->CR & DMA2D_START) {
+    }
+    uint32_t flags = DMA2D->ISR;
+    DMA2D->IFCR    = flags;
+    _busy          = false;
+
+    dma2d_cache_invalidate(_dest, _dest_size); // drop lines the cpu speculatively loaded during the transfer
+    if(flags & (DMA2D_FLAG_TE | DMA2D_FLAG_CE)) LOG_ERROR(TAG_LVGL, F("DMA2D transfer error %x"), flags);
+}
+
+void GpuDma2d::start(uint32_t mode, void* dest, uint32_t dest_size)
+{
+    _dest      = dest;
+    _dest_size = dest_size;
+    _busy      = true;
+    DMA2D->CR  = mode | DMA2D_START;
+}
+
+void IRAM_ATTR GpuDma2d::fill(lv_color_t* dest_buf, lv_coord_t dest_width, const lv_area_t* fill_area,
+                              lv_color_t color)
+{
+    wait();
+    if(LV_COLOR_DEPTH != 16 || !dma2d_reachable(dest_buf)) {
+        BaseGpu::fill(dest_buf, dest_width, fill_area, color);
+        return;
+    }
+
+    uint32_t w = lv_area_get_width(fill_area);
+    uint32_t h = lv_area_get_height(fill_area);
+    dest_buf += dest_width * fill_area->y1 + fill_area->x1;
+    uint32_t size = ((h - 1) * dest_width + w) * sizeof(lv_color_t);
+    dma2d_cache_clean_invalidate(dest_buf, size);
+
+    DMA2D->OCOLR = color.full; // stored as is, so the lvgl byte order is kept
+    DMA2D->OMAR  = (uint32_t)dest_buf;
+    DMA2D->OOR   = dest_width - w;
+    DMA2D->NLR   = (w << 16) | h;
+    start(DMA2D_MODE_R2M, dest_buf, size);
+}
+
+void IRAM_ATTR GpuDma2d::blend(lv_color_t* dest, const lv_color_t* src, uint32_t length, lv_opa_t opa)
+{
+    wait();
+    bool copy = opa > LV_OPA_MAX;
+    if(LV_COLOR_DEPTH != 16 || (!copy && LV_COLOR_16_SWAP != 0) || !dma2d_reachable(dest) || !dma2d_reachable(src)) {
+        BaseGpu::blend(dest, src, length, opa); // the blender only understands little endian RGB565
+        return;
+    }
+
+    uint32_t size = length * sizeof(lv_color_t);
+    dma2d_cache_clean_invalidate(src, size);
+    dma2d_cache_clean_invalidate(dest, size);
+
+    DMA2D->FGMAR   = (uint32_t)src;
+    DMA2D->FGOR    = 0;
+    DMA2D->FGPFCCR = DMA2D_CM_RGB565 | DMA2D_AM_REPLACE | ((uint32_t)opa << 24);
+    DMA2D->OMAR    = (uint32_t)dest;
+    DMA2D->OOR     = 0;
+    DMA2D->NLR     = (length << 16) | 1;
+    if(copy) {
+        start(DMA2D_MODE_M2M, dest, size);
+    } else {
+        DMA2D->BGMAR = (uint32_t)dest;
+        DMA2D->BGOR  = 0;
+        start(DMA2D_MODE_M2M_BLEND, dest, size);
+    }
+}
+
+} // namespace dev
+
+dev::GpuDma2d haspGpu;
+#endif
@@ -0,0 +1,39 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_DMA2D_GPU_DRIVER_H
+#define HASP_DMA2D_GPU_DRIVER_H
+
+#include "gpu_driver.h"
+
+#if HASP_USE_DMA2D > 0 && (defined(STM32F4) || defined(STM32F7))
+
+namespace dev {
+
+/* Chrom-ART (DMA2D) accelerator of the STM32F429/F439 and STM32F7
+ * Fills, copies and blends run asynchronously, the next operation or wait() waits for completion. */
+class GpuDma2d : public BaseGpu {
+  public:
+    void init() override;
+    const char* get_name() override;
+
+    void fill(lv_color_t* dest_buf, lv_coord_t dest_width, const lv_area_t* fill_area, lv_color_t color) override;
+    void blend(lv_color_t* dest, const lv_color_t* src, uint32_t length, lv_opa_t opa) override;
+    void wait() override;
+
+  private:
+    void start(uint32_t mode, void* dest, uint32_t dest_size);
+
+    bool _busy;
+    void* _dest; // output area of the running transfer, to invalidate the data cache
+    uint32_t _dest_size;
+};
+
+} // namespace dev
+
+using dev::GpuDma2d;
+extern dev::GpuDma2d haspGpu;
+
+#endif
+
+#endif // HASP_DMA2D_GPU_DRIVER_H
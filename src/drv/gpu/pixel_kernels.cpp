@@ -0,0 +1,377 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include <string.h>
+
+#include "pixel_kernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(ARDUINO_ARCH_ESP32)
+#include "esp_attr.h"
+#endif
+
+#define PIXEL_OPA_MAX 253       // same as LV_OPA_MAX, above this the source is copied
+#define PIXEL_MIX_ROUND_OFS 128 // same as LV_COLOR_MIX_ROUND_OFS for 16-bit colors
+#define PIXEL_UDIV255(x) (((uint32_t)(x)*0x8081U) >> 0x17)
+
+/* ===== Scalar reference ===== */
+
+static inline uint16_t pixel_mix(uint16_t fg, uint16_t bg, uint8_t mix)
+{
+    uint32_t inv = 255 - mix;
+    uint32_t r   = PIXEL_UDIV255((fg >> 11) * mix + (bg >> 11) * inv + PIXEL_MIX_ROUND_OFS);
+    uint32_t g   = PIXEL_UDIV255(((fg >> 5) & 0x3F) * mix + ((bg >> 5) & 0x3F) * inv + PIXEL_MIX_ROUND_OFS);
+    uint32_t b   = PIXEL_UDIV255((fg & 0x1F) * mix + (bg & 0x1F) * inv + PIXEL_MIX_ROUND_OFS);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static inline uint32_t pixel_to_xrgb8888(uint16_t c)
+{
+    uint32_t r = ((c >> 11) * 263 + 7) >> 5;
+    uint32_t g = (((c >> 5) & 0x3F) * 259 + 3) >> 6;
+    uint32_t b = ((c & 0x1F) * 263 + 7) >> 5;
+    return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+
+static inline uint16_t pixel_from_rgb(uint8_t r, uint8_t g, uint8_t b)
+{
+    return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+static void scalar_fill(uint16_t* dest, uint16_t color, uint32_t len)
+{
+    for(uint32_t i = 0; i < len; i++) dest[i] = color;
+}
+
+static void scalar_blend(uint16_t* dest, const uint16_t* src, uint32_t len, uint8_t opa)
+{
+    if(opa > PIXEL_OPA_MAX) {
+        memcpy(dest, src, len * sizeof(uint16_t));
+        return;
+    }
+    for(uint32_t i = 0; i < len; i++) dest[i] = pixel_mix(src[i], dest[i], opa);
+}
+
+static void scalar_to_xrgb8888(uint32_t* dest, const uint16_t* src, uint32_t len)
+{
+    for(uint32_t i = 0; i < len; i++) dest[i] = pixel_to_xrgb8888(src[i]);
+}
+
+static void scalar_to_rgb888(uint8_t* dest, const uint16_t* src, uint32_t len)
+{
+    for(uint32_t i = 0; i < len; i++) {
+        uint32_t c = pixel_to_xrgb8888(src[i]);
+        *dest++    = (uint8_t)(c >> 16);
+        *dest++    = (uint8_t)(c >> 8);
+        *dest++    = (uint8_t)c;
+    }
+}
+
+static void scalar_from_xrgb8888(uint16_t* dest, const uint32_t* src, uint32_t len)
+{
+    for(uint32_t i = 0; i < len; i++) dest[i] = pixel_from_rgb(src[i] >> 16, src[i] >> 8, src[i]);
+}
+
+static void scalar_from_rgb888(uint16_t* dest, const uint8_t* src, uint32_t len)
+{
+    for(uint32_t i = 0; i < len; i++, src += 3) dest[i] = pixel_from_rgb(src[0], src[1], src[2]);
+}
+
+static void scalar_swap16(uint16_t* dest, const uint16_t* src, uint32_t len)
+{
+    for(uint32_t i = 0; i < len; i++) dest[i] = (uint16_t)((src[i] << 8) | (src[i] >> 8));
+}
+
+const pixel_kernels_t pixel_kernels_scalar = {
+    "scalar",           scalar_fill,        scalar_blend,         scalar_to_xrgb8888,
+    scalar_to_rgb888,   scalar_from_xrgb8888, scalar_from_rgb888, scalar_swap16,
+};
+
+#if defined(__SSE2__)
+/* ===== SSE2, 8 pixels per iteration ===== */
+
+static void sse2_fill(uint16_t* dest, uint16_t color, uint32_t len)
+{
+    __m128i c  = _mm_set1_epi16((short)color);
+    uint32_t i = 0;
+    for(; i + 8 <= len; i += 8) _mm_storeu_si128((__m128i*)(dest + i), c);
+    scalar_fill(dest + i, color, len - i);
+}
+
+static inline __m128i sse2_mix(__m128i fg, __m128i bg, __m128i mix, __m128i inv)
+{
+    __m128i v = _mm_add_epi16(_mm_mullo_epi16(fg, mix), _mm_mullo_epi16(bg, inv));
+    v         = _mm_add_epi16(v, _mm_set1_epi16(PIXEL_MIX_ROUND_OFS));
+    return _mm_srli_epi16(_mm_mulhi_epu16(v, _mm_set1_epi16((short)0x8081)), 7); // PIXEL_UDIV255
+}
+
+static void sse2_blend(uint16_t* dest, const uint16_t* src, uint32_t len, uint8_t opa)
+{
+    if(opa > PIXEL_OPA_MAX) {
+        memcpy(dest, src, len * sizeof(uint16_t));
+        return;
+    }
+
+    __m128i mix   = _mm_set1_epi16(opa);
+    __m128i inv   = _mm_set1_epi16(255 - opa);
+    __m128i mask5 = _mm_set1_epi16(0x1F);
+    __m128i mask6 = _mm_set1_epi16(0x3F);
+    uint32_t i    = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        __m128i r = sse2_mix(_mm_srli_epi16(s, 11), _mm_srli_epi16(d, 11), mix, inv);
+        __m128i g = sse2_mix(_mm_and_si128(_mm_srli_epi16(s, 5), mask6), _mm_and_si128(_mm_srli_epi16(d, 5), mask6),
+                             mix, inv);
+        __m128i b = sse2_mix(_mm_and_si128(s, mask5), _mm_and_si128(d, mask5), mix, inv);
+        __m128i c = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b);
+        _mm_storeu_si128((__m128i*)(dest + i), c);
+    }
+    for(; i < len; i++) dest[i] = pixel_mix(src[i], dest[i], opa);
+}
+
+static void sse2_to_xrgb8888(uint32_t* dest, const uint16_t* src, uint32_t len)
+{
+    __m128i mask5 = _mm_set1_epi16(0x1F);
+    __m128i mask6 = _mm_set1_epi16(0x3F);
+    __m128i alpha = _mm_set1_epi16((short)0xFF00);
+    uint32_t i    = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i r = _mm_srli_epi16(c, 11);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask6);
+        __m128i b = _mm_and_si128(c, mask5);
+        r         = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(263)), _mm_set1_epi16(7)), 5);
+        g         = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(259)), _mm_set1_epi16(3)), 6);
+        b         = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(263)), _mm_set1_epi16(7)), 5);
+        __m128i gb = _mm_or_si128(_mm_slli_epi16(g, 8), b);
+        __m128i ar = _mm_or_si128(alpha, r);
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi16(gb, ar));
+        _mm_storeu_si128((__m128i*)(dest + i + 4), _mm_unpackhi_epi16(gb, ar));
+    }
+    scalar_to_xrgb8888(dest + i, src + i, len - i);
+}
+
+static inline __m128i sse2_from_xrgb8888_4(__m128i c)
+{
+    __m128i r = _mm_and_si128(_mm_srli_epi32(c, 8), _mm_set1_epi32(0xF800));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(c, 5), _mm_set1_epi32(0x07E0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(c, 3), _mm_set1_epi32(0x001F));
+    __m128i v = _mm_or_si128(_mm_or_si128(r, g), b);
+    return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16); // sign extend, so packs keeps the bit pattern
+}
+
+static void sse2_from_xrgb8888(uint16_t* dest, const uint32_t* src, uint32_t len)
+{
+    uint32_t i = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m128i lo = sse2_from_xrgb8888_4(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m128i hi = sse2_from_xrgb8888_4(_mm_loadu_si128((const __m128i*)(src + i + 4)));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(lo, hi));
+    }
+    scalar_from_xrgb8888(dest + i, src + i, len - i);
+}
+
+static void sse2_swap16(uint16_t* dest, const uint16_t* src, uint32_t len)
+{
+    uint32_t i = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_or_si128(_mm_slli_epi16(c, 8), _mm_srli_epi16(c, 8)));
+    }
+    scalar_swap16(dest + i, src + i, len - i);
+}
+
+// Packed 24-bit needs a byte shuffle that SSE2 lacks, the scalar versions are used
+const pixel_kernels_t pixel_kernels_native = {
+    "sse2",           sse2_fill,          sse2_blend,         sse2_to_xrgb8888,
+    scalar_to_rgb888, sse2_from_xrgb8888, scalar_from_rgb888, sse2_swap16,
+};
+
+#elif defined(__ARM_NEON)
+/* ===== NEON, 8 pixels per iteration ===== */
+
+static void neon_fill(uint16_t* dest, uint16_t color, uint32_t len)
+{
+    uint16x8_t c = vdupq_n_u16(color);
+    uint32_t i   = 0;
+    for(; i + 8 <= len; i += 8) vst1q_u16(dest + i, c);
+    scalar_fill(dest + i, color, len - i);
+}
+
+static inline uint16x8_t neon_mix(uint16x8_t fg, uint16x8_t bg, uint16x8_t mix, uint16x8_t inv)
+{
+    uint16x8_t v  = vmlaq_u16(vmulq_u16(fg, mix), bg, inv);
+    v             = vaddq_u16(v, vdupq_n_u16(PIXEL_MIX_ROUND_OFS));
+    uint32x4_t lo = vmull_u16(vget_low_u16(v), vdup_n_u16(0x8081));
+    uint32x4_t hi = vmull_u16(vget_high_u16(v), vdup_n_u16(0x8081));
+    return vshrq_n_u16(vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16)), 7); // PIXEL_UDIV255
+}
+
+static void neon_blend(uint16_t* dest, const uint16_t* src, uint32_t len, uint8_t opa)
+{
+    if(opa > PIXEL_OPA_MAX) {
+        memcpy(dest, src, len * sizeof(uint16_t));
+        return;
+    }
+
+    uint16x8_t mix   = vdupq_n_u16(opa);
+    uint16x8_t inv   = vdupq_n_u16(255 - opa);
+    uint16x8_t mask5 = vdupq_n_u16(0x1F);
+    uint16x8_t mask6 = vdupq_n_u16(0x3F);
+    uint32_t i       = 0;
+    for(; i + 8 <= len; i += 8) {
+        uint16x8_t s = vld1q_u16(src + i);
+        uint16x8_t d = vld1q_u16(dest + i);
+        uint16x8_t r = neon_mix(vshrq_n_u16(s, 11), vshrq_n_u16(d, 11), mix, inv);
+        uint16x8_t g = neon_mix(vandq_u16(vshrq_n_u16(s, 5), mask6), vandq_u16(vshrq_n_u16(d, 5), mask6), mix, inv);
+        uint16x8_t b = neon_mix(vandq_u16(s, mask5), vandq_u16(d, mask5), mix, inv);
+        vst1q_u16(dest + i, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b));
+    }
+    for(; i < len; i++) dest[i] = pixel_mix(src[i], dest[i], opa);
+}
+
+static inline void neon_expand(uint16x8_t c, uint8x8_t& r, uint8x8_t& g, uint8x8_t& b)
+{
+    uint16x8_t r5 = vshrq_n_u16(c, 11);
+    uint16x8_t g6 = vandq_u16(vshrq_n_u16(c, 5), vdupq_n_u16(0x3F));
+    uint16x8_t b5 = vandq_u16(c, vdupq_n_u16(0x1F));
+    r             = vmovn_u16(vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(7), r5, 263), 5));
+    g             = vmovn_u16(vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(3), g6, 259), 6));
+    b             = vmovn_u16(vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(7), b5, 263), 5));
+}
+
+static inline uint16x8_t neon_pack(uint8x8_t r, uint8x8_t g, uint8x8_t b)
+{
+    uint16x8_t c = vshlq_n_u16(vmovl_u8(vshr_n_u8(r, 3)), 11);
+    c            = vorrq_u16(c, vshlq_n_u16(vmovl_u8(vshr_n_u8(g, 2)), 5));
+    return vorrq_u16(c, vmovl_u8(vshr_n_u8(b, 3)));
+}
+
+static void neon_to_xrgb8888(uint32_t* dest, const uint16_t* src, uint32_t len)
+{
+    uint32_t i = 0;
+    for(; i + 8 <= len; i += 8) {
+        uint8x8x4_t px;
+        neon_expand(vld1q_u16(src + i), px.val[2], px.val[1], px.val[0]);
+        px.val[3] = vdup_n_u8(0xFF);
+        vst4_u8((uint8_t*)(dest + i), px); // B, G, R, A in memory
+    }
+    scalar_to_xrgb8888(dest + i, src + i, len - i);
+}
+
+static void neon_to_rgb888(uint8_t* dest, const uint16_t* src, uint32_t len)
+{
+    uint32_t i = 0;
+    for(; i + 8 <= len; i += 8) {
+        uint8x8x3_t px;
+        neon_expand(vld1q_u16(src + i), px.val[0], px.val[1], px.val[2]);
+        vst3_u8(dest + i * 3, px);
+    }
+    scalar_to_rgb888(dest + i * 3, src + i, len - i);
+}
+
+static void neon_from_xrgb8888(uint16_t* dest, const uint32_t* src, uint32_t len)
+{
+    uint32_t i = 0;
+    for(; i + 8 <= len; i += 8) {
+        uint8x8x4_t px = vld4_u8((const uint8_t*)(src + i));
+        vst1q_u16(dest + i, neon_pack(px.val[2], px.val[1], px.val[0]));
+    }
+    scalar_from_xrgb8888(dest + i, src + i, len - i);
+}
+
+static void neon_from_rgb888(uint16_t* dest, const uint8_t* src, uint32_t len)
+{
+    uint32_t i = 0;
+    for(; i + 8 <= len; i += 8) {
+        uint8x8x3_t px = vld3_u8(src + i * 3);
+        vst1q_u16(dest + i, neon_pack(px.val[0], px.val[1], px.val[2]));
+    }
+    scalar_from_rgb888(dest + i, src + i * 3, len - i);
+}
+
+static void neon_swap16(uint16_t* dest, const uint16_t* src, uint32_t len)
+{
+    uint32_t i = 0;
+    for(; i + 8 <= len; i += 8) {
+        uint8x16_t c = vreinterpretq_u8_u16(vld1q_u16(src + i));
+        vst1q_u16(dest + i, vreinterpretq_u16_u8(vrev16q_u8(c)));
+    }
+    scalar_swap16(dest + i, src + i, len - i);
+}
+
+const pixel_kernels_t pixel_kernels_native = {
+    "neon",         neon_fill,          neon_blend,       neon_to_xrgb8888,
+    neon_to_rgb888, neon_from_xrgb8888, neon_from_rgb888, neon_swap16,
+};
+
+#elif defined(ARDUINO_ARCH_ESP32)
+/* ===== 32-bit SWAR, 2 pixels or 2 channels per operation =====
+ * The PIE vector instructions of the ESP32-S3 are only reachable through hand written assembly,
+ * these kernels use plain 32-bit words and run on every ESP32 variant. */
+
+static void IRAM_ATTR swar_fill(uint16_t* dest, uint16_t color, uint32_t len)
+{
+    if(len && ((uintptr_t)dest & 2)) {
+        *dest++ = color;
+        len--;
+    }
+    uint32_t c2     = color | ((uint32_t)color << 16);
+    uint32_t* dest2 = (uint32_t*)dest;
+    for(uint32_t i = 0; i < len / 2; i++) dest2[i] = c2;
+    if(len & 1) dest[len - 1] = color;
+}
+
+static void IRAM_ATTR swar_blend(uint16_t* dest, const uint16_t* src, uint32_t len, uint8_t opa)
+{
+    if(opa > PIXEL_OPA_MAX) {
+        memcpy(dest, src, len * sizeof(uint16_t));
+        return;
+    }
+
+    uint32_t inv = 255 - opa;
+    for(uint32_t i = 0; i < len; i++) {
+        uint32_t s = src[i];
+        uint32_t d = dest[i];
+
+        // red in the upper and blue in the lower halfword, both products stay below 16 bits
+        uint32_t rb = ((s & 0xF800) << 5 | (s & 0x1F)) * opa + ((d & 0xF800) << 5 | (d & 0x1F)) * inv + 0x00800080;
+        rb          = ((rb + 0x00010001 + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF; // PIXEL_UDIV255 per halfword
+
+        uint32_t g = ((s >> 5) & 0x3F) * opa + ((d >> 5) & 0x3F) * inv + PIXEL_MIX_ROUND_OFS;
+        g          = (g + 1 + (g >> 8)) >> 8;
+
+        dest[i] = (uint16_t)((rb >> 16) << 11 | g << 5 | (rb & 0x1F));
+    }
+}
+
+static void IRAM_ATTR swar_swap16(uint16_t* dest, const uint16_t* src, uint32_t len)
+{
+    if(((uintptr_t)dest | (uintptr_t)src) & 3) {
+        scalar_swap16(dest, src, len);
+        return;
+    }
+
+    const uint32_t* src2 = (const uint32_t*)src;
+    uint32_t* dest2      = (uint32_t*)dest;
+    for(uint32_t i = 0; i < len / 2; i++) {
+        uint32_t c = src2[i];
+        dest2[i]   = ((c & 0x00FF00FF) << 8) | ((c >> 8) & 0x00FF00FF);
+    }
+    if(len & 1) scalar_swap16(dest + len - 1, src + len - 1, 1);
+}
+
+const pixel_kernels_t pixel_kernels_native = {
+    "swar32",         swar_fill,            swar_blend,         scalar_to_xrgb8888,
+    scalar_to_rgb888, scalar_from_xrgb8888, scalar_from_rgb888, swar_swap16,
+};
+
+#else
+const pixel_kernels_t pixel_kernels_native = pixel_kernels_scalar;
+#endif
+
+const pixel_kernels_t* pixel_kernels = &pixel_kernels_native;
@@ -0,0 +1,42 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_PIXEL_KERNELS_H
+#define HASP_PIXEL_KERNELS_H
+
+#include <stdint.h>
+
+/* Pixel kernels for RGB565 buffers
+ *
+ * Every set produces exactly the same pixels as the LVGL v7 software renderer:
+ * blend uses the rounding of lv_color_mix() and conversions follow lv_color_to32() and lv_color_make().
+ * The scalar set is always available, the native set is the fastest one for the build target:
+ * SSE2 on x86, NEON on ARM and 32-bit SWAR on ESP32. The pixel_kernels pointer selects the active set.
+ *
+ * They are used by the gpu_fill_cb and gpu_blend_cb of the display driver. The SDL monitor_flush and the
+ * fbdev framebuffer writes convert their pixels inside lv_drivers, which is a library dependency and keeps its own loops.
+ */
+typedef struct
+{
+    const char* name;
+    void (*fill)(uint16_t* dest, uint16_t color, uint32_t len);
+    void (*blend)(uint16_t* dest, const uint16_t* src, uint32_t len, uint8_t opa); // dest = src * opa + dest * ~opa
+    void (*to_xrgb8888)(uint32_t* dest, const uint16_t* src, uint32_t len);
+    void (*to_rgb888)(uint8_t* dest, const uint16_t* src, uint32_t len); // bytes in R, G, B order
+    void (*from_xrgb8888)(uint16_t* dest, const uint32_t* src, uint32_t len);
+    void (*from_rgb888)(uint16_t* dest, const uint8_t* src, uint32_t len); // bytes in R, G, B order
+    void (*swap16)(uint16_t* dest, const uint16_t* src, uint32_t len);    // in-place allowed
+} pixel_kernels_t;
+
+/* Fill a w x h rectangle in a buffer that is stride pixels wide */
+static inline void pixel_fill_rect(const pixel_kernels_t* kernels, uint16_t* dest, uint32_t stride, uint32_t w,
+                                   uint32_t h, uint16_t color)
+{
+    for(uint32_t y = 0; y < h; y++, dest += stride) kernels->fill(dest, color, w);
+}
+
+extern const pixel_kernels_t pixel_kernels_scalar;
+extern const pixel_kernels_t pixel_kernels_native;
+extern const pixel_kernels_t* pixel_kernels;
+
+#endif // HASP_PIXEL_KERNELS_H
@@ -225,13 +225,13 @@ void ArduinoGfx::splashscreen()
 {
     uint8_t fg[]       = logoFgColor;
     uint8_t bg[]       = logoBgColor;
-    lv_color_t fgColor = lv_color_make(fg[0], fg[1], fg[2]);
-    lv_color_t bgColor = lv_color_make(bg[0], bg[1], bg[2]);
+    uint16_t fgColor   = tft->color565(fg[0], fg[1], fg[2]); // independent of LV_COLOR_16_SWAP
+    uint16_t bgColor   = tft->color565(bg[0], bg[1], bg[2]);
 
-    tft->fillScreen(bgColor.full);
+    tft->fillScreen(bgColor);
     int x = (tft->width() - logoWidth) / 2;
     int y = (tft->height() - logoHeight) / 2;
-    tft->drawXBitmap(x, y, logoImage, logoWidth, logoHeight, fgColor.full);
+    tft->drawXBitmap(x, y, logoImage, logoWidth, logoHeight, fgColor);
 }
 
 void ArduinoGfx::set_rotation(uint8_t rotation)
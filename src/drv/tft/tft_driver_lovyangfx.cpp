@@ -1168,14 +1168,14 @@ void LovyanGfx::splashscreen()
 {
     uint8_t fg[]       = logoFgColor;
     uint8_t bg[]       = logoBgColor;
-    lv_color_t fgColor = lv_color_make(fg[0], fg[1], fg[2]);
-    lv_color_t bgColor = lv_color_make(bg[0], bg[1], bg[2]);
+    uint16_t fgColor   = tft.color565(fg[0], fg[1], fg[2]); // independent of LV_COLOR_16_SWAP
+    uint16_t bgColor   = tft.color565(bg[0], bg[1], bg[2]);
 
-    tft.fillScreen(bgColor.full);
+    tft.fillScreen(bgColor);
     int x = (tft.width() - logoWidth) / 2;
     int y = (tft.height() - logoHeight) / 2;
-    tft.drawXBitmap(x, y, logoImage, logoWidth, logoHeight, fgColor.full);
-    // tft.fillSmoothRoundRect(x, y, logoWidth, logoWidth, 15, fgColor.full);
+    tft.drawXBitmap(x, y, logoImage, logoWidth, logoHeight, fgColor);
+    // tft.fillSmoothRoundRect(x, y, logoWidth, logoWidth, 15, fgColor);
 }
 
 void LovyanGfx::set_rotation(uint8_t rotation)
@@ -1202,7 +1202,11 @@ void IRAM_ATTR LovyanGfx::flush_pixels(lv_disp_drv_t* disp, const lv_area_t* are
 
     tft.startWrite();                                        /* Start new TFT transaction */
     tft.setAddrWindow(area->x1, area->y1, w, h);             /* set the working window */
+#if LV_COLOR_16_SWAP != 0
+    tft.writePixels((lgfx::swap565_t*)&color_p->full, w * h); /* Already in panel byte order */
+#else
     tft.writePixels((lgfx::rgb565_t*)&color_p->full, w * h); /* Write words at once */
+#endif
     tft.endWrite();                                          /* terminate TFT transaction */
 
     /* Tell lvgl that flushing is done */
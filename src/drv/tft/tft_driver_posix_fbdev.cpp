@@ -16,6 +16,7 @@
 #endif
 
 #include "dev/device.h"
+#include "dev/posix/hasp_posix_sched.h"
 #include "hasp_debug.h"
 #include "hasp_gui.h"
 
@@ -43,23 +44,6 @@ extern uint16_t tft_height;
 
 namespace dev {
 
-/**
- * A task to measure the elapsed time for LittlevGL
- * @param data unused
- * @return never return
- */
-static void* tick_thread(void* data)
-{
-    (void)data;
-
-    while(1) {
-        usleep(5000);   /*Sleep for 5 millisecond*/
-        lv_tick_inc(5); /*Tell LittelvGL that 5 milliseconds were elapsed*/
-    }
-
-    return 0;
-}
-
 int32_t TftFbdevDrv::width()
 {
     return _width;
@@ -76,9 +60,7 @@ static void* gui_entrypoint(void* arg)
     pthread_t gui_pthread;
     pthread_create(&gui_pthread, 0, (void* (*)(void*))gui_task, NULL);
 #endif
-    // create an LVGL tick thread
-    pthread_t tick_pthread;
-    pthread_create(&tick_pthread, 0, tick_thread, NULL);
+    // no tick thread needed, LV_TICK_CUSTOM reads the monotonic clock
     return 0;
 }
 
@@ -122,6 +104,8 @@ void TftFbdevDrv::init(int32_t w, int h)
     tft_width  = _width;
     tft_height = _height;
 
+    posix_sched_init();
+
 #if USE_EVDEV || USE_BSD_EVDEV
     DIR* dir = opendir("/dev/input");
     if(dir == NULL) {
@@ -201,6 +185,8 @@ void TftFbdevDrv::init(int32_t w, int h)
                 printf("Failed to register evdev\n");
                 continue;
             }
+            posix_sched_add_input(indev, dev_path);
+
             evdev_data_t* user_data = (evdev_data_t*)indev->driver.user_data;
             LOG_VERBOSE(TAG_TFT, F("Resolution : X=%d (%d..%d), Y=%d (%d..%d)"), user_data->x_max,
                         user_data->x_absinfo.minimum, user_data->x_absinfo.maximum, user_data->y_max,
@@ -21,58 +21,33 @@
 /**********************
  *      TYPEDEFS
  **********************/
+/* Font file read from the filesystem, or from memory when it is mapped as an asset */
 typedef struct
 {
     lv_fs_file_t* fp;
+    const uint8_t* data; // mapped file, NULL to use fp
+    uint32_t size;
+    uint32_t pos;
+} font_file_t;
+
+typedef struct
+{
+    font_file_t* fp;
     int8_t bit_pos;
     uint8_t byte_value;
 } bit_iterator_t;
 
-typedef struct font_header_bin
-{
-    uint32_t version;
-    uint16_t tables_count;
-    uint16_t font_size;
-    uint16_t ascent;
-    int16_t descent;
-    uint16_t typo_ascent;
-    int16_t typo_descent;
-    uint16_t typo_line_gap;
-    int16_t min_y;
-    int16_t max_y;
-    uint16_t default_advance_width;
-    uint16_t kerning_scale;
-    uint8_t index_to_loc_format;
-    uint8_t glyph_id_format;
-    uint8_t advance_width_format;
-    uint8_t bits_per_pixel;
-    uint8_t xy_bits;
-    uint8_t wh_bits;
-    uint8_t advance_width_bits;
-    uint8_t compression_id;
-    uint8_t subpixels_mode;
-    uint8_t padding;
-    int16_t underline_position;
-    uint16_t underline_thickness;
-} font_header_bin_t;
-
-typedef struct cmap_table_bin
-{
-    uint32_t data_offset;
-    uint32_t range_start;
-    uint16_t range_length;
-    uint16_t glyph_id_start;
-    uint16_t data_entries_count;
-    uint8_t format_type;
-    uint8_t padding;
-} cmap_table_bin_t;
-
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-static bit_iterator_t init_bit_iterator(lv_fs_file_t* fp);
-static bool lvgl_load_font(lv_fs_file_t* fp, lv_font_t* font);
-int32_t load_kern(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uint8_t format, uint32_t start);
+static bit_iterator_t init_bit_iterator(font_file_t* fp);
+static bool lvgl_load_font(font_file_t* fp, lv_font_t* font);
+static bool font_is_lazy(const lv_font_t* font);
+static void font_lazy_free(lv_font_t* font);
+int32_t load_kern(font_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uint8_t format, uint32_t start);
+
+static lv_fs_res_t font_read(font_file_t* fp, void* buf, uint32_t btr);
+static lv_fs_res_t font_seek(font_file_t* fp, uint32_t pos);
 
 static int read_bits_signed(bit_iterator_t* it, int n_bits, lv_fs_res_t* res);
 static unsigned int read_bits(bit_iterator_t* it, int n_bits, lv_fs_res_t* res);
@@ -97,14 +72,33 @@ lv_font_t* hasp_font_load(const char* font_name)
     lv_font_t* font = (lv_font_t*)malloc(sizeof(lv_font_t));
     memset(font, 0, sizeof(lv_font_t));
 
-    lv_fs_file_t file;
-    lv_fs_res_t res = lv_fs_open(&file, font_name, LV_FS_MODE_RD);
+    font_file_t file = {NULL, NULL, 0, 0};
+#if HASP_USE_ASSETS > 0
+    file.data = asset_map(font_name, &file.size);
+#endif
 
-    if(res == LV_FS_RES_OK) {
+    if(file.data) {
         success = lvgl_load_font(&file, font);
-    }
 
-    lv_fs_close(&file);
+#if HASP_USE_ASSETS > 0
+        /* The mapping is kept while the glyph bitmaps are used in place */
+        lv_font_fmt_txt_dsc_t* dsc = (lv_font_fmt_txt_dsc_t*)font->dsc;
+        const uint8_t* bitmap      = dsc ? dsc->glyph_bitmap : NULL;
+        if(bitmap < file.data || bitmap >= file.data + file.size) asset_release(file.data);
+#endif
+
+    } else {
+        lv_fs_file_t fs_file;
+        lv_fs_res_t res = lv_fs_open(&fs_file, font_name, LV_FS_MODE_RD);
+        file.fp         = &fs_file;
+
+        if(res == LV_FS_RES_OK) {
+            success = lvgl_load_font(&file, font);
+        }
+
+        /* A font read on demand keeps a copy of the open file */
+        if(!success || !font_is_lazy(font)) lv_fs_close(&fs_file);
+    }
 
     if(!success) {
         // LOG_WARNING(TAG_FONT, "Error loading font %s", font_name);
@@ -131,6 +125,8 @@ void hasp_font_free(lv_font_t* font)
 
         if(NULL != dsc) {
 
+            if(font_is_lazy(font)) font_lazy_free(font);
+
             if(dsc->kern_classes == 0) {
                 lv_font_fmt_txt_kern_pair_t* kern_dsc = (lv_font_fmt_txt_kern_pair_t*)dsc->kern_dsc;
 
@@ -166,7 +162,10 @@ void hasp_font_free(lv_font_t* font)
             }
 
             if(NULL != dsc->glyph_bitmap) {
-                free((void*)dsc->glyph_bitmap);
+#if HASP_USE_ASSETS > 0
+                if(!asset_release(dsc->glyph_bitmap)) /* not used in place */
+#endif
+                    free((void*)dsc->glyph_bitmap);
             }
             if(NULL != dsc->glyph_dsc) {
                 free((void*)dsc->glyph_dsc);
@@ -181,7 +180,26 @@ void hasp_font_free(lv_font_t* font)
  *   STATIC FUNCTIONS
  **********************/
 
-static bit_iterator_t init_bit_iterator(lv_fs_file_t* fp)
+static lv_fs_res_t font_read(font_file_t* fp, void* buf, uint32_t btr)
+{
+    if(!fp->data) return lv_fs_read(fp->fp, buf, btr, NULL);
+
+    if(fp->pos + btr > fp->size) return LV_FS_RES_UNKNOWN;
+    memcpy(buf, fp->data + fp->pos, btr);
+    fp->pos += btr;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t font_seek(font_file_t* fp, uint32_t pos)
+{
+    if(!fp->data) return LV_FS_SEEK(fp->fp, pos);
+
+    if(pos > fp->size) return LV_FS_RES_UNKNOWN;
+    fp->pos = pos;
+    return LV_FS_RES_OK;
+}
+
+static bit_iterator_t init_bit_iterator(font_file_t* fp)
 {
     bit_iterator_t it;
     it.fp         = fp;
@@ -199,7 +217,7 @@ static unsigned int read_bits(bit_iterator_t* it, int n_bits, lv_fs_res_t* res)
 
         if(it->bit_pos < 0) {
             it->bit_pos = 7;
-            *res        = lv_fs_read(it->fp, &(it->byte_value), 1, NULL);
+            *res        = font_read(it->fp, &(it->byte_value), 1);
             if(*res != LV_FS_RES_OK) {
                 return 0;
             }
@@ -221,14 +239,14 @@ static int read_bits_signed(bit_iterator_t* it, int n_bits, lv_fs_res_t* res)
     return value;
 }
 
-static int read_label(lv_fs_file_t* fp, int start, const char* label)
+static int read_label(font_file_t* fp, int start, const char* label)
 {
-    LV_FS_SEEK(fp, start);
+    font_seek(fp, start);
 
     uint32_t length;
     char buf[4];
 
-    if(lv_fs_read(fp, &length, 4, NULL) != LV_FS_RES_OK || lv_fs_read(fp, buf, 4, NULL) != LV_FS_RES_OK ||
+    if(font_read(fp, &length, 4) != LV_FS_RES_OK || font_read(fp, buf, 4) != LV_FS_RES_OK ||
        memcmp(label, buf, 4) != 0) {
         LOG_WARNING(TAG_FONT, "Error reading '%s' label.", label);
         return -1;
@@ -237,15 +255,15 @@ static int read_label(lv_fs_file_t* fp, int start, const char* label)
     return length;
 }
 
-static bool load_cmaps_tables(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uint32_t cmaps_start,
+static bool load_cmaps_tables(font_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uint32_t cmaps_start,
                               cmap_table_bin_t* cmap_table)
 {
-    if(lv_fs_read(fp, cmap_table, font_dsc->cmap_num * sizeof(cmap_table_bin_t), NULL) != LV_FS_RES_OK) {
+    if(font_read(fp, cmap_table, font_dsc->cmap_num * sizeof(cmap_table_bin_t)) != LV_FS_RES_OK) {
         return false;
     }
 
     for(unsigned int i = 0; i < font_dsc->cmap_num; ++i) {
-        lv_fs_res_t res = LV_FS_SEEK(fp, cmaps_start + cmap_table[i].data_offset);
+        lv_fs_res_t res = font_seek(fp, cmaps_start + cmap_table[i].data_offset);
         if(res != LV_FS_RES_OK) {
             return false;
         }
@@ -264,7 +282,7 @@ static bool load_cmaps_tables(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc,
 
                 cmap->glyph_id_ofs_list = glyph_id_ofs_list;
 
-                if(lv_fs_read(fp, glyph_id_ofs_list, ids_size, NULL) != LV_FS_RES_OK) {
+                if(font_read(fp, glyph_id_ofs_list, ids_size) != LV_FS_RES_OK) {
                     return false;
                 }
 
@@ -281,7 +299,7 @@ static bool load_cmaps_tables(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc,
                 cmap->unicode_list = unicode_list;
                 cmap->list_length  = cmap_table[i].data_entries_count;
 
-                if(lv_fs_read(fp, unicode_list, list_size, NULL) != LV_FS_RES_OK) {
+                if(font_read(fp, unicode_list, list_size) != LV_FS_RES_OK) {
                     return false;
                 }
 
@@ -290,7 +308,7 @@ static bool load_cmaps_tables(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc,
 
                     cmap->glyph_id_ofs_list = buf;
 
-                    if(lv_fs_read(fp, buf, sizeof(uint16_t) * cmap->list_length, NULL) != LV_FS_RES_OK) {
+                    if(font_read(fp, buf, sizeof(uint16_t) * cmap->list_length) != LV_FS_RES_OK) {
                         return false;
                     }
                 }
@@ -304,7 +322,7 @@ static bool load_cmaps_tables(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc,
     return true;
 }
 
-static int32_t load_cmaps(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uint32_t cmaps_start)
+static int32_t load_cmaps(font_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uint32_t cmaps_start)
 {
     int32_t cmaps_length = read_label(fp, cmaps_start, "cmap");
     if(cmaps_length < 0) {
@@ -312,7 +330,7 @@ static int32_t load_cmaps(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uin
     }
 
     uint32_t cmaps_subtables_count;
-    if(lv_fs_read(fp, &cmaps_subtables_count, sizeof(uint32_t), NULL) != LV_FS_RES_OK) {
+    if(font_read(fp, &cmaps_subtables_count, sizeof(uint32_t)) != LV_FS_RES_OK) {
         return -1;
     }
 
@@ -333,7 +351,7 @@ static int32_t load_cmaps(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uin
     return success ? cmaps_length : -1;
 }
 
-static int32_t load_glyph(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uint32_t start, uint32_t* glyph_offset,
+static int32_t load_glyph(font_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uint32_t start, uint32_t* glyph_offset,
                           uint32_t loca_count, font_header_bin_t* header)
 {
     int32_t glyph_length = read_label(fp, start, "glyf");
@@ -350,10 +368,17 @@ static int32_t load_glyph(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uin
 
     int cur_bmp_size = 0;
 
+    /* A mapped file keeps the bitmaps in place when they start on a byte and their index fits */
+    int header_bits = header->advance_width_bits + 2 * header->xy_bits + 2 * header->wh_bits;
+    lv_font_fmt_txt_glyph_dsc_t probe;
+    probe.bitmap_index = glyph_length;
+    bool in_place      = fp->data && header_bits % 8 == 0 && probe.bitmap_index == (uint32_t)glyph_length &&
+                    start + glyph_length <= fp->size;
+
     for(unsigned int i = 0; i < loca_count; ++i) {
         lv_font_fmt_txt_glyph_dsc_t* gdsc = &glyph_dsc[i];
 
-        lv_fs_res_t res = LV_FS_SEEK(fp, start + glyph_offset[i]);
+        lv_fs_res_t res = font_seek(fp, start + glyph_offset[i]);
         if(res != LV_FS_RES_OK) {
             return -1;
         }
@@ -405,12 +430,22 @@ static int32_t load_glyph(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uin
             gdsc->ofs_y = 0;
         }
 
+        if(in_place) {
+            gdsc->bitmap_index = glyph_offset[i] + nbits / 8;
+            continue;
+        }
+
         gdsc->bitmap_index = cur_bmp_size;
         if(gdsc->box_w * gdsc->box_h != 0) {
             cur_bmp_size += bmp_size;
         }
     }
 
+    if(in_place) {
+        font_dsc->glyph_bitmap = fp->data + start;
+        return glyph_length;
+    }
+
     uint8_t* glyph_bmp;
     glyph_bmp = (uint8_t*)hasp_malloc(sizeof(uint8_t) * cur_bmp_size);
 
@@ -419,7 +454,7 @@ static int32_t load_glyph(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uin
     cur_bmp_size = 0;
 
     for(unsigned int i = 1; i < loca_count; ++i) {
-        lv_fs_res_t res = LV_FS_SEEK(fp, start + glyph_offset[i]);
+        lv_fs_res_t res = font_seek(fp, start + glyph_offset[i]);
         if(res != LV_FS_RES_OK) {
             return -1;
         }
@@ -440,7 +475,7 @@ static int32_t load_glyph(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uin
         int bmp_size    = next_offset - glyph_offset[i] - nbits / 8;
 
         if(nbits % 8 == 0) { /* Fast path */
-            if(lv_fs_read(fp, &glyph_bmp[cur_bmp_size], bmp_size, NULL) != LV_FS_RES_OK) {
+            if(font_read(fp, &glyph_bmp[cur_bmp_size], bmp_size) != LV_FS_RES_OK) {
                 return -1;
             }
         } else {
@@ -461,8 +496,371 @@ static int32_t load_glyph(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uin
     return glyph_length;
 }
 
+/**********************
+ *   GLYPHS ON DEMAND
+ **********************/
+
+/* Glyph of a font read on demand, the bitmap follows the entry */
+typedef struct font_glyph_t
+{
+    struct font_glyph_t* prev; /* most recently used first */
+    struct font_glyph_t* next;
+    struct font_glyph_t* chain; /* next entry in the same hash bucket */
+    const lv_font_t* font;
+    uint32_t gid;
+    uint32_t size; /* entry and bitmap */
+    lv_font_fmt_txt_glyph_dsc_t dsc;
+} font_glyph_t;
+
+/* Font with only the cmaps and the loca table in memory, the file stays open */
+typedef struct
+{
+    lv_font_fmt_txt_dsc_t fmt; /* first, the font is still a fmt_txt font for the rest of hasp */
+    lv_fs_file_t file;
+    uint32_t glyph_start;
+    uint32_t* glyph_offset; /* loca_count + 1 entries, the last one is the end of the glyph table */
+    uint32_t loca_count;
+    uint16_t default_advance_width;
+    uint8_t advance_width_format;
+    uint8_t advance_width_bits;
+    uint8_t xy_bits;
+    uint8_t wh_bits;
+} font_lazy_dsc_t;
+
+#define FONT_GLYPH_BUCKETS 64
+
+static font_glyph_t* font_glyph_head;
+static font_glyph_t* font_glyph_tail;
+static font_glyph_t* font_glyph_buckets[FONT_GLYPH_BUCKETS];
+static hasp_font_cache_stats_t font_glyph_stats;
+
+static bool font_lazy_glyph_dsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc_out, uint32_t letter,
+                                uint32_t letter_next);
+static const uint8_t* font_lazy_glyph_bitmap(const lv_font_t* font, uint32_t letter);
+
+static bool font_is_lazy(const lv_font_t* font)
+{
+    return font->get_glyph_dsc == font_lazy_glyph_dsc;
+}
+
+static inline uint8_t font_glyph_bucket(const lv_font_t* font, uint32_t gid)
+{
+    return (((uintptr_t)font >> 4) ^ (gid * 2654435761u)) % FONT_GLYPH_BUCKETS;
+}
+
+static uint32_t font_glyph_budget(void)
+{
+    return hasp_use_psram() ? HASP_FONT_GLYPH_CACHE_SIZE_PSRAM : HASP_FONT_GLYPH_CACHE_SIZE;
+}
+
+static void font_glyph_unlink(font_glyph_t* glyph)
+{
+    if(glyph->prev)
+        glyph->prev->next = glyph->next;
+    else
+        font_glyph_head = glyph->next;
+    if(glyph->next)
+        glyph->next->prev = glyph->prev;
+    else
+        font_glyph_tail = glyph->prev;
+}
+
+static void font_glyph_remove(font_glyph_t* glyph)
+{
+    font_glyph_t** link = &font_glyph_buckets[font_glyph_bucket(glyph->font, glyph->gid)];
+    while(*link != glyph) link = &(*link)->chain;
+    *link = glyph->chain;
+
+    font_glyph_unlink(glyph);
+    font_glyph_stats.used -= glyph->size;
+    font_glyph_stats.glyphs--;
+    hasp_free(glyph);
+}
+
+static font_glyph_t* font_glyph_find(const lv_font_t* font, uint32_t gid)
+{
+    for(font_glyph_t* glyph = font_glyph_buckets[font_glyph_bucket(font, gid)]; glyph; glyph = glyph->chain) {
+        if(glyph->font != font || glyph->gid != gid) continue;
+
+        if(glyph != font_glyph_head) { /* most recently used */
+            font_glyph_unlink(glyph);
+            glyph->prev            = NULL;
+            glyph->next            = font_glyph_head;
+            font_glyph_head->prev  = glyph;
+            font_glyph_head        = glyph;
+        }
+        return glyph;
+    }
+    return NULL;
+}
+
+/* Same lookup as the fmt_txt fonts, without kerning */
+static uint32_t font_lazy_glyph_id(const lv_font_fmt_txt_dsc_t* fdsc, uint32_t letter)
+{
+    if(letter == '\0') return 0;
+
+    for(uint16_t i = 0; i < fdsc->cmap_num; i++) {
+        const lv_font_fmt_txt_cmap_t* cmap = &fdsc->cmaps[i];
+        uint32_t rcp                       = letter - cmap->range_start;
+        if(rcp >= cmap->range_length) continue;
+
+        switch(cmap->type) {
+            case LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY:
+                return cmap->glyph_id_start + rcp;
+            case LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL:
+                return cmap->glyph_id_start + ((const uint8_t*)cmap->glyph_id_ofs_list)[rcp];
+        }
+
+        /* Sparse, the list is sorted */
+        int32_t low  = 0;
+        int32_t high = cmap->list_length - 1;
+        while(low <= high) {
+            int32_t mid = (low + high) / 2;
+            if(cmap->unicode_list[mid] == rcp) {
+                if(cmap->type == LV_FONT_FMT_TXT_CMAP_SPARSE_TINY) return cmap->glyph_id_start + mid;
+                return cmap->glyph_id_start + ((const uint16_t*)cmap->glyph_id_ofs_list)[mid];
+            }
+            if(cmap->unicode_list[mid] < rcp)
+                low = mid + 1;
+            else
+                high = mid - 1;
+        }
+        return 0;
+    }
+    return 0;
+}
+
+/* Decompressed with the lvgl decoder, through a font of only this glyph */
+static const uint8_t* font_lazy_decompress(const lv_font_fmt_txt_dsc_t* fdsc, const lv_font_fmt_txt_glyph_dsc_t* gdsc,
+                                           const uint8_t* bitmap)
+{
+    lv_font_fmt_txt_glyph_dsc_t glyph_dsc[2];
+    memset(glyph_dsc, 0, sizeof(glyph_dsc));
+    glyph_dsc[1]              = *gdsc;
+    glyph_dsc[1].bitmap_index = 0;
+
+    lv_font_fmt_txt_cmap_t cmap;
+    memset(&cmap, 0, sizeof(cmap));
+    cmap.range_start    = 1;
+    cmap.range_length   = 1;
+    cmap.glyph_id_start = 1;
+    cmap.type           = LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY;
+
+    lv_font_fmt_txt_dsc_t dsc;
+    memset(&dsc, 0, sizeof(dsc));
+    dsc.glyph_bitmap  = bitmap;
+    dsc.glyph_dsc     = glyph_dsc;
+    dsc.cmaps         = &cmap;
+    dsc.cmap_num      = 1;
+    dsc.bpp           = fdsc->bpp;
+    dsc.bitmap_format = fdsc->bitmap_format;
+
+    lv_font_t font;
+    memset(&font, 0, sizeof(font));
+    font.dsc = &dsc;
+    return lv_font_get_bitmap_fmt_txt(&font, 1);
+}
+
+static uint32_t font_lazy_bitmap_size(const lv_font_fmt_txt_dsc_t* fdsc, const lv_font_fmt_txt_glyph_dsc_t* gdsc)
+{
+    uint32_t pixels = gdsc->box_w * gdsc->box_h;
+    return fdsc->bpp == 3 ? (pixels + 1) >> 1 : (pixels * fdsc->bpp + 7) >> 3; /* 3 bpp is decompressed to 4 bpp */
+}
+
+/* Read the descriptor and bitmap of a glyph from the file */
+static font_glyph_t* font_lazy_load_glyph(const lv_font_t* font, uint32_t gid)
+{
+    font_lazy_dsc_t* lazy = (font_lazy_dsc_t*)font->dsc;
+    if(gid == 0 || gid >= lazy->loca_count) return NULL;
+
+    uint32_t record_size = lazy->glyph_offset[gid + 1] - lazy->glyph_offset[gid];
+    uint8_t* record      = (uint8_t*)hasp_malloc(record_size + 1);
+    if(!record) return NULL;
+
+    font_glyph_t* glyph = NULL;
+    font_file_t file    = {&lazy->file, NULL, 0, 0};
+    if(font_seek(&file, lazy->glyph_start + lazy->glyph_offset[gid]) != LV_FS_RES_OK ||
+       font_read(&file, record, record_size) != LV_FS_RES_OK) {
+        hasp_free(record);
+        return NULL;
+    }
+
+    /* Parse the record from memory like load_glyph does from the file */
+    font_file_t mem       = {NULL, record, record_size, 0};
+    bit_iterator_t bit_it = init_bit_iterator(&mem);
+    lv_fs_res_t res       = LV_FS_RES_OK;
+    lv_font_fmt_txt_glyph_dsc_t gdsc;
+    memset(&gdsc, 0, sizeof(gdsc));
+
+    gdsc.adv_w = lazy->advance_width_bits == 0 ? lazy->default_advance_width
+                                                : read_bits(&bit_it, lazy->advance_width_bits, &res);
+    if(lazy->advance_width_format == 0) gdsc.adv_w *= 16;
+    gdsc.ofs_x = read_bits_signed(&bit_it, lazy->xy_bits, &res);
+    gdsc.ofs_y = read_bits_signed(&bit_it, lazy->xy_bits, &res);
+    gdsc.box_w = read_bits(&bit_it, lazy->wh_bits, &res);
+    gdsc.box_h = read_bits(&bit_it, lazy->wh_bits, &res);
+
+    int nbits    = lazy->advance_width_bits + 2 * lazy->xy_bits + 2 * lazy->wh_bits;
+    int bmp_size = record_size - nbits / 8;
+    if(res != LV_FS_RES_OK || bmp_size < 0) {
+        hasp_free(record);
+        return NULL;
+    }
+
+    /* Bitmap as it is stored, shifted to the start of a byte */
+    uint8_t* bitmap = record + nbits / 8;
+    if(nbits % 8 != 0 && bmp_size > 0) {
+        for(int k = 0; k < bmp_size - 1; ++k) bitmap[k] = read_bits(&bit_it, 8, &res);
+        bitmap[bmp_size - 1] = read_bits(&bit_it, 8 - nbits % 8, &res);
+    }
+
+    const uint8_t* plain = bitmap;
+    uint32_t plain_size  = bmp_size;
+    if(gdsc.box_w * gdsc.box_h == 0) {
+        plain_size = 0;
+    } else if(lazy->fmt.bitmap_format != LV_FONT_FMT_TXT_PLAIN) {
+        plain      = font_lazy_decompress(&lazy->fmt, &gdsc, bitmap);
+        plain_size = font_lazy_bitmap_size(&lazy->fmt, &gdsc);
+    }
+
+    if(plain) glyph = (font_glyph_t*)hasp_malloc(sizeof(font_glyph_t) + plain_size);
+    if(glyph) {
+        glyph->font = font;
+        glyph->gid  = gid;
+        glyph->size = sizeof(font_glyph_t) + plain_size;
+        glyph->dsc  = gdsc;
+        memcpy(glyph + 1, plain, plain_size);
+    }
+
+    hasp_free(record);
+    return glyph;
+}
+
+/* Cached glyph, read from the file and the least recently used ones dropped when it is not */
+static font_glyph_t* font_lazy_get_glyph(const lv_font_t* font, uint32_t letter)
+{
+    if(letter == '\t') letter = ' ';
+
+    uint32_t gid = font_lazy_glyph_id((const lv_font_fmt_txt_dsc_t*)font->dsc, letter);
+    if(gid == 0) return NULL;
+
+    font_glyph_t* glyph = font_glyph_find(font, gid);
+    if(glyph) {
+        font_glyph_stats.hits++;
+        return glyph;
+    }
+
+    glyph = font_lazy_load_glyph(font, gid);
+    if(!glyph) return NULL;
+    font_glyph_stats.misses++;
+
+    /* Keep at least the new glyph, lvgl draws it before asking for the next one */
+    uint32_t budget = font_glyph_budget();
+    while(font_glyph_tail && font_glyph_stats.used + glyph->size > budget) {
+        font_glyph_remove(font_glyph_tail);
+        font_glyph_stats.evictions++;
+    }
+
+    uint8_t bucket             = font_glyph_bucket(font, gid);
+    glyph->chain               = font_glyph_buckets[bucket];
+    font_glyph_buckets[bucket] = glyph;
+    glyph->prev                = NULL;
+    glyph->next                = font_glyph_head;
+    if(font_glyph_head)
+        font_glyph_head->prev = glyph;
+    else
+        font_glyph_tail = glyph;
+    font_glyph_head = glyph;
+
+    font_glyph_stats.used += glyph->size;
+    font_glyph_stats.glyphs++;
+    return glyph;
+}
+
+static bool font_lazy_glyph_dsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc_out, uint32_t letter,
+                                uint32_t letter_next)
+{
+    font_glyph_t* glyph = font_lazy_get_glyph(font, letter);
+    if(!glyph) return false;
+
+    const lv_font_fmt_txt_glyph_dsc_t* gdsc = &glyph->dsc;
+    uint32_t adv_w                          = gdsc->adv_w;
+    if(letter == '\t') adv_w *= 2;
+
+    dsc_out->adv_w = (adv_w + (1 << 3)) >> 4;
+    dsc_out->box_h = gdsc->box_h;
+    dsc_out->box_w = letter == '\t' ? gdsc->box_w * 2 : gdsc->box_w;
+    dsc_out->ofs_x = gdsc->ofs_x;
+    dsc_out->ofs_y = gdsc->ofs_y;
+    dsc_out->bpp   = (uint8_t)((const lv_font_fmt_txt_dsc_t*)font->dsc)->bpp;
+    return true;
+}
+
+static const uint8_t* font_lazy_glyph_bitmap(const lv_font_t* font, uint32_t letter)
+{
+    font_glyph_t* glyph = font_lazy_get_glyph(font, letter);
+    return glyph ? (const uint8_t*)(glyph + 1) : NULL;
+}
+
+/* Switch a font to reading its glyphs on demand, the file stays open until the font is freed */
+static bool font_lazy_begin(font_file_t* fp, lv_font_t* font, const font_header_bin_t* header, uint32_t glyph_start,
+                            uint32_t* glyph_offset, uint32_t loca_count)
+{
+    int32_t glyph_length = read_label(fp, glyph_start, "glyf");
+    if(glyph_length < 0) return false;
+
+    font_lazy_dsc_t* lazy = (font_lazy_dsc_t*)malloc(sizeof(font_lazy_dsc_t));
+    if(!lazy) return false;
+
+    memset(lazy, 0, sizeof(font_lazy_dsc_t));
+    memcpy(&lazy->fmt, font->dsc, sizeof(lv_font_fmt_txt_dsc_t));
+    lazy->fmt.kern_scale = 0; /* kerning is not loaded */
+    free(font->dsc);
+    font->dsc = lazy;
+
+    glyph_offset[loca_count]    = glyph_length;
+    lazy->file                  = *fp->fp;
+    lazy->glyph_start           = glyph_start;
+    lazy->glyph_offset          = glyph_offset;
+    lazy->loca_count            = loca_count;
+    lazy->default_advance_width = header->default_advance_width;
+    lazy->advance_width_format  = header->advance_width_format;
+    lazy->advance_width_bits    = header->advance_width_bits;
+    lazy->xy_bits               = header->xy_bits;
+    lazy->wh_bits               = header->wh_bits;
+
+    font->get_glyph_dsc    = font_lazy_glyph_dsc;
+    font->get_glyph_bitmap = font_lazy_glyph_bitmap;
+    font_glyph_stats.fonts++;
+    return true;
+}
+
+static void font_lazy_free(lv_font_t* font)
+{
+    font_lazy_dsc_t* lazy = (font_lazy_dsc_t*)font->dsc;
+
+    for(uint8_t bucket = 0; bucket < FONT_GLYPH_BUCKETS; bucket++) {
+        font_glyph_t* glyph = font_glyph_buckets[bucket];
+        while(glyph) {
+            font_glyph_t* chain = glyph->chain;
+            if(glyph->font == font) font_glyph_remove(glyph);
+            glyph = chain;
+        }
+    }
+
+    lv_fs_close(&lazy->file);
+    free(lazy->glyph_offset);
+    font_glyph_stats.fonts--;
+}
+
+void hasp_font_cache_stats(hasp_font_cache_stats_t* stats)
+{
+    *stats        = font_glyph_stats;
+    stats->budget = font_glyph_budget();
+}
+
 /*
- * Loads a `lv_font_t` from a binary file, given a `lv_fs_file_t`.
+ * Loads a `lv_font_t` from a binary file, given a `font_file_t`.
  *
  * Memory allocations on `lvgl_load_font` should be immediately zeroed and
  * the pointer should be set on the `lv_font_t` data before any possible return.
@@ -473,7 +871,7 @@ static int32_t load_glyph(lv_fs_file_t* fp, lv_font_fmt_txt_dsc_t* font_dsc, uin
  * `lv_font_free` will assume that all non-null pointers are allocated and
  * should be freed.
  */
-static bool lvgl_load_font(lv_fs_file_t* fp, lv_font_t* font)
+static bool lvgl_load_font(font_file_t* fp, lv_font_t* font)
 {
     lv_font_fmt_txt_dsc_t* font_dsc = (lv_font_fmt_txt_dsc_t*)malloc(sizeof(lv_font_fmt_txt_dsc_t));
 
@@ -488,7 +886,7 @@ static bool lvgl_load_font(lv_fs_file_t* fp, lv_font_t* font)
     }
 
     font_header_bin_t font_header;
-    if(lv_fs_read(fp, &font_header, sizeof(font_header_bin_t), NULL) != LV_FS_RES_OK) {
+    if(font_read(fp, &font_header, sizeof(font_header_bin_t)) != LV_FS_RES_OK) {
         return false;
     }
 
@@ -519,7 +917,7 @@ static bool lvgl_load_font(lv_fs_file_t* fp, lv_font_t* font)
     }
 
     uint32_t loca_count;
-    if(lv_fs_read(fp, &loca_count, sizeof(uint32_t), NULL) != LV_FS_RES_OK) {
+    if(font_read(fp, &loca_count, sizeof(uint32_t)) != LV_FS_RES_OK) {
         return false;
     }
 
@@ -531,14 +929,14 @@ static bool lvgl_load_font(lv_fs_file_t* fp, lv_font_t* font)
     if(font_header.index_to_loc_format == 0) {
         for(unsigned int i = 0; i < loca_count; ++i) {
             uint16_t offset;
-            if(lv_fs_read(fp, &offset, sizeof(uint16_t), NULL) != LV_FS_RES_OK) {
+            if(font_read(fp, &offset, sizeof(uint16_t)) != LV_FS_RES_OK) {
                 failed = true;
                 break;
             }
             glyph_offset[i] = offset;
         }
     } else if(font_header.index_to_loc_format == 1) {
-        if(lv_fs_read(fp, glyph_offset, loca_count * sizeof(uint32_t), NULL) != LV_FS_RES_OK) {
+        if(font_read(fp, glyph_offset, loca_count * sizeof(uint32_t)) != LV_FS_RES_OK) {
             failed = true;
         }
     } else {
@@ -553,6 +951,16 @@ static bool lvgl_load_font(lv_fs_file_t* fp, lv_font_t* font)
 
     /* glyph */
     uint32_t glyph_start = loca_start + loca_length;
+
+    /* A large font file stays open and only the glyphs in use are read */
+    if(!fp->data && loca_count > 1 && glyph_offset[loca_count - 1] > HASP_FONT_LAZY_SIZE) {
+        if(!font_lazy_begin(fp, font, &font_header, glyph_start, glyph_offset, loca_count)) {
+            free(glyph_offset);
+            return false;
+        }
+        return true;
+    }
+
     int32_t glyph_length = load_glyph(fp, font_dsc, glyph_start, glyph_offset, loca_count, &font_header);
 
     free(glyph_offset);
@@ -17,10 +17,70 @@ extern "C" {
 /*********************
  *      DEFINES
  *********************/
+#ifndef HASP_FONT_LAZY_SIZE
+#define HASP_FONT_LAZY_SIZE (64 * 1024) /* fonts with more glyph data are read from the file on demand */
+#endif
+#ifndef HASP_FONT_GLYPH_CACHE_SIZE
+#define HASP_FONT_GLYPH_CACHE_SIZE (16 * 1024) /* glyphs of those fonts kept in internal ram */
+#endif
+#ifndef HASP_FONT_GLYPH_CACHE_SIZE_PSRAM
+#define HASP_FONT_GLYPH_CACHE_SIZE_PSRAM (256 * 1024) /* glyphs kept in psram */
+#endif
 
 /**********************
  *      TYPEDEFS
  **********************/
+/* Header of the "head" table of a binary font, after its length and label */
+typedef struct font_header_bin
+{
+    uint32_t version;
+    uint16_t tables_count;
+    uint16_t font_size;
+    uint16_t ascent;
+    int16_t descent;
+    uint16_t typo_ascent;
+    int16_t typo_descent;
+    uint16_t typo_line_gap;
+    int16_t min_y;
+    int16_t max_y;
+    uint16_t default_advance_width;
+    uint16_t kerning_scale;
+    uint8_t index_to_loc_format;
+    uint8_t glyph_id_format;
+    uint8_t advance_width_format;
+    uint8_t bits_per_pixel;
+    uint8_t xy_bits;
+    uint8_t wh_bits;
+    uint8_t advance_width_bits;
+    uint8_t compression_id;
+    uint8_t subpixels_mode;
+    uint8_t padding;
+    int16_t underline_position;
+    uint16_t underline_thickness;
+} font_header_bin_t;
+
+/* Subtable in the "cmap" table, data_offset is from the start of the table */
+typedef struct cmap_table_bin
+{
+    uint32_t data_offset;
+    uint32_t range_start;
+    uint16_t range_length;
+    uint16_t glyph_id_start;
+    uint16_t data_entries_count;
+    uint8_t format_type;
+    uint8_t padding;
+} cmap_table_bin_t;
+
+typedef struct
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t used; /* bytes of the cached glyphs */
+    uint32_t budget;
+    uint16_t glyphs;
+    uint16_t fonts; /* fonts read on demand */
+} hasp_font_cache_stats_t;
 
 /**********************
  * GLOBAL PROTOTYPES
@@ -30,6 +90,7 @@ extern "C" {
 
 lv_font_t * hasp_font_load(const char * fontName);
 void hasp_font_free(lv_font_t * font);
+void hasp_font_cache_stats(hasp_font_cache_stats_t * stats);
 
 #endif
 
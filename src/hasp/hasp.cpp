@@ -138,6 +138,8 @@ HASP_ATTRIBUTE_FAST_MEM void hasp_update_sleep_state()
             dispatch_run_script(NULL, "L:/idle_off.cmd", TAG_HASP);
         }
     }
+
+    gui_set_refresh_level(hasp_sleep_state);
 }
 
 void hasp_set_sleep_offset(uint32_t offset)
@@ -202,7 +204,10 @@ bool hasp_stop_antiburn()
 
     if(antiburn_task) {
         lv_task_del(antiburn_task);
-        lv_obj_invalidate(lv_scr_act());
+#if HASP_USE_SHADOW_FB > 0
+        if(!gui_shadow_fb_restore()) // redraw the last contents instead of rendering again
+#endif
+            lv_obj_invalidate(lv_scr_act());
         changed = true;
     }
     antiburn_task = NULL;
@@ -776,6 +781,21 @@ void hasp_get_info(JsonDocument& doc)
     info[F(D_INFO_FREE_MEMORY)]   = size_buf;
     info[F(D_INFO_FRAGMENTATION)] = std::to_string(mem_mon.frag_pct) + "%";
 #endif
+
+    gui_get_info(doc);
+    font_get_info(doc);
+
+#if HASP_USE_IMAGE_CACHE > 0
+    image_cache_get_info(doc);
+#endif
+
+#if HASP_USE_IMAGE_STREAM > 0
+    image_stream_get_info(doc);
+#endif
+
+#if HASP_USE_ASSETS > 0
+    asset_get_info(doc);
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
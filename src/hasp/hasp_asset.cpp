@@ -0,0 +1,245 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if HASP_USE_ASSETS > 0
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "esp_partition.h"
+#elif !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "hasp_debug.h"
+
+#ifndef LV_FS_PC_PATH
+#define LV_FS_PC_PATH "./" // root of the L: drive, see lv_fs_pc.c
+#endif
+
+#if !defined(WIN32)
+/* Start of the partition, followed by the index sorted by name and the 4 byte aligned files */
+typedef struct
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t count; // files in the index
+    uint32_t size;  // bytes used of the partition
+} asset_header_t;
+
+typedef struct
+{
+    char name[ASSET_NAME_SIZE];
+    uint32_t offset; // from the start of the partition
+    uint32_t size;
+} asset_entry_t;
+
+#if defined(ARDUINO_ARCH_ESP32)
+static spi_flash_mmap_handle_t asset_handle;
+#endif
+static const uint8_t* asset_base;
+static const asset_header_t* asset_header;
+static const asset_entry_t* asset_index;
+static uint32_t asset_partition_size;
+
+static bool asset_header_valid(const asset_header_t* header, uint32_t partition_size)
+{
+    return !memcmp(header->magic, ASSET_MAGIC, sizeof(header->magic)) && header->version == ASSET_VERSION &&
+           header->size <= partition_size && sizeof(*header) + header->count * sizeof(asset_entry_t) <= header->size;
+}
+
+/* Path as it is stored in the index: without the L: drive, starting with a slash */
+static bool asset_name(const char* path, char* name, size_t size)
+{
+    if(path[0] != '\0' && path[1] == ':') {
+        if(path[0] != 'L') return false; // files of other drives are not in the partition
+        path += 2;
+    }
+
+    size_t len = 0;
+    if(*path != '/' && *path != '\\') name[len++] = '/';
+    for(; *path; path++) {
+        if(len + 1 >= size) return false;
+        name[len++] = *path == '\\' ? '/' : *path;
+    }
+    name[len] = '\0';
+    return true;
+}
+#endif
+
+const uint8_t* asset_map(const char* path, uint32_t* size)
+{
+#if !defined(WIN32)
+    char name[ASSET_NAME_SIZE];
+    if(!path || !asset_index || !asset_name(path, name, sizeof(name))) return NULL;
+
+    int32_t low  = 0;
+    int32_t high = asset_header->count - 1;
+    while(low <= high) {
+        int32_t mid = (low + high) / 2;
+        int cmp     = strncmp(name, asset_index[mid].name, sizeof(name));
+        if(cmp == 0) {
+            *size = asset_index[mid].size;
+            return asset_base + asset_index[mid].offset;
+        }
+        if(cmp < 0)
+            high = mid - 1;
+        else
+            low = mid + 1;
+    }
+#endif
+    return NULL;
+}
+
+bool asset_contains(const void* data)
+{
+#if !defined(WIN32)
+    const uint8_t* ptr = (const uint8_t*)data;
+    return ptr && asset_base && ptr >= asset_base && ptr < asset_base + asset_header->size;
+#else
+    return false;
+#endif
+}
+
+bool asset_release(const void* data)
+{
+    return asset_contains(data); // the partition stays mapped
+}
+
+/* ===== LVGL Decoder ===== */
+
+/* Uncompressed true color .bin file, a png or jpg src is shown from the .bin converted next to it */
+static const uint8_t* asset_image(const void* src, lv_img_header_t* header)
+{
+    if(lv_img_src_get_type(src) != LV_IMG_SRC_FILE) return NULL;
+
+    const char* path = (const char*)src;
+    const char* ext  = strrchr(path, '.');
+    if(!ext) return NULL;
+
+    char native[ASSET_NAME_SIZE + 4];
+    uint32_t size       = 0;
+    const uint8_t* data = NULL;
+    if(strcasecmp(ext, ".bin")) {
+        if(snprintf_P(native, sizeof(native), PSTR("%s.bin"), path) >= (int)sizeof(native)) return NULL;
+        data = asset_map(native, &size);
+    } else {
+        data = asset_map(path, &size);
+    }
+    if(!data) return NULL;
+
+    memcpy(header, data, sizeof(lv_img_header_t));
+    bool in_place = header->always_zero == 0 && header->reserved == 0 &&
+                    header->cf >= LV_IMG_CF_TRUE_COLOR && header->cf <= LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED &&
+                    size >= sizeof(lv_img_header_t) + lv_img_buf_get_img_size(header->w, header->h, header->cf);
+    if(in_place) return data;
+
+    asset_release(data); // compressed or indexed, left to the other decoders
+    return NULL;
+}
+
+static lv_res_t asset_decoder_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+    const uint8_t* data = asset_image(src, header);
+    if(!data) return LV_RES_INV;
+
+    asset_release(data);
+    return LV_RES_OK;
+}
+
+static lv_res_t asset_decoder_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    const uint8_t* data = asset_image(dsc->src, &dsc->header);
+    if(!data) return LV_RES_INV;
+
+    dsc->img_data = data + sizeof(lv_img_header_t);
+    return LV_RES_OK;
+}
+
+static void asset_decoder_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    asset_release(dsc->img_data);
+    dsc->img_data = NULL;
+}
+
+void asset_init(void)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, ASSET_PARTITION_LABEL);
+    if(!partition) return;
+
+    asset_header_t header;
+    if(esp_partition_read(partition, 0, &header, sizeof(header)) != ESP_OK ||
+       !asset_header_valid(&header, partition->size)) {
+        LOG_WARNING(TAG_FILE, F("Partition %s is empty"), ASSET_PARTITION_LABEL);
+        return;
+    }
+
+    const void* base;
+    if(esp_partition_mmap(partition, 0, header.size, SPI_FLASH_MMAP_DATA, &base, &asset_handle) != ESP_OK) {
+        LOG_ERROR(TAG_FILE, F("Mapping %s failed"), ASSET_PARTITION_LABEL);
+        return;
+    }
+    asset_partition_size = partition->size;
+
+#elif !defined(WIN32)
+    int fd = open(LV_FS_PC_PATH ASSET_PARTITION_FILE, O_RDONLY);
+    if(fd < 0) return;
+
+    struct stat st;
+    asset_header_t header;
+    if(fstat(fd, &st) != 0 || read(fd, &header, sizeof(header)) != sizeof(header) ||
+       !asset_header_valid(&header, st.st_size)) {
+        LOG_WARNING(TAG_FILE, F("Partition %s is empty"), ASSET_PARTITION_FILE);
+        close(fd);
+        return;
+    }
+
+    void* base = mmap(NULL, header.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if(base == MAP_FAILED) {
+        LOG_ERROR(TAG_FILE, F("Mapping %s failed"), ASSET_PARTITION_FILE);
+        return;
+    }
+    asset_partition_size = st.st_size;
+#endif
+
+#if !defined(WIN32)
+    asset_base   = (const uint8_t*)base;
+    asset_header = (const asset_header_t*)base;
+    asset_index  = (const asset_entry_t*)(asset_base + sizeof(asset_header_t));
+    LOG_INFO(TAG_FILE, F("Mapped %u assets, %u bytes"), header.count, header.size);
+#endif
+
+    // Created after the image cache, mapped pixels are not cached
+    lv_img_decoder_t* decoder = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(decoder, asset_decoder_info);
+    lv_img_decoder_set_open_cb(decoder, asset_decoder_open);
+    lv_img_decoder_set_close_cb(decoder, asset_decoder_close);
+}
+
+void asset_get_info(JsonDocument& doc)
+{
+    char size_buf[32];
+    char total_buf[16];
+    JsonObject info = doc.createNestedObject(F("Assets"));
+
+#if !defined(WIN32)
+    if(!asset_header) {
+        info[F("Partition")] = F(D_SETTING_DISABLED);
+        return;
+    }
+    info[F("Files")] = asset_header->count;
+    Parser::format_bytes(asset_header->size, size_buf, sizeof(size_buf));
+    Parser::format_bytes(asset_partition_size, total_buf, sizeof(total_buf));
+    strncat(size_buf, " / ", sizeof(size_buf) - strlen(size_buf) - 1);
+    strncat(size_buf, total_buf, sizeof(size_buf) - strlen(size_buf) - 1);
+    info[F("Partition")] = size_buf;
+#endif
+}
+
+#endif
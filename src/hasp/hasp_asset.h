@@ -0,0 +1,44 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_ASSET_H
+#define HASP_ASSET_H
+
+#if HASP_USE_ASSETS > 0
+
+/* Read-only files used in place, without copying them into the heap
+ *
+ * On ESP32 the files are packed into the "assets" data partition by tools/hasp_assets_build.py, which also converts
+ * png and jpg images to .bin. The partition is mapped into the address space once at boot, a file is found by its
+ * path on the L: drive and is looked up there before the filesystem. Flash the image with
+ *   parttool.py write_partition --partition-name assets --input assets.bin
+ * On Linux the same image is read from ASSET_PARTITION_FILE in the root of the L: drive and mapped once at boot.
+ *
+ * Uncompressed true color .bin images, also the .bin next to a png or jpg src, are drawn from the mapped pixels
+ * and font files keep their glyph bitmaps there.
+ */
+
+#ifndef ASSET_PARTITION_LABEL
+#define ASSET_PARTITION_LABEL "assets"
+#endif
+#ifndef ASSET_PARTITION_FILE
+#define ASSET_PARTITION_FILE "assets.bin"
+#endif
+
+#define ASSET_MAGIC "HAST"
+#define ASSET_VERSION 1
+#define ASSET_NAME_SIZE 56 // path in the partition index, including the terminating zero
+
+/* ===== Default Event Processors ===== */
+void asset_init(void); // map the partition and add the decoder of the .bin images in it
+
+/* ===== Special Event Processors ===== */
+const uint8_t* asset_map(const char* path, uint32_t* size); // NULL if the file is not mapped, path may have a drive
+bool asset_release(const void* data); // false if data is not in a mapped file
+
+/* ===== Getter and Setter Functions ===== */
+bool asset_contains(const void* data);
+void asset_get_info(JsonDocument& doc);
+
+#endif
+#endif
@@ -4,22 +4,10 @@
 #include "hasplib.h"
 #include "hasp_attribute_helper.h"
 
-/*** Image Improvement ***/
-#if defined(ARDUINO_ARCH_ESP32)
-#include <HTTPClient.h>
-#endif
-
-#if HASP_USE_PNGDECODE > 0
-#include "lv_png.h"
-#include "lodepng.h"
-#endif
-/*** Image Improvement ***/
-
 #if HASP_USE_QRCODE > 0
 #include "lv_qrcode.h"
 #endif
 
-LV_FONT_DECLARE(unscii_8_icon);
 extern const char** btnmatrix_default_map; // memory pointer to lvgl default btnmatrix map
 extern const char* msgbox_default_map[];   // memory pointer to lvgl default btnmatrix map
 
@@ -30,13 +18,23 @@ void my_image_release_resources(lv_obj_t* obj)
 {
     if(!obj) return;
 
+#if HASP_USE_IMAGE_FETCH > 0
+    image_fetch_cancel(obj); // a newer src or the object was deleted
+#endif
+
     const void* src       = lv_img_get_src(obj);
     lv_img_src_t src_type = lv_img_src_get_type(src);
 
     switch(src_type) {
         case LV_IMG_SRC_VARIABLE: {
             lv_img_set_src(obj, LV_SYMBOL_DUMMY); // empty symbol to clear the image
-            lv_img_cache_invalidate_src(src);     // remove src from image cache
+#if HASP_USE_IMAGE_CACHE > 0
+            if(!image_cache_release_src((const lv_img_dsc_t*)src)) break; // still shown by other objects
+            lv_img_cache_invalidate_src(src);                            // remove src from image cache
+            image_cache_invalidate(src);                                 // close the decoded pixels
+#else
+            lv_img_cache_invalidate_src(src); // remove src from image cache
+#endif
 
             lv_img_dsc_t* img_dsc = (lv_img_dsc_t*)src;
             hasp_free((uint8_t*)img_dsc->data); // free image data
@@ -53,6 +51,21 @@ void my_image_release_resources(lv_obj_t* obj)
     }
 }
 
+/* Show the image another object loaded from the same url, returns false when it must be loaded */
+static bool my_image_share_src(lv_obj_t* obj, const char* url)
+{
+#if HASP_USE_IMAGE_CACHE > 0
+    lv_img_dsc_t* img_dsc = image_cache_get_src(url, lv_img_get_src(obj));
+    if(!img_dsc) return false;
+
+    my_image_release_resources(obj);
+    lv_img_set_src(obj, img_dsc);
+    return true;
+#else
+    return false;
+#endif
+}
+
 void my_btnmatrix_map_clear(lv_obj_t* obj)
 {
     lv_btnmatrix_ext_t* ext = (lv_btnmatrix_ext_t*)lv_obj_get_ext_attr(obj);
@@ -236,45 +249,6 @@ static bool my_line_set_points(lv_obj_t* obj, const char* payload)
     return true;
 }
 
-static lv_font_t* haspPayloadToFont(const char* payload)
-{
-    if(Parser::is_only_digits(payload)) {
-        uint8_t var = atoi(payload);
-
-        if(var >= 0 && var < 8)
-            return hasp_get_font(var);
-        else if(var == 8)
-            return &unscii_8_icon;
-
-#if !defined(ARDUINO_ARCH_ESP8266) // && (HASP_USE_FREETYPE == 0)
-
-#if defined(HASP_FONT_1) && defined(HASP_FONT_1)
-        else if(var == HASP_FONT_SIZE_1)
-            return &HASP_FONT_1;
-#endif
-#if defined(HASP_FONT_2) && defined(HASP_FONT_2)
-        else if(var == HASP_FONT_SIZE_2)
-            return &HASP_FONT_2;
-#endif
-#if defined(HASP_FONT_3) && defined(HASP_FONT_3)
-        else if(var == HASP_FONT_SIZE_3)
-            return &HASP_FONT_3;
-#endif
-#if defined(HASP_FONT_4) && defined(HASP_FONT_4)
-        else if(var == HASP_FONT_SIZE_4)
-            return &HASP_FONT_4;
-#endif
-#if defined(HASP_FONT_5) && defined(HASP_FONT_5)
-        else if(var == HASP_FONT_SIZE_5)
-            return &HASP_FONT_5;
-#endif
-
-#endif
-    }
-
-    return get_font(payload);
-}
-
 static hasp_attribute_type_t hasp_process_label_long_mode(lv_obj_t* obj, const char* payload, char** text, bool update)
 {
     const char* arr[] = {PSTR("expand"), PSTR("break"), PSTR("dots"), PSTR("scroll"), PSTR("loop"), PSTR("crop")};
@@ -878,9 +852,10 @@ static hasp_attribute_type_t hasp_local_style_attr(lv_obj_t* obj, const char* at
             return HASP_ATTR_TYPE_METHOD_OK;
         }
         case ATTR_TEXT_FONT: {
-            lv_font_t* font = haspPayloadToFont(payload);
+            lv_font_t* font = get_font(payload);
             if(font) {
                 LOG_DEBUG(TAG_ATTR, "%s %d %x", __FILE__, __LINE__, font);
+                my_obj_retain_font(obj, font);
                 uint8_t count = 3;
                 if(obj_check_type(obj, LV_HASP_ROLLER)) count = my_roller_get_visible_row_count(obj);
                 lv_obj_set_style_local_text_font(obj, part, state, font);
@@ -1021,8 +996,9 @@ static hasp_attribute_type_t hasp_local_style_attr(lv_obj_t* obj, const char* at
             return HASP_ATTR_TYPE_METHOD_OK;
         }
         case ATTR_VALUE_FONT: {
-            lv_font_t* font = haspPayloadToFont(payload);
+            lv_font_t* font = get_font(payload);
             if(font) {
+                my_obj_retain_font(obj, font);
                 lv_obj_set_style_local_value_font(obj, part, state, font);
             } else {
                 LOG_WARNING(TAG_ATTR, F("Unknown Font ID %s"), attr_p);
@@ -1324,7 +1300,6 @@ static inline bool do_attribute(T& list, lv_obj_t* obj, uint16_t attr_hash, int3
 
 static hasp_attribute_type_t special_attribute_src(lv_obj_t* obj, const char* payload, char** text, bool update)
 {
-    LOG_ERROR(TAG_ATTR, "PAYLOAD %s", payload);
     if(!obj_check_type(obj, LV_HASP_IMAGE)) return HASP_ATTR_TYPE_NOT_FOUND;
 
     if(update) {
@@ -1334,110 +1309,10 @@ static hasp_attribute_type_t special_attribute_src(lv_obj_t* obj, const char* pa
             if(payload == strstr_P(payload, PSTR("L:"))) { // startsWith command/
                 my_image_release_resources(obj);
                 lv_img_set_src(obj, payload);
-            } else if (payload == strstr_P(payload, PSTR("Z:"))) { 
-              // if (HASP_SD_FS.exists("/b.png"))
-                char tempsrcf[64] = "";
-                strncpy(tempsrcf , payload + 2, sizeof(tempsrcf));
-                LOG_ERROR(TAG_ATTR, "PAYLOAD DENTRO %s", tempsrcf);
-
-
-               int readf = 0;
-               File file;
-               file = HASP_SD_FS.open(tempsrcf, "r");
-    
-
-               int buf_lenf = file.size();
-               LOG_ERROR(TAG_ATTR, "size %d", buf_lenf);
-
-               int dsc_lenf = sizeof(lv_img_dsc_t);
-               lv_img_dsc_t* img_dscf = (lv_img_dsc_t*)lv_mem_alloc(dsc_lenf); 
-               uint8_t* img_buf_startf = (uint8_t*)(buf_lenf > 0 ? hasp_malloc(buf_lenf) : NULL);
-               uint8_t* img_buf_posf   = img_buf_startf;
-
-
-               // Initialize the buffers
-               memset(img_buf_startf, 0, buf_lenf);           // empty data buffer
-               memset(img_dscf, 0, dsc_lenf);                 // empty img descriptor + url
-               img_dscf->data               = img_buf_startf; // store pointer to the start of the data buffer
-               if(!img_buf_startf) {
-                    lv_mem_free(img_dscf); // destroy header too
-                    LOG_ERROR(TAG_ATTR, "img buffer creation failed %d", buf_lenf);
-                    return HASP_ATTR_TYPE_STR;
-                }
-                // Read image header
-                readf                      = 0;
-                const uint8_t png_magic[] = {0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a};
-                if(file.available() >= 8) {
-                    int c = file.readBytes((char *)img_buf_posf, 8); // don't read too far
-
-                    if(!memcmp(png_magic, img_buf_posf, sizeof(png_magic))) {
-                        // PNG image, keep all data and advance buffer
-                        LOG_VERBOSE(TAG_ATTR, D_BULLET "PNG HEADER: %d bytes read=%d buf_len=%d", c, readf, buf_lenf);
-                        img_buf_posf += c;
-                        buf_lenf -= c;
-                        readf += c;
-                    } else {
-                        // BIN format, copy the header
-                        lv_img_header_t* header     = (lv_img_header_t*)img_buf_posf;
-                        img_dscf->header.always_zero = 0;
-                        img_dscf->header.w           = header->w;
-                        img_dscf->header.h           = header->h;
-                        img_dscf->header.cf          = header->cf;
-
-                        LOG_VERBOSE(TAG_ATTR, D_BULLET "BIN image: w=%d h=%d cf=%d len=%d", img_dscf->header.w,
-                                    img_dscf->header.h, img_dscf->header.cf, img_dscf->data_size);
-                        img_buf_posf += sizeof(lv_img_header_t);
-                        // shift remainder of 8 data-bytes to the start of the buffer
-                        memcpy(img_buf_startf, img_buf_posf, 8U - sizeof(lv_img_header_t));
-                        buf_lenf -= c;
-                        readf += c;
-                    }
-                } else {
-                    // disconnected
-                    hasp_free(img_buf_startf);
-                    lv_mem_free(img_dscf); // destroy header too
-                    LOG_ERROR(TAG_ATTR, "img header read failed %d", buf_lenf);
-                    file.close();
-                    return HASP_ATTR_TYPE_STR;
-                }
-
-                // Read image data
-                while( (buf_lenf > 0)) {
-                    if(size_t size = file.available()) {
-                        int c = file.readBytes((char *)img_buf_posf, size > buf_lenf ? buf_lenf : size); // don't read too far
-                        LOG_DEBUG(TAG_ATTR, "%s %d %x -> %x", __FILE__, __LINE__, img_dscf->data, img_buff);
-                        img_buf_posf += c;
-                        buf_lenf -= c;
-                        LOG_DEBUG(TAG_ATTR, D_BULLET "IMG DATA: %d bytes read=%d buf_len=%d", c, readf, buf_lenf);
-                        readf += c;
-                    } else {
-                        delay(1); // wait for data
-                    }
-                }
-
-                if(!memcmp(png_magic, img_dscf->data, sizeof(png_magic))) {
-                    // PNG format, get image size from header
-                    img_dscf->header.always_zero = 0;
-                    img_dscf->header.w           = img_buf_startf[19] + (img_buf_startf[18] << 8);
-                    img_dscf->header.h           = img_buf_startf[23] + (img_buf_startf[22] << 8);
-                    img_dscf->data_size          = img_buf_posf - img_buf_startf; // end of buffer - start of buffer
-                    img_dscf->header.cf          = LV_IMG_CF_RAW_ALPHA;
-                    LOG_VERBOSE(TAG_ATTR, D_BULLET "PNG image: w=%d h=%d cf=%d len=%d", img_dscf->header.w,
-                                img_dscf->header.h, img_dscf->header.cf, img_dscf->data_size);
-                } else {
-                    img_dscf->data_size = img_buf_posf - img_buf_startf - sizeof(lv_img_header_t); // end buf - start buf
-                    LOG_VERBOSE(TAG_ATTR, D_BULLET "BIN image: w=%d h=%d cf=%d len=%d", img_dscf->header.w,
-                                img_dscf->header.h, img_dscf->header.cf, img_dscf->data_size);
-                }
-                file.close();
-                my_image_release_resources(obj);
-                lv_img_set_src(obj, img_dscf);
-                //hasp_free(img_buf_startf);
-                LOG_VERBOSE(TAG_ATTR, F("Funciona %s"), payload);
-                //lv_mem_free(img_dscf); // NO LOP DESTUYASSSS cuando pongas
-                //lv_img_set_src(obj, img_dscf);
-                LOG_DEBUG(TAG_ATTR, "%s %d %x -> %x", __FILE__, __LINE__, img_buf_startf, img_buf_start_posf);
-
+            } else if(payload == strstr_P(payload, PSTR("Z:"))) {
+#if HASP_USE_IMAGE_FETCH > 0
+                if(!my_image_share_src(obj, payload)) image_fetch_start(obj, payload); // read in the background
+#endif
 
             } else if(payload == strstr_P(payload, PSTR("/littlefs/"))) { // startsWith command/
                 char tempsrc[64] = "L:";
@@ -1453,157 +1328,17 @@ static hasp_attribute_type_t special_attribute_src(lv_obj_t* obj, const char* pa
             }
 
         } else {
-#if defined(ARDUINO) && defined(ARDUINO_ARCH_ESP32)
-#if HASP_USE_WIFI > 0 || HASP_USE_ETHERNET > 0
-            HTTPClient http;
-            // http.begin(payload, (const char*)rootca_crt_bundle_start);
-            http.begin(payload);
-            http.setTimeout(5000);
-            http.setConnectTimeout(5000);
-
-            // const char* hdrs[] = {"Content-Type"};
-            // size_t numhdrs     = sizeof(hdrs) / sizeof(char*);
-            // http.collectHeaders(hdrs, numhdrs);
-
-            int httpCode = http.GET();
-            if(httpCode == HTTP_CODE_OK) {
-                int total   = http.getSize();
-                int url_len = strlen(payload) + 1;
-                int buf_len = total;
-                int dsc_len = sizeof(lv_img_dsc_t) + url_len;
-
-                if(buf_len <= 8) { // header could not fit
-                    LOG_ERROR(TAG_ATTR, "img data size is too small %d", buf_len);
-                    return HASP_ATTR_TYPE_STR;
-                }
-
-                Stream* stream = http.getStreamPtr();
-                if(!stream) {
-                    LOG_ERROR(TAG_ATTR, "failed to get http data stream");
-                    return HASP_ATTR_TYPE_STR;
-                }
-
-                lv_img_dsc_t* img_dsc = (lv_img_dsc_t*)lv_mem_alloc(dsc_len);
-                if(!img_dsc) {
-                    LOG_ERROR(TAG_ATTR, "img header creation failed %d", dsc_len);
-                    return HASP_ATTR_TYPE_STR;
-                }
-                char* url = ((char*)img_dsc) + sizeof(lv_img_dsc_t);
-
-                uint8_t* img_buf_start = (uint8_t*)(buf_len > 0 ? hasp_malloc(buf_len) : NULL);
-                uint8_t* img_buf_pos   = img_buf_start;
-                if(!img_buf_start) {
-                    lv_mem_free(img_dsc); // destroy header too
-                    LOG_ERROR(TAG_ATTR, "img buffer creation failed %d", buf_len);
-                    return HASP_ATTR_TYPE_STR;
-                }
-
-                // LOG_VERBOSE(TAG_ATTR, "img buffers created of %d and %d bytes", dsc_len, buf_len);
-                LOG_VERBOSE(TAG_ATTR, "img Content-Type: %s", http.header((size_t)0).c_str());
-
-                // Initialize the buffers
-                memset(img_buf_start, 0, buf_len);           // empty data buffer
-                memset(img_dsc, 0, dsc_len);                 // empty img descriptor + url
-                strncpy(url, payload, url_len);              // store the url behind the img_dsc data
-                img_dsc->data               = img_buf_start; // store pointer to the start of the data buffer
-                img_dsc->header.always_zero = 0;
-
-                // LOG_DEBUG(TAG_ATTR, "%s %d %x == %x", __FILE__, __LINE__, img_dsc->data, img_buf);
-
-                int read = 0;
-                while(http.connected() && (stream->available() < 8) && read < 250) {
-                    delay(1); // wait for header
-                    read++;   // time-out check
-                }
-
-                // Read image header
-                read                      = 0;
-                const uint8_t png_magic[] = {0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a};
-                if(stream->available() >= 8) {
-                    int c = stream->readBytes(img_buf_pos, 8); // don't read too far
-
-                    if(!memcmp(png_magic, img_buf_pos, sizeof(png_magic))) {
-                        // PNG image, keep all data and advance buffer
-                        LOG_VERBOSE(TAG_ATTR, D_BULLET "PNG HEADER: %d bytes read=%d buf_len=%d", c, read, buf_len);
-                        img_buf_pos += c;
-                        buf_len -= c;
-                        read += c;
-                    } else {
-                        // BIN format, copy the header
-                        lv_img_header_t* header     = (lv_img_header_t*)img_buf_pos;
-                        img_dsc->header.always_zero = 0;
-                        img_dsc->header.w           = header->w;
-                        img_dsc->header.h           = header->h;
-                        img_dsc->header.cf          = header->cf;
-
-                        LOG_VERBOSE(TAG_ATTR, D_BULLET "BIN image: w=%d h=%d cf=%d len=%d", img_dsc->header.w,
-                                    img_dsc->header.h, img_dsc->header.cf, img_dsc->data_size);
-                        img_buf_pos += sizeof(lv_img_header_t);
-                        // shift remainder of 8 data-bytes to the start of the buffer
-                        memcpy(img_buf_start, img_buf_pos, 8U - sizeof(lv_img_header_t));
-                        buf_len -= c;
-                        read += c;
-                    }
-                } else {
-                    // disconnected
-                    hasp_free(img_buf_start);
-                    lv_mem_free(img_dsc); // destroy header too
-                    LOG_ERROR(TAG_ATTR, "img header read failed %d", buf_len);
-                    return HASP_ATTR_TYPE_STR;
-                }
-
-                // Read image data
-                while(http.connected() && (buf_len > 0)) {
-                    if(size_t size = stream->available()) {
-                        int c = stream->readBytes(img_buf_pos, size > buf_len ? buf_len : size); // don't read too far
-                        // LOG_DEBUG(TAG_ATTR, "%s %d %x -> %x", __FILE__, __LINE__, img_dsc->data, img_buf);
-                        img_buf_pos += c;
-                        buf_len -= c;
-                        // LOG_DEBUG(TAG_ATTR, D_BULLET "IMG DATA: %d bytes read=%d buf_len=%d", c, read, buf_len);
-                        read += c;
-                    } else {
-                        delay(1); // wait for data
-                    }
-                }
-
-                // disconnected
-                if(buf_len > 0) {
-                    hasp_free(img_buf_start);
-                    lv_mem_free(img_dsc); // destroy header too
-                    LOG_ERROR(TAG_ATTR, "img data read failed %d", buf_len);
-                    return HASP_ATTR_TYPE_STR;
-                }
-
-                LOG_VERBOSE(TAG_ATTR, D_BULLET "HTTP TOTAL READ: %d bytes, %d buffered", read,
-                            img_buf_pos - img_buf_start);
-
-                if(total > 24 && !memcmp(png_magic, img_dsc->data, sizeof(png_magic))) {
-                    // PNG format, get image size from header
-                    img_dsc->header.always_zero = 0;
-                    img_dsc->header.w           = img_buf_start[19] + (img_buf_start[18] << 8);
-                    img_dsc->header.h           = img_buf_start[23] + (img_buf_start[22] << 8);
-                    img_dsc->data_size          = img_buf_pos - img_buf_start; // end of buffer - start of buffer
-                    img_dsc->header.cf          = LV_IMG_CF_RAW_ALPHA;
-                    LOG_VERBOSE(TAG_ATTR, D_BULLET "PNG image: w=%d h=%d cf=%d len=%d", img_dsc->header.w,
-                                img_dsc->header.h, img_dsc->header.cf, img_dsc->data_size);
-                } else {
-                    img_dsc->data_size = img_buf_pos - img_buf_start - sizeof(lv_img_header_t); // end buf - start buf
-                    LOG_VERBOSE(TAG_ATTR, D_BULLET "BIN image: w=%d h=%d cf=%d len=%d", img_dsc->header.w,
-                                img_dsc->header.h, img_dsc->header.cf, img_dsc->data_size);
-                }
-
-                my_image_release_resources(obj);
-                lv_img_set_src(obj, img_dsc);
-                // LOG_DEBUG(TAG_ATTR, "%s %d %x -> %x", __FILE__, __LINE__, img_buf_start, img_buf_start_pos);
-
-            } else {
-                LOG_WARNING(TAG_ATTR, "HTTP result %d", httpCode);
-            }
-            http.end();
-#endif // HASP_USE_NETWORK
-#endif // ESP32
+#if HASP_USE_IMAGE_FETCH > 0
+            if(!my_image_share_src(obj, payload)) image_fetch_start(obj, payload); // downloaded in the background
+#endif
         }
     } else {
+#if HASP_USE_IMAGE_FETCH > 0
+        if(const char* url = image_fetch_pending_url(obj)) {
+            *text = (char*)url; // still loading
+            return HASP_ATTR_TYPE_STR;
+        }
+#endif
         const void* src = lv_img_get_src(obj);
         switch(lv_img_src_get_type(src)) {
             case LV_IMG_SRC_FILE:
@@ -90,7 +90,7 @@ static void my_prune_ext_tags(lv_obj_t* obj)
     if(!obj || !obj->user_data.ext) return;
 
     hasp_ext_user_data_t* ext = (hasp_ext_user_data_t*)obj->user_data.ext;
-    if(!ext->action && !ext->swipe && !ext->tag) {
+    if(!ext->action && !ext->swipe && !ext->tag && !ext->fonts) {
         hasp_free(ext);
         obj->user_data.ext = NULL;
     }
@@ -302,6 +302,48 @@ const char* my_obj_get_swipe(lv_obj_t* obj)
     return ext ? ext->swipe : NULL;
 }
 
+// the font can't be freed by clearfont while it is in the style of the object
+void my_obj_retain_font(lv_obj_t* obj, const lv_font_t* font)
+{
+    hasp_ext_user_data_t* ext = (hasp_ext_user_data_t*)obj->user_data.ext;
+    size_t count              = 0;
+
+    if(ext && ext->fonts) {
+        while(ext->fonts[count]) {
+            if(ext->fonts[count] == font) return; // already retained
+            count++;
+        }
+    }
+
+    // create new extended tags
+    if(!ext) ext = my_create_ext_tags(obj);
+
+    const lv_font_t** fonts = NULL;
+    if(ext) fonts = (const lv_font_t**)hasp_realloc(ext->fonts, (count + 2) * sizeof(lv_font_t*));
+    if(!fonts) {
+        LOG_WARNING(TAG_ATTR, D_ERROR_OUT_OF_MEMORY); // ext or fonts was NULL
+        my_prune_ext_tags(obj);
+        return;
+    }
+
+    fonts[count]     = font;
+    fonts[count + 1] = NULL;
+    ext->fonts       = fonts;
+    font_retain(font);
+}
+
+// release the fonts used by the object before it is deleted
+void my_obj_release_fonts(lv_obj_t* obj)
+{
+    hasp_ext_user_data_t* ext = (hasp_ext_user_data_t*)obj->user_data.ext;
+    if(!ext || !ext->fonts) return;
+
+    for(const lv_font_t** font = ext->fonts; *font; font++) font_release(*font);
+    hasp_free(ext->fonts);
+    ext->fonts = NULL;
+    my_prune_ext_tags(obj);
+}
+
 lv_label_align_t my_textarea_get_text_align(lv_obj_t* ta)
 {
     lv_textarea_ext_t* ext = (lv_textarea_ext_t*)lv_obj_get_ext_attr(ta);
@@ -0,0 +1,138 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#ifdef ARDUINO
+
+#include "hasp_debug.h"
+#include "hasp_command_batch.h"
+
+CommandBatch::CommandBatch(uint8_t source)
+    : _mode(MODE_DETECT), _source(source), _depth(0), _in_string(false), _escape(false), _overflow(false),
+      _array_line(false), _line(0), _count(0), _failed(0), _slowest_line(0), _slowest_duration(0), _duration(0),
+      _len(0)
+{
+    _saved_page = haspPages.get();
+}
+
+void CommandBatch::append(char c)
+{
+    if(_len < sizeof(_cmd) - 1)
+        _cmd[_len++] = c;
+    else
+        _overflow = true;
+}
+
+/* Run the collected command, an incomplete command is reported as failed */
+void CommandBatch::dispatch(bool complete)
+{
+    while(_len > 0 && isspace(_cmd[_len - 1])) _len--; // trim
+    _cmd[_len] = '\0';
+
+    bool overflow = _overflow;
+    _len          = 0;
+    _overflow     = false;
+    _line++;
+
+    const char* cmd = _cmd;
+    while(isspace(*cmd)) cmd++;
+    if(*cmd == '\0' && complete && !overflow) return; // empty line
+
+    bool ok           = false;
+    uint32_t duration = 0;
+    if(overflow) {
+        LOG_WARNING(TAG_MSGR, F("Command %u is longer than %u bytes"), _line, sizeof(_cmd) - 1);
+    } else if(!complete) {
+        LOG_WARNING(TAG_MSGR, F("Command %u is incomplete"), _line);
+    } else {
+        uint32_t start = micros();
+        ok             = dispatch_text_line(cmd, _saved_page, _source);
+        duration       = micros() - start;
+    }
+
+    _count++;
+    _duration += duration;
+    if(duration > _slowest_duration) {
+        _slowest_duration = duration;
+        _slowest_line     = _line;
+    }
+    if(!ok) {
+        if(_failed < COMMAND_BATCH_MAX_ERRORS) _errors[_failed] = _line;
+        _failed++;
+    }
+}
+
+void CommandBatch::put(char c)
+{
+    switch(_mode) {
+        case MODE_DETECT:
+            if(c == '\n' && !_array_line) _line++; // keep the line numbers
+            if(c == '\n') _array_line = false;
+            if(isspace(c)) return;
+            if(c == '[') {
+                _mode = MODE_ARRAY; // skip the opening bracket
+                return;
+            }
+            _mode = MODE_LINES;
+            break;
+
+        case MODE_LINES:
+            if(c == '\n') {
+                dispatch(true);
+                return;
+            }
+            break;
+
+        case MODE_ARRAY: // split the top level elements
+            if(_in_string) {
+                if(_escape)
+                    _escape = false;
+                else if(c == '\\')
+                    _escape = true;
+                else if(c == '"')
+                    _in_string = false;
+
+            } else if(c == '"') {
+                _in_string = true;
+
+            } else if(c == '[' || c == '{') {
+                _depth++;
+
+            } else if(c == ']' || c == '}') {
+                if(_depth == 0) { // end of the array, more commands can follow
+                    dispatch(true);
+                    _mode       = MODE_DETECT;
+                    _array_line = true; // the last element was on this line
+                    return;
+                }
+                _depth--;
+
+            } else if(c == ',' && _depth == 0) {
+                dispatch(true);
+                return;
+            }
+            break;
+    }
+
+    append(c);
+}
+
+void CommandBatch::write(const uint8_t* buf, size_t len)
+{
+    for(size_t i = 0; i < len; i++) put(buf[i]);
+}
+
+/* Run the last line, an array that is not closed fails */
+void CommandBatch::end()
+{
+    if(_mode == MODE_LINES) {
+        dispatch(true);
+
+    } else if(_mode == MODE_ARRAY) {
+        dispatch(false);
+    }
+    _mode = MODE_DETECT;
+}
+
+#endif
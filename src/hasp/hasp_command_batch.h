@@ -0,0 +1,88 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_COMMAND_BATCH_H
+#define HASP_COMMAND_BATCH_H
+
+#include "hasplib.h"
+
+#ifdef ARDUINO
+
+/* Batch of commands that is applied while it is received
+ *
+ * The body is pushed in pieces of any size and split into commands as soon as they are complete:
+ *  - a JSON array: each element is a command string, a jsonl object or a nested array of commands
+ *  - otherwise each line is a text command or jsonl, like the console and pages.jsonl
+ * Commands are numbered from 1 by line, each element of an array counts as one line.
+ * Every command goes through dispatch_text_line. Only counters, the slowest command and the line numbers
+ * of the first COMMAND_BATCH_MAX_ERRORS failed commands are kept for the reply, so any batch size fits.
+ * jsonl objects without a page id are added to the page of the previous object, as in pages.jsonl.
+ */
+
+#ifndef COMMAND_BATCH_LINE_SIZE
+#define COMMAND_BATCH_LINE_SIZE 1024 // longest command
+#endif
+
+#ifndef COMMAND_BATCH_MAX_ERRORS
+#define COMMAND_BATCH_MAX_ERRORS 16 // failed commands listed by line number, the others are only counted
+#endif
+
+class CommandBatch {
+
+  public:
+    CommandBatch(uint8_t source);
+
+    void write(const uint8_t* buf, size_t len);
+    void end();
+
+    uint16_t count()
+    {
+        return _count;
+    }
+    uint16_t failed()
+    {
+        return _failed;
+    }
+    uint32_t duration()
+    {
+        return _duration;
+    }
+    uint16_t slowest_line()
+    {
+        return _slowest_line;
+    }
+    uint32_t slowest_duration()
+    {
+        return _slowest_duration;
+    }
+    uint16_t error_line(uint16_t index) // line of a failed command, index below failed() and COMMAND_BATCH_MAX_ERRORS
+    {
+        return _errors[index];
+    }
+
+  private:
+    enum : uint8_t { MODE_DETECT, MODE_LINES, MODE_ARRAY } _mode;
+    uint8_t _source;
+    uint8_t _saved_page;
+    uint8_t _depth; // nesting inside an array element
+    bool _in_string;
+    bool _escape;
+    bool _overflow;
+    bool _array_line; // an array ended on the current line
+    uint16_t _line;
+    uint16_t _count;
+    uint16_t _failed;
+    uint16_t _slowest_line;
+    uint32_t _slowest_duration; // [us]
+    uint32_t _duration;         // [us]
+    size_t _len;
+    uint16_t _errors[COMMAND_BATCH_MAX_ERRORS];
+    char _cmd[COMMAND_BATCH_LINE_SIZE];
+
+    void put(char c);
+    void append(char c);
+    void dispatch(bool complete);
+};
+
+#endif
+#endif
@@ -37,6 +37,10 @@
 #endif
 #endif
 
+#if HASP_USE_EVENT_STREAM > 0
+#include "sys/svc/hasp_event_stream.h"
+#endif
+
 dispatch_conf_t dispatch_setings = {.teleperiod = 300};
 
 uint16_t dispatchSecondsToNextTeleperiod = 0;
@@ -52,6 +56,10 @@ uint8_t saved_jsonl_page = 0;
  */
 void dispatch_state_subtopic(const char* subtopic, const char* payload)
 {
+#if HASP_USE_EVENT_STREAM > 0
+    event_stream_send(subtopic, payload);
+#endif
+
 #if HASP_USE_MQTT == 0 && HASP_USE_TASMOTA_CLIENT == 0
     LOG_TRACE(TAG_MSGR, F("%s => %s"), subtopic, payload);
 #else
@@ -426,8 +434,14 @@ static void dispatch_simple_text_command(const char* cmnd, uint8_t source)
     }
 }
 
+/* Commands from outside the plate, the internal ones like idle scripts and timers must not undo the idle rate */
+static inline bool dispatch_is_external(uint8_t source)
+{
+    return source == TAG_MQTT || source == TAG_HTTP || source == TAG_CONS || source == TAG_TELN;
+}
+
 // Strip command/config prefix from the topic and process the payload
-void dispatch_topic_payload(const char* topic, const char* payload, bool update, uint8_t source)
+static void dispatch_topic_payload_run(const char* topic, const char* payload, bool update, uint8_t source)
 {
     if(!strcmp_P(topic, PSTR(MQTT_TOPIC_COMMAND)) || topic[0] == '\0') {
         dispatch_simple_text_command((char*)payload, source);
@@ -459,6 +473,15 @@ void dispatch_topic_payload(const char* topic, const char* payload, bool update,
     dispatch_command(topic, (char*)payload, update, source); // dispatch as is
 }
 
+void dispatch_topic_payload(const char* topic, const char* payload, bool update, uint8_t source)
+{
+    // external commands are processed at the active refresh rate, also while idle
+    if(dispatch_is_external(source)) gui_boost_refresh();
+
+    dispatch_topic_payload_run(topic, payload, update, source);
+    gui_wakeup(); // the command may have changed objects, a sleeping GUI task renders them now
+}
+
 // void dispatch_output_group_state(uint8_t groupid, uint16_t state)
 // {
 //     char payload[64];
@@ -675,7 +698,9 @@ bool dispatch_json_variant(JsonVariant& json, uint8_t& savedPage, uint8_t source
     return true;
 }
 
-void dispatch_text_line(const char* payload, uint8_t source)
+/* Dispatch a text command or json, jsonl objects without a page use saved_page_id
+ * Returns false when the line looks like json but could not be parsed or dispatched */
+bool dispatch_text_line(const char* payload, uint8_t& saved_page_id, uint8_t source)
 {
 
     {
@@ -692,19 +717,28 @@ void dispatch_text_line(const char* payload, uint8_t source)
             // dispatch_json_error(TAG_MSGR, jsonError);
 
         } else {
-            JsonVariant json  = doc.as<JsonVariant>();
-            uint8_t savedPage = haspPages.get();
-            if(!dispatch_json_variant(json, savedPage, source)) {
+            JsonVariant json = doc.as<JsonVariant>();
+            if(!dispatch_json_variant(json, saved_page_id, source)) {
                 LOG_WARNING(TAG_MSGR, F(D_DISPATCH_COMMAND_NOT_FOUND), payload);
                 // dispatch_simple_text_command(payload, source);
+                return false;
             }
 
-            return;
+            return true;
         }
     }
 
     // Could not parse as json
     dispatch_simple_text_command(payload, source);
+
+    while(*payload == ' ' || *payload == '\t') payload++;
+    return *payload != '{' && *payload != '['; // invalid json
+}
+
+void dispatch_text_line(const char* payload, uint8_t source)
+{
+    uint8_t savedPage = haspPages.get();
+    dispatch_text_line(payload, savedPage, source);
 }
 
 void dispatch_parse_json(const char*, const char* payload, uint8_t source)
@@ -1616,6 +1650,9 @@ void dispatchSetup()
     dispatch_add_command(PSTR("unzip"), filesystemUnzip);
 #endif
 #endif
+#if HASP_USE_FONT_SUBSET > 0
+    dispatch_add_command(PSTR("fontsubset"), font_subset_command);
+#endif
 #if HASP_USE_CONFIG > 0 && HASP_TARGET_ARDUINO
     dispatch_add_command(PSTR("setupap"), oobeFakeSetup);
 #endif
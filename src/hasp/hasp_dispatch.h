@@ -57,6 +57,7 @@ void dispatchStop(void);
 /* ===== Special Event Processors ===== */
 void dispatch_topic_payload(const char* topic, const char* payload, bool update, uint8_t source);
 void dispatch_text_line(const char* cmnd, uint8_t source);
+bool dispatch_text_line(const char* cmnd, uint8_t& saved_page_id, uint8_t source);
 
 #ifdef ARDUINO
 void dispatch_parse_jsonl(Stream& stream, uint8_t& saved_page_id);
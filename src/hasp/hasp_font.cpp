@@ -26,6 +26,13 @@ typedef struct
 #include "hasp_mem.h"
 #include "font/hasp_font_loader.h"
 
+#ifndef LVGL_FREETYPE_ATLAS_SIZE
+#define LVGL_FREETYPE_ATLAS_SIZE (16 * 1024) // rendered glyphs of all FreeType fonts
+#endif
+#ifndef LVGL_FREETYPE_ATLAS_SIZE_PSRAM
+#define LVGL_FREETYPE_ATLAS_SIZE_PSRAM (256 * 1024)
+#endif
+
 #if defined(ARDUINO_ARCH_ESP32) && (HASP_USE_FREETYPE > 0) // && defined(ESP32S3)
 // #if ESP_FLASH_SIZE > 4
 extern const uint8_t OPENHASP_TTF_START[] asm("_binary_data_openhasp_ttf_start");
@@ -36,15 +43,33 @@ extern const uint8_t OPENHASP_TTF_END[] asm("_binary_data_openhasp_ttf_end");
 // #endif
 #endif
 
-static lv_ll_t hasp_fonts_ll;
+LV_FONT_DECLARE(unscii_8_icon);
 
-typedef struct
+#ifndef HASP_FONT_BUCKETS
+#define HASP_FONT_BUCKETS 16 // font payloads and font pointers are hashed into this many buckets
+#endif
+
+enum hasp_font_type_t {
+    HASP_FONT_TYPE_BINARY   = 0, // .bin file
+    HASP_FONT_TYPE_FREETYPE = 1, // .ttf or .otf file
+    HASP_FONT_TYPE_EMBEDDED = 2, // FreeType font embedded in flash
+    HASP_FONT_TYPE_BUILTIN  = 3, // compiled into the firmware, never freed
+};
+
+typedef struct hasp_font_info_t
 {
-    char* payload;   /* The payload with name and size */
-    lv_font_t* font; /* point to lvgl font */
+    struct hasp_font_info_t* next;      /* next font with the same payload hash */
+    struct hasp_font_info_t* next_font; /* next font with the same font pointer hash */
+    char* payload;                      /* The normalized payload with name and size */
+    lv_font_t* font;                    /* point to lvgl font */
+    uint32_t hash;
+    uint16_t refs; /* objects that use the font */
     uint8_t type;
 } hasp_font_info_t;
 
+static hasp_font_info_t* hasp_fonts[HASP_FONT_BUCKETS];
+static hasp_font_info_t* hasp_fonts_by_font[HASP_FONT_BUCKETS];
+
 bool font_dummy_glyph_dsc(const struct _lv_font_struct*, lv_font_glyph_dsc_t*, uint32_t letter, uint32_t letter_next)
 {
     return false;
@@ -65,6 +90,7 @@ void font_setup()
         LOG_VERBOSE(TAG_FONT, F("FreeType v%d.%d.%d " D_SERVICE_STARTED " = %d"), FREETYPE_MAJOR, FREETYPE_MINOR,
                     FREETYPE_PATCH, hasp_use_psram());
         LOG_DEBUG(TAG_FONT, F("FreeType High Watermark %u"), lv_ft_freetype_high_watermark());
+        lv_ft_atlas_set_budget(hasp_use_psram() ? LVGL_FREETYPE_ATLAS_SIZE_PSRAM : LVGL_FREETYPE_ATLAS_SIZE);
     } else {
         LOG_ERROR(TAG_FONT, F("FreeType " D_SERVICE_START_FAILED));
     }
@@ -75,8 +101,6 @@ void font_setup()
 #else
     LOG_VERBOSE(TAG_FONT, F("FreeType " D_SERVICE_DISABLED));
 #endif // HASP_USE_FREETYPE
-
-    _lv_ll_init(&hasp_fonts_ll, sizeof(hasp_font_info_t));
 }
 
 size_t font_split_payload(const char* payload)
@@ -89,15 +113,57 @@ size_t font_split_payload(const char* payload)
     return 0;
 }
 
-static void font_release(void* node)
+static uint32_t font_hash(const char* payload)
+{
+    uint32_t hash = 2166136261u; // FNV-1a, digits matter for font sizes
+    while(*payload) hash = (hash ^ (uint8_t)*payload++) * 16777619u;
+    return hash;
+}
+
+static inline uint8_t font_bucket(const lv_font_t* font)
+{
+    return ((uintptr_t)font >> 4) % HASP_FONT_BUCKETS;
+}
+
+/* Trim the payload and drop leading zeros of a font id, so equal fonts share the same key */
+static bool font_normalize(const char* payload, char* spec, size_t size)
+{
+    while(*payload == ' ') payload++;
+    size_t len = strlen(payload);
+    while(len > 0 && payload[len - 1] == ' ') len--;
+    if(len == 0 || len >= size) return false;
+
+    memcpy(spec, payload, len);
+    spec[len] = '\0';
+    if(Parser::is_only_digits(spec)) snprintf_P(spec, size, PSTR("%u"), (unsigned int)atoi(spec));
+    return true;
+}
+
+static hasp_font_info_t* font_find_in_list(const char* spec, uint32_t hash)
+{
+    hasp_font_info_t* font_p = hasp_fonts[hash % HASP_FONT_BUCKETS];
+    while(font_p) {
+        if(font_p->hash == hash && strcmp(font_p->payload, spec) == 0) return font_p; // name and size
+        font_p = font_p->next;
+    }
+    return NULL;
+}
+
+static hasp_font_info_t* font_find_font(const lv_font_t* font)
+{
+    hasp_font_info_t* font_p = hasp_fonts_by_font[font_bucket(font)];
+    while(font_p && font_p->font != font) font_p = font_p->next_font;
+    return font_p;
+}
+
+static void font_release_info(hasp_font_info_t* font_p)
 {
-    hasp_font_info_t* font_p = (hasp_font_info_t*)node;
     if(font_p->font) {
-        if(font_p->type = 1) { // It's a FreeType font
+        if(font_p->type == HASP_FONT_TYPE_FREETYPE || font_p->type == HASP_FONT_TYPE_EMBEDDED) {
 #if(HASP_USE_FREETYPE > 0)
             lv_ft_font_destroy(font_p->font);
 #endif
-        } else if(font_p->type = 0) { // It's a binary font
+        } else if(font_p->type == HASP_FONT_TYPE_BINARY) {
             hasp_font_free(font_p->font);
         }
     }
@@ -109,63 +175,101 @@ static void font_release(void* node)
     }
 }
 
-void font_clear_list(const char* payload)
+static void font_unlink(hasp_font_info_t* font_p)
 {
-    if(_lv_ll_is_empty(&hasp_fonts_ll)) return;
+    hasp_font_info_t** link = &hasp_fonts[font_p->hash % HASP_FONT_BUCKETS];
+    while(*link != font_p) link = &(*link)->next;
+    *link = font_p->next;
 
-    while(void* node = _lv_ll_get_head(&hasp_fonts_ll)) {
-        font_release(node);
-        _lv_ll_remove(&hasp_fonts_ll, node);
-        lv_mem_free(node);
-    }
+    link = &hasp_fonts_by_font[font_bucket(font_p->font)];
+    while(*link != font_p) link = &(*link)->next_font;
+    *link = font_p->next_font;
 }
 
-// void font_clear_list2(const char* payload)
-// {
-//     hasp_font_info_t* font_p = (hasp_font_info_t*)_lv_ll_get_head(&hasp_fonts_ll);
-//     while(font_p) {
-//         if(font_p->type == 1) {
-//             lv_font_fmt_ft_dsc_t* dsc = (lv_font_fmt_ft_dsc_t*)font_p->font->dsc;
-//             if(strcmp(dsc->name, payload) == 0) { // name and size
-//                 lv_ft_font_destroy(font_p->font);
-//                 *font_p->font = HASP_FONT_1;
-//                 font_p->type  = 255;
-//             }
-//         }
-//         // if(strcmp(font_p->payload, payload) == 0) { // name and size
-//         //     LOG_DEBUG(TAG_FONT, F("Payload %s found => line height = %d - base_line = %d"), payload,
-//         //               font_p->font->line_height, font_p->font->base_line);
-//         //     return font_p->font;
-//         // }
-
-//         font_p = (hasp_font_info_t*)_lv_ll_get_next(&hasp_fonts_ll, font_p);
-//     }
-// }
-
-static lv_font_t* font_find_in_list(const char* payload)
+// Free the fonts that are not used by any object, or only the font in the payload
+void font_clear_list(const char* payload)
 {
-    hasp_font_info_t* font_p = (hasp_font_info_t*)_lv_ll_get_head(&hasp_fonts_ll);
-    while(font_p) {
-        if(strcmp(font_p->payload, payload) == 0) { // name and size
-            LOG_DEBUG(TAG_FONT, F("Payload %s found => line height = %d - base_line = %d"), payload,
-                      font_p->font->line_height, font_p->font->base_line);
-            return font_p->font;
+    char spec[64];
+    bool all        = !payload || !font_normalize(payload, spec, sizeof(spec));
+    uint16_t in_use = 0;
+
+    for(uint8_t bucket = 0; bucket < HASP_FONT_BUCKETS; bucket++) {
+        hasp_font_info_t* font_p = hasp_fonts[bucket];
+        while(font_p) {
+            hasp_font_info_t* next = font_p->next;
+            if(all || strcmp(font_p->payload, spec) == 0) {
+                if(font_p->refs > 0) {
+                    LOG_VERBOSE(TAG_FONT, F("Font %s is used by %u objects"), font_p->payload, font_p->refs);
+                    in_use++;
+                } else {
+                    font_unlink(font_p);
+                    font_release_info(font_p);
+                    hasp_free(font_p);
+                }
+            }
+            font_p = next;
         }
-        font_p = (hasp_font_info_t*)_lv_ll_get_next(&hasp_fonts_ll, font_p);
     }
 
-    return NULL;
+    if(in_use) LOG_INFO(TAG_FONT, F("%u fonts still in use are kept"), in_use);
 }
 
-static lv_font_t* font_add_to_list(const char* payload)
+// The font is in the list, a .bin font can still read glyphs from its file
+bool font_is_loaded(const char* payload)
+{
+    char spec[64];
+    return payload && font_normalize(payload, spec, sizeof(spec)) && font_find_in_list(spec, font_hash(spec));
+}
+
+// Fonts compiled into the firmware, payload is a font id
+static bool font_get_builtin(const char* payload, lv_font_t** font)
+{
+    if(!Parser::is_only_digits(payload)) return false;
+    uint8_t var = atoi(payload);
+
+    if(var >= 0 && var < 8)
+        *font = hasp_get_font(var);
+    else if(var == 8)
+        *font = &unscii_8_icon;
+
+#if !defined(ARDUINO_ARCH_ESP8266) // && (HASP_USE_FREETYPE == 0)
+
+#if defined(HASP_FONT_1) && defined(HASP_FONT_1)
+    else if(var == HASP_FONT_SIZE_1)
+        *font = &HASP_FONT_1;
+#endif
+#if defined(HASP_FONT_2) && defined(HASP_FONT_2)
+    else if(var == HASP_FONT_SIZE_2)
+        *font = &HASP_FONT_2;
+#endif
+#if defined(HASP_FONT_3) && defined(HASP_FONT_3)
+    else if(var == HASP_FONT_SIZE_3)
+        *font = &HASP_FONT_3;
+#endif
+#if defined(HASP_FONT_4) && defined(HASP_FONT_4)
+    else if(var == HASP_FONT_SIZE_4)
+        *font = &HASP_FONT_4;
+#endif
+#if defined(HASP_FONT_5) && defined(HASP_FONT_5)
+    else if(var == HASP_FONT_SIZE_5)
+        *font = &HASP_FONT_5;
+#endif
+
+#endif
+    else
+        return false;
+
+    return true;
+}
+
+static lv_font_t* font_load(const char* payload, uint8_t* font_type)
 {
     char filename[256];
 
     // Try .bin file
     snprintf_P(filename, sizeof(filename), PSTR("L:\\%s.bin"), payload);
-    lv_font_t* font   = hasp_font_load(filename);
-    char* name_p      = NULL;
-    uint8_t font_type = 0;
+    lv_font_t* font = hasp_font_load(filename);
+    *font_type      = HASP_FONT_TYPE_BINARY;
 
 #if defined(ARDUINO_ARCH_ESP32) && (HASP_USE_FREETYPE > 0)
     char* ext[] = {"ttf", "otf"};
@@ -202,8 +306,8 @@ static lv_font_t* font_add_to_list(const char* payload)
                 info.style    = FT_FONT_STYLE_NORMAL;
                 LOG_VERBOSE(TAG_FONT, F("Loading font %s size %d"), filename, size);
                 if(lv_ft_font_init(&info)) {
-                    font      = info.font;
-                    font_type = 1;
+                    font       = info.font;
+                    *font_type = HASP_FONT_TYPE_FREETYPE;
                 }
             }
         }
@@ -222,8 +326,8 @@ static lv_font_t* font_add_to_list(const char* payload)
             info.style    = FT_FONT_STYLE_NORMAL;
             LOG_VERBOSE(TAG_FONT, F("Loading font %s size %d"), filename, size);
             if(lv_ft_font_init(&info)) {
-                font      = info.font;
-                font_type = 2; // Flash embedded TTF
+                font       = info.font;
+                *font_type = HASP_FONT_TYPE_EMBEDDED;
             }
         }
     }
@@ -233,32 +337,122 @@ static lv_font_t* font_add_to_list(const char* payload)
 
     if(!font) return NULL;
     LOG_VERBOSE(TAG_FONT, F("Loaded font %s line_height %d"), filename, font->line_height);
+#if HASP_USE_FREETYPE > 0
+    LOG_DEBUG(TAG_FONT, F("FreeType High Watermark %u"), lv_ft_freetype_high_watermark());
+#endif
+    return font;
+}
+
+static lv_font_t* font_add_to_list(const char* spec, uint32_t hash, lv_font_t* font, uint8_t font_type)
+{
+    hasp_font_info_t* new_font_item = (hasp_font_info_t*)hasp_calloc(1, sizeof(hasp_font_info_t));
+    if(!new_font_item) goto error;
 
     /* alloc payload str */
-    size_t len = strlen(payload);
-    name_p     = (char*)hasp_calloc(sizeof(char), len + 1);
-    if(!name_p) return NULL;
-    strncpy(name_p, payload, len);
+    new_font_item->payload = (char*)hasp_calloc(sizeof(char), strlen(spec) + 1);
+    if(!new_font_item->payload) goto error;
+    strcpy(new_font_item->payload, spec);
+
+    new_font_item->font = font;
+    new_font_item->hash = hash;
+    new_font_item->type = font_type;
+
+    new_font_item->next                   = hasp_fonts[hash % HASP_FONT_BUCKETS];
+    hasp_fonts[hash % HASP_FONT_BUCKETS]  = new_font_item;
+    new_font_item->next_font              = hasp_fonts_by_font[font_bucket(font)];
+    hasp_fonts_by_font[font_bucket(font)] = new_font_item;
+    return font;
 
-    hasp_font_info_t* new_font_item;
-    new_font_item = (hasp_font_info_t*)_lv_ll_ins_tail(&hasp_fonts_ll);
-    if(!new_font_item) return NULL;
+error:
+    LOG_ERROR(TAG_FONT, F(D_ERROR_OUT_OF_MEMORY));
+    if(new_font_item) hasp_free(new_font_item->payload);
+    hasp_free(new_font_item);
+    if(font_type == HASP_FONT_TYPE_BUILTIN) return font; // can be used without the list
 
-    new_font_item->payload = name_p;
-    new_font_item->font    = font;
-    new_font_item->type    = font_type;
-    return font;
+    hasp_font_info_t font_item = {NULL, NULL, NULL, font, hash, 0, font_type};
+    font_release_info(&font_item);
+    return NULL;
 }
 
 // Convert the payload to a font pointer
 lv_font_t* get_font(const char* payload)
 {
-#if HASP_USE_FREETYPE > 0
-    LOG_DEBUG(TAG_FONT, F("FreeType High Watermark %u"), lv_ft_freetype_high_watermark());
+    char spec[64];
+    if(!payload || !font_normalize(payload, spec, sizeof(spec))) return NULL;
+
+    uint32_t hash            = font_hash(spec);
+    hasp_font_info_t* font_p = font_find_in_list(spec, hash);
+    if(font_p) return font_p->font;
+
+    lv_font_t* font;
+    uint8_t font_type = HASP_FONT_TYPE_BUILTIN;
+    if(!font_get_builtin(spec, &font)) font = font_load(spec, &font_type);
+    if(!font) return NULL;
+
+    return font_add_to_list(spec, hash, font, font_type);
+}
+
+// An object uses the font, it is not freed by font_clear_list
+void font_retain(const lv_font_t* font)
+{
+    if(hasp_font_info_t* font_p = font_find_font(font)) font_p->refs++;
+}
+
+// An object no longer uses the font
+void font_release(const lv_font_t* font)
+{
+    hasp_font_info_t* font_p = font_find_font(font);
+    if(font_p && font_p->refs > 0) font_p->refs--;
+}
+
+// Render the characters of text attributes that lvgl does not measure when they are set into the glyph atlas.
+// A text, also of a roller, already passes through the glyph cache in lv_label_set_text.
+void font_prewarm(lv_obj_t* obj, const JsonObject& config)
+{
+#if defined(ARDUINO_ARCH_ESP32) && (HASP_USE_FREETYPE > 0)
+    for(JsonPair keyValue : config) {
+        const char* key = keyValue.key().c_str();
+        if(!strcmp_P(key, PSTR("value_str"))) { // only measured when the object is drawn
+            lv_ft_font_prewarm(lv_obj_get_style_value_font(obj, LV_OBJ_PART_MAIN), keyValue.value().as<const char*>());
+        } else if(!strcmp_P(key, PSTR("options")) && obj_check_type(obj, LV_HASP_DROPDOWN)) { // when it opens
+            lv_ft_font_prewarm(lv_obj_get_style_text_font(obj, LV_DROPDOWN_PART_LIST),
+                               keyValue.value().as<const char*>());
+        }
+    }
 #endif
+}
 
-    lv_font_t* font = font_find_in_list(payload);
-    if(font) return font;
+void font_get_info(JsonDocument& doc)
+{
+    char size_buf[32];
+    char budget_buf[16];
+    hasp_font_cache_stats_t stats;
+    hasp_font_cache_stats(&stats);
+
+    JsonObject info  = doc.createNestedObject(F("Glyph Cache"));
+    info[F("Fonts")] = stats.fonts;
+
+    Parser::format_bytes(stats.used, size_buf, sizeof(size_buf));
+    Parser::format_bytes(stats.budget, budget_buf, sizeof(budget_buf));
+    snprintf_P(size_buf + strlen(size_buf), sizeof(size_buf) - strlen(size_buf), PSTR(" / %s, %u glyphs"), budget_buf,
+               stats.glyphs);
+    info[F("Memory")]    = size_buf;
+    info[F("Hits")]      = stats.hits;
+    info[F("Misses")]    = stats.misses;
+    info[F("Evictions")] = stats.evictions;
 
-    return font_add_to_list(payload);
+#if defined(ARDUINO_ARCH_ESP32) && (HASP_USE_FREETYPE > 0)
+    lv_ft_atlas_stats_t atlas;
+    lv_ft_atlas_get_stats(&atlas);
+
+    info = doc.createNestedObject(F("Glyph Atlas"));
+    Parser::format_bytes(atlas.used, size_buf, sizeof(size_buf));
+    Parser::format_bytes(atlas.budget, budget_buf, sizeof(budget_buf));
+    snprintf_P(size_buf + strlen(size_buf), sizeof(size_buf) - strlen(size_buf), PSTR(" / %s, %u glyphs"), budget_buf,
+               atlas.glyphs);
+    info[F("Memory")]    = size_buf;
+    info[F("Hits")]      = atlas.hits;
+    info[F("Misses")]    = atlas.misses;
+    info[F("Evictions")] = atlas.evictions;
+#endif
 }
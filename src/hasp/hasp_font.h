@@ -6,6 +6,11 @@
 
 void font_setup();
 lv_font_t* get_font(const char* payload);
+void font_retain(const lv_font_t* font);
+void font_release(const lv_font_t* font);
 void font_clear_list(const char* payload);
+bool font_is_loaded(const char* payload);
+void font_prewarm(lv_obj_t* obj, const JsonObject& config);
+void font_get_info(JsonDocument& doc);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,616 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if HASP_USE_FONT_SUBSET > 0
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "hasp_debug.h"
+#include "hasp_filesystem.h"
+#include "font/hasp_font_loader.h"
+
+#define FONT_SUBSET_PATH_SIZE 64
+
+extern char haspPagesPath[32];
+
+/* A font used in the pages, the file is /<name>.bin */
+typedef struct
+{
+    std::string name;
+    std::vector<uint32_t> letters;
+} font_subset_font_t;
+
+typedef struct
+{
+    uint32_t file;
+    uint32_t ram; // about what hasp_font_load allocates for the glyphs
+    uint32_t glyphs;
+} font_subset_size_t;
+
+/* A subset the worker wrote to <name>.bin.tmp, the GUI moves it in place */
+typedef struct
+{
+    std::string name;
+    font_subset_size_t before;
+    font_subset_size_t after;
+} font_subset_result_t;
+
+/* The worker owns the results until it sets done, the GUI polls for it */
+static lv_task_t* font_subset_poll_task;
+static volatile bool font_subset_done;
+static std::vector<font_subset_result_t> font_subset_results;
+static char font_subset_file[FONT_SUBSET_PATH_SIZE];
+static bool font_subset_only;
+static char font_subset_next[FONT_SUBSET_PATH_SIZE]; // requested while the worker is busy
+static bool font_subset_next_only;
+
+/* ===== Pages ===== */
+
+/* The attribute name with an optional part and state number, like text_font10 */
+static bool font_subset_is_key(const char* key, const char* name)
+{
+    size_t len = strlen_P(name);
+    return !strncmp_P(key, name, len) && Parser::is_only_digits(key + len);
+}
+
+static void font_subset_add_text(std::vector<uint32_t>& letters, const char* text)
+{
+    uint32_t i = 0;
+    while(text[i] != '\0') letters.push_back(_lv_txt_encoded_next(text, &i));
+}
+
+static void font_subset_add_value(std::vector<uint32_t>& letters, JsonVariantConst value)
+{
+    if(value.is<JsonArrayConst>()) { // btnmatrix options
+        for(JsonVariantConst item : value.as<JsonArrayConst>()) font_subset_add_value(letters, item);
+        return;
+    }
+
+    font_subset_add_text(letters, value.as<std::string>().c_str());
+}
+
+static font_subset_font_t* font_subset_find(std::vector<font_subset_font_t>& fonts, const std::string& name)
+{
+    for(font_subset_font_t& font : fonts) {
+        if(font.name == name) return &font;
+    }
+    fonts.push_back(font_subset_font_t());
+    fonts.back().name = name;
+    return &fonts.back();
+}
+
+/* Add the characters of an object to the fonts it draws them with, or to any when it has no font attribute */
+static void font_subset_scan(const JsonObject& config, std::vector<font_subset_font_t>& fonts,
+                             std::vector<uint32_t>& any)
+{
+    std::vector<uint32_t> text;
+    std::vector<uint32_t> value;
+    std::vector<std::string> text_fonts;
+    std::vector<std::string> value_fonts;
+
+    for(JsonPair keyValue : config) {
+        const char* key = keyValue.key().c_str();
+        if(font_subset_is_key(key, PSTR("text")) || font_subset_is_key(key, PSTR("txt")) ||
+           font_subset_is_key(key, PSTR("options"))) {
+            font_subset_add_value(text, keyValue.value());
+        } else if(font_subset_is_key(key, PSTR("value_str"))) {
+            font_subset_add_value(value, keyValue.value());
+        } else if(font_subset_is_key(key, PSTR("text_font"))) {
+            text_fonts.push_back(keyValue.value().as<std::string>());
+        } else if(font_subset_is_key(key, PSTR("value_font"))) {
+            value_fonts.push_back(keyValue.value().as<std::string>());
+        }
+    }
+
+    if(text_fonts.empty()) any.insert(any.end(), text.begin(), text.end());
+    for(const std::string& name : text_fonts) {
+        std::vector<uint32_t>& letters = font_subset_find(fonts, name)->letters;
+        letters.insert(letters.end(), text.begin(), text.end());
+    }
+
+    if(value_fonts.empty()) any.insert(any.end(), value.begin(), value.end());
+    for(const std::string& name : value_fonts) {
+        std::vector<uint32_t>& letters = font_subset_find(fonts, name)->letters;
+        letters.insert(letters.end(), value.begin(), value.end());
+    }
+}
+
+/* ===== Font file ===== */
+
+static bool font_subset_read(File& file, uint32_t pos, void* buf, size_t len)
+{
+    return file.seek(pos) && file.read((uint8_t*)buf, len) == len;
+}
+
+/* Length of the table at pos, including its length and label */
+static int32_t font_subset_label(File& file, uint32_t pos, const char* label)
+{
+    uint8_t buf[8];
+    if(!font_subset_read(file, pos, buf, sizeof(buf)) || memcmp(buf + 4, label, 4)) return -1;
+
+    uint32_t length;
+    memcpy(&length, buf, sizeof(length));
+    return length >= sizeof(buf) ? length : -1;
+}
+
+static bool font_subset_table(File& file, uint32_t pos, const char* label, std::vector<uint8_t>& table)
+{
+    int32_t length = font_subset_label(file, pos, label);
+    if(length < 0) return false;
+
+    table.resize(length);
+    return font_subset_read(file, pos, table.data(), length);
+}
+
+static uint16_t font_subset_u16(const uint8_t* data)
+{
+    uint16_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+/* Same lookup as the fmt_txt fonts, in the cmap table as it is stored */
+static uint32_t font_subset_glyph_id(const std::vector<uint8_t>& cmap, uint32_t letter)
+{
+    uint32_t count;
+    memcpy(&count, cmap.data() + 8, sizeof(count));
+
+    for(uint32_t i = 0; i < count && 12 + (i + 1) * sizeof(cmap_table_bin_t) <= cmap.size(); i++) {
+        cmap_table_bin_t table;
+        memcpy(&table, cmap.data() + 12 + i * sizeof(cmap_table_bin_t), sizeof(table));
+
+        uint32_t rcp = letter - table.range_start;
+        if(rcp >= table.range_length) continue;
+
+        const uint8_t* data = cmap.data() + table.data_offset;
+        switch(table.format_type) {
+            case LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY:
+                return table.glyph_id_start + rcp;
+
+            case LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL:
+                if(table.data_offset + rcp >= cmap.size()) return 0;
+                return table.glyph_id_start + data[rcp];
+
+            case LV_FONT_FMT_TXT_CMAP_SPARSE_TINY:
+            case LV_FONT_FMT_TXT_CMAP_SPARSE_FULL: {
+                uint32_t entries = table.data_entries_count;
+                uint32_t needed  = entries * (table.format_type == LV_FONT_FMT_TXT_CMAP_SPARSE_FULL ? 4 : 2);
+                if(table.data_offset + needed > cmap.size()) return 0;
+
+                int32_t low  = 0;
+                int32_t high = entries - 1;
+                while(low <= high) {
+                    int32_t mid  = (low + high) / 2;
+                    uint16_t ofs = font_subset_u16(data + mid * 2);
+                    if(ofs == rcp) {
+                        if(table.format_type == LV_FONT_FMT_TXT_CMAP_SPARSE_TINY) return table.glyph_id_start + mid;
+                        return table.glyph_id_start + font_subset_u16(data + entries * 2 + mid * 2);
+                    }
+                    if(ofs < rcp)
+                        low = mid + 1;
+                    else
+                        high = mid - 1;
+                }
+                return 0;
+            }
+        }
+        return 0;
+    }
+    return 0;
+}
+
+static void font_subset_put(std::vector<uint8_t>& buf, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    buf.insert(buf.end(), bytes, bytes + len);
+}
+
+/* Table length and label, the length is set when the table is complete */
+static void font_subset_begin(std::vector<uint8_t>& buf, const char* label)
+{
+    buf.assign(8, 0);
+    memcpy(buf.data() + 4, label, 4);
+}
+
+static void font_subset_end(std::vector<uint8_t>& buf)
+{
+    buf.resize((buf.size() + 3) & ~3);
+    uint32_t length = buf.size();
+    memcpy(buf.data(), &length, sizeof(length));
+}
+
+/* The kern table of the glyphs that are kept, with the new glyph ids */
+static bool font_subset_kern(File& in, uint32_t pos, uint8_t id_format, uint32_t loca_count,
+                             const std::vector<uint32_t>& glyph_ids, std::vector<uint8_t>& kern)
+{
+    std::vector<uint8_t> table;
+    if(!font_subset_table(in, pos, "kern", table) || table.size() < 16) return false;
+
+    std::vector<uint16_t> new_ids(loca_count, 0);
+    for(size_t i = 1; i < glyph_ids.size(); i++) new_ids[glyph_ids[i]] = i;
+
+    font_subset_begin(kern, "kern");
+    font_subset_put(kern, table.data() + 8, 4); // format and padding
+
+    if(table[8] == 0) { // pairs of glyph ids sorted by the left and the right one
+        uint32_t count;
+        memcpy(&count, table.data() + 12, sizeof(count));
+        uint8_t size = id_format == 0 ? 1 : 2;
+        if(16 + (uint64_t)count * (2 * size + 1) > table.size()) return false;
+
+        const uint8_t* ids   = table.data() + 16;
+        const int8_t* values = (const int8_t*)(ids + count * 2 * size);
+        auto new_id          = [&](uint32_t n) -> uint32_t {
+            uint32_t gid = size == 1 ? ids[n] : font_subset_u16(ids + n * 2);
+            return gid < loca_count ? new_ids[gid] : 0;
+        };
+
+        std::vector<std::pair<uint32_t, int8_t>> pairs; // left << 16 | right
+        for(uint32_t i = 0; i < count; i++) {
+            uint32_t left  = new_id(i * 2);
+            uint32_t right = new_id(i * 2 + 1);
+            if(left && right) pairs.push_back(std::make_pair(left << 16 | right, values[i]));
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        uint32_t new_count = pairs.size();
+        font_subset_put(kern, &new_count, sizeof(new_count));
+        for(const auto& pair : pairs) {
+            uint16_t both[2] = {(uint16_t)(pair.first >> 16), (uint16_t)pair.first};
+            for(uint16_t id : both) font_subset_put(kern, &id, size); // little endian
+        }
+        for(const auto& pair : pairs) font_subset_put(kern, &pair.second, 1);
+
+    } else if(table[8] == 3) { // classes of the left and right glyph, the values are kept
+        uint16_t length = font_subset_u16(table.data() + 12);
+        uint8_t rows    = table[14];
+        uint8_t cols    = table[15];
+        if(16 + length * 2 + rows * cols > (int32_t)table.size()) return false;
+
+        uint16_t new_length = glyph_ids.size();
+        font_subset_put(kern, &new_length, sizeof(new_length));
+        font_subset_put(kern, &rows, 1);
+        font_subset_put(kern, &cols, 1);
+        for(uint32_t side = 0; side < 2; side++) {
+            const uint8_t* mapping = table.data() + 16 + side * length;
+            for(uint32_t gid : glyph_ids) kern.push_back(gid < length ? mapping[gid] : 0);
+        }
+        font_subset_put(kern, table.data() + 16 + length * 2, rows * cols);
+
+    } else {
+        return false;
+    }
+
+    font_subset_end(kern);
+    return true;
+}
+
+/* Copy the glyphs of the letters, renumbered in the order of the letters */
+static bool font_subset_write(File& in, File& out, const std::vector<uint32_t>& letters, font_subset_size_t* before,
+                              font_subset_size_t* after)
+{
+    std::vector<uint8_t> head;
+    std::vector<uint8_t> cmap;
+    if(!font_subset_table(in, 0, "head", head) || head.size() < 8 + sizeof(font_header_bin_t) ||
+       !font_subset_table(in, head.size(), "cmap", cmap) || cmap.size() < 12)
+        return false;
+
+    font_header_bin_t header;
+    memcpy(&header, head.data() + 8, sizeof(header));
+
+    uint32_t loca_start  = head.size() + cmap.size();
+    int32_t loca_length  = font_subset_label(in, loca_start, "loca");
+    uint32_t loca_count  = 0;
+    uint8_t offset_size  = header.index_to_loc_format == 0 ? 2 : 4;
+    uint32_t glyph_start = loca_start + loca_length;
+    int32_t glyph_length = loca_length < 0 ? -1 : font_subset_label(in, glyph_start, "glyf");
+    if(glyph_length < 0 || !font_subset_read(in, loca_start + 8, &loca_count, sizeof(loca_count)) ||
+       loca_count == 0)
+        return false;
+
+    /* Offsets of a glyph record and the next one */
+    auto glyph_offset = [&](uint32_t gid, uint32_t* offset) -> bool {
+        if(gid >= loca_count) {
+            *offset = glyph_length;
+            return true;
+        }
+        *offset = 0;
+        return font_subset_read(in, loca_start + 12 + gid * offset_size, offset, offset_size);
+    };
+
+    std::vector<uint32_t> glyph_ids(1, 0); // the empty glyph 0 stays first
+    std::vector<uint32_t> found;
+    for(uint32_t letter : letters) {
+        uint32_t gid = font_subset_glyph_id(cmap, letter);
+        if(gid == 0 || gid >= loca_count) continue;
+        found.push_back(letter);
+        glyph_ids.push_back(gid);
+    }
+
+    /* cmap: sparse subtables of letters within 64K of the first one, the glyph ids follow each other */
+    std::vector<cmap_table_bin_t> tables;
+    for(size_t i = 0; i < found.size();) {
+        size_t end = i;
+        while(end < found.size() && found[end] - found[i] < 0xFFFF) end++;
+
+        cmap_table_bin_t table;
+        memset(&table, 0, sizeof(table));
+        table.range_start        = found[i];
+        table.range_length       = found[end - 1] - found[i] + 1;
+        table.glyph_id_start     = i + 1;
+        table.data_entries_count = end - i;
+        table.format_type        = LV_FONT_FMT_TXT_CMAP_SPARSE_TINY;
+        tables.push_back(table);
+        i = end;
+    }
+
+    std::vector<uint8_t> new_cmap;
+    font_subset_begin(new_cmap, "cmap");
+    uint32_t count       = tables.size();
+    uint32_t data_offset = 12 + count * sizeof(cmap_table_bin_t);
+    font_subset_put(new_cmap, &count, sizeof(count));
+    for(cmap_table_bin_t& table : tables) {
+        table.data_offset = data_offset;
+        data_offset += table.data_entries_count * 2;
+        font_subset_put(new_cmap, &table, sizeof(table));
+    }
+    for(size_t t = 0, i = 0; t < tables.size(); t++) {
+        for(uint16_t n = 0; n < tables[t].data_entries_count; n++, i++) {
+            uint16_t ofs = found[i] - tables[t].range_start;
+            font_subset_put(new_cmap, &ofs, sizeof(ofs));
+        }
+    }
+    font_subset_end(new_cmap);
+
+    /* loca with 32 bit offsets */
+    std::vector<uint32_t> record_start;
+    std::vector<uint32_t> record_size;
+    std::vector<uint8_t> new_loca;
+    font_subset_begin(new_loca, "loca");
+    uint32_t new_count = glyph_ids.size();
+    uint32_t offset    = 8;
+    font_subset_put(new_loca, &new_count, sizeof(new_count));
+    for(uint32_t gid : glyph_ids) {
+        uint32_t start, next;
+        if(!glyph_offset(gid, &start) || !glyph_offset(gid + 1, &next) || next < start ||
+           next > (uint32_t)glyph_length)
+            return false;
+        record_start.push_back(start);
+        record_size.push_back(next - start);
+        font_subset_put(new_loca, &offset, sizeof(offset));
+        offset += next - start;
+    }
+    font_subset_end(new_loca);
+
+    std::vector<uint8_t> kern;
+    if(header.tables_count > 4 &&
+       !font_subset_kern(in, glyph_start + glyph_length, header.glyph_id_format, loca_count, glyph_ids, kern))
+        return false;
+
+    header.tables_count        = kern.empty() ? 4 : 5;
+    header.index_to_loc_format = 1;
+    memcpy(head.data() + 8, &header, sizeof(header));
+
+    uint32_t glyph_table = (offset + 3) & ~3;
+    uint8_t label[8];
+    memcpy(label, &glyph_table, sizeof(glyph_table));
+    memcpy(label + 4, "glyf", 4);
+
+    if(out.write(head.data(), head.size()) != head.size() ||
+       out.write(new_cmap.data(), new_cmap.size()) != new_cmap.size() ||
+       out.write(new_loca.data(), new_loca.size()) != new_loca.size() || out.write(label, 8) != 8)
+        return false;
+
+    uint8_t buffer[256];
+    for(size_t i = 0; i < record_start.size(); i++) {
+        for(uint32_t pos = 0; pos < record_size[i]; pos += sizeof(buffer)) {
+            size_t len = std::min<size_t>(sizeof(buffer), record_size[i] - pos);
+            if(!font_subset_read(in, glyph_start + record_start[i] + pos, buffer, len) ||
+               out.write(buffer, len) != len)
+                return false;
+        }
+    }
+    memset(buffer, 0, 4);
+    if(out.write(buffer, glyph_table - offset) != glyph_table - offset) return false;
+    if(!kern.empty() && out.write(kern.data(), kern.size()) != kern.size()) return false;
+
+    before->file   = in.size();
+    before->glyphs = loca_count;
+    before->ram    = loca_count * sizeof(lv_font_fmt_txt_glyph_dsc_t) + glyph_length + cmap.size();
+    after->file    = head.size() + new_cmap.size() + new_loca.size() + glyph_table + kern.size();
+    after->glyphs  = new_count;
+    after->ram     = new_count * sizeof(lv_font_fmt_txt_glyph_dsc_t) + glyph_table + new_cmap.size();
+    return true;
+}
+
+/* /<name>.bin, the full font it is made from and the subset that is written first */
+typedef struct
+{
+    char path[FONT_SUBSET_PATH_SIZE];
+    char original[FONT_SUBSET_PATH_SIZE + sizeof(FONT_SUBSET_ORIGINAL)];
+    char temp[FONT_SUBSET_PATH_SIZE + 4];
+} font_subset_paths_t;
+
+static bool font_subset_paths(const std::string& name, font_subset_paths_t* paths)
+{
+    if(snprintf_P(paths->path, sizeof(paths->path), PSTR("/%s.bin"), name.c_str()) >= (int)sizeof(paths->path))
+        return false;
+    snprintf_P(paths->original, sizeof(paths->original), PSTR("%s" FONT_SUBSET_ORIGINAL), paths->path);
+    snprintf_P(paths->temp, sizeof(paths->temp), PSTR("%s.tmp"), paths->path);
+    return true;
+}
+
+/* Worker: write /<name>.bin.tmp with the letters from /<name>.bin.orig, or from /<name>.bin on the first run */
+static bool font_subset_font(const font_subset_font_t& font, bool only_subset, font_subset_size_t* before,
+                             font_subset_size_t* after)
+{
+    font_subset_paths_t paths;
+    if(!font_subset_paths(font.name, &paths)) return false;
+
+    bool has_original = HASP_FS.exists(paths.original);
+    if(!has_original && (only_subset || !HASP_FS.exists(paths.path))) return false;
+
+    File in  = HASP_FS.open(has_original ? paths.original : paths.path, "r");
+    File out = HASP_FS.open(paths.temp, "w");
+    bool ok  = in && out && font_subset_write(in, out, font.letters, before, after);
+    if(in) in.close();
+    if(out) out.close();
+
+    if(!ok) {
+        HASP_FS.remove(paths.temp);
+        LOG_WARNING(TAG_FONT, F("Subset of %s failed"), paths.path);
+    }
+    return ok;
+}
+
+/* Worker: scan the pages file and write the subset of each font that has a .bin file */
+static void font_subset_pages(const char* pagesfile, bool only_subset, std::vector<font_subset_result_t>& results)
+{
+    File file = HASP_FS.open(pagesfile, "r");
+    if(!file) {
+        LOG_WARNING(TAG_FONT, F(D_FILE_NOT_FOUND ": %s"), pagesfile);
+        return;
+    }
+
+    std::vector<font_subset_font_t> fonts;
+    std::vector<uint32_t> any;
+    font_subset_add_text(any, FONT_SUBSET_KEEP);
+
+    file.setTimeout(25);
+    DynamicJsonDocument jsonl(MQTT_MAX_PACKET_SIZE / 2 + 128);
+    while(deserializeJson(jsonl, file) == DeserializationError::Ok) {
+        if(jsonl.is<JsonObject>()) font_subset_scan(jsonl.as<JsonObject>(), fonts, any);
+    }
+    file.close();
+
+    for(font_subset_font_t& font : fonts) {
+        font.letters.insert(font.letters.end(), any.begin(), any.end());
+        std::sort(font.letters.begin(), font.letters.end());
+        font.letters.erase(std::unique(font.letters.begin(), font.letters.end()), font.letters.end());
+
+        font_subset_result_t result;
+        result.name = font.name;
+        if(font_subset_font(font, only_subset, &result.before, &result.after)) results.push_back(result);
+    }
+}
+
+static void font_subset_worker(void* args)
+{
+    font_subset_pages(font_subset_file, font_subset_only, font_subset_results);
+    font_subset_done = true; // handed back to the GUI
+    vTaskDelete(NULL);
+}
+
+/* GUI: move the subset in place, a loaded .bin font may be reading glyphs from its file */
+static bool font_subset_apply(const font_subset_result_t& result)
+{
+    const char* name = result.name.c_str();
+    font_subset_paths_t paths;
+    font_subset_paths(result.name, &paths);
+
+    if(font_is_loaded(name)) font_clear_list(name); // frees it when no object uses it
+    if(font_is_loaded(name)) {
+        LOG_WARNING(TAG_FONT, F("Font %s is in use, subset skipped"), name);
+        HASP_FS.remove(paths.temp);
+        return false;
+    }
+
+    bool made_original = !HASP_FS.exists(paths.original); // first subset, keep the full font
+    bool ok            = !made_original || HASP_FS.rename(paths.path, paths.original);
+    if(ok && !filesystem_replace(HASP_FS, paths.temp, paths.path)) {
+        if(made_original) HASP_FS.rename(paths.original, paths.path); // keep the full font in use
+        ok = false;
+    }
+    if(!ok) {
+        HASP_FS.remove(paths.temp);
+        LOG_WARNING(TAG_FONT, F("Subset of %s failed"), paths.path);
+        return false;
+    }
+    filesystem_changed(paths.path);
+
+    char before_buf[16];
+    char after_buf[16];
+    Parser::format_bytes(result.before.file, before_buf, sizeof(before_buf));
+    Parser::format_bytes(result.after.file, after_buf, sizeof(after_buf));
+    LOG_INFO(TAG_FONT, F("Subset %s: %u of %u glyphs, file %s => %s"), name, result.after.glyphs,
+             result.before.glyphs, before_buf, after_buf);
+    return true;
+}
+
+static void font_subset_start(const char* pagesfile, bool only_subset);
+
+static void font_subset_poll(lv_task_t* task)
+{
+    if(!font_subset_done) return;
+
+    font_subset_size_t total_before = {0, 0, 0};
+    font_subset_size_t total_after  = {0, 0, 0};
+    uint8_t subset                  = 0;
+
+    for(const font_subset_result_t& result : font_subset_results) {
+        if(!font_subset_apply(result)) continue;
+        total_before.file += result.before.file;
+        total_before.ram += result.before.ram;
+        total_after.file += result.after.file;
+        total_after.ram += result.after.ram;
+        subset++;
+    }
+    std::vector<font_subset_result_t>().swap(font_subset_results);
+
+    if(subset > 0) {
+        char flash_buf[16];
+        char ram_buf[16];
+        Parser::format_bytes(total_before.file - total_after.file, flash_buf, sizeof(flash_buf));
+        Parser::format_bytes(total_before.ram - total_after.ram, ram_buf, sizeof(ram_buf));
+        LOG_INFO(TAG_FONT, F("Subset %u fonts: %s less flash once the " FONT_SUBSET_ORIGINAL " files are removed, "
+                             "%s less ram after a clearfont or restart"),
+                 subset, flash_buf, ram_buf);
+    }
+
+    lv_task_del(font_subset_poll_task);
+    font_subset_poll_task = NULL;
+    font_subset_done      = false;
+    if(font_subset_next[0]) { // requested while the worker was busy
+        font_subset_start(font_subset_next, font_subset_next_only);
+        font_subset_next[0] = '\0';
+    }
+}
+
+static void font_subset_start(const char* pagesfile, bool only_subset)
+{
+    if(strlen(pagesfile) >= sizeof(font_subset_file)) {
+        LOG_WARNING(TAG_FONT, F("Path too long: %s"), pagesfile);
+        return;
+    }
+    if(font_subset_poll_task) { // the worker is busy, run again when it is done
+        strcpy(font_subset_next, pagesfile);
+        font_subset_next_only = only_subset;
+        return;
+    }
+
+    strcpy(font_subset_file, pagesfile);
+    font_subset_only = only_subset;
+    font_subset_done = false;
+    if(xTaskCreate(font_subset_worker, "fontSubset", FONT_SUBSET_STACK_SIZE, NULL, 1, NULL) != pdPASS) {
+        LOG_ERROR(TAG_FONT, F("Create task for font subset failed"));
+        return;
+    }
+    font_subset_poll_task = lv_task_create(font_subset_poll, FONT_SUBSET_POLL_INTERVAL, LV_TASK_PRIO_LOWEST, NULL);
+}
+
+void font_subset_file_changed(const char* path)
+{
+    if(strcmp(path, haspPagesPath)) return; // the fonts follow the pages that are loaded at startup
+    font_subset_start(path, true);
+}
+
+void font_subset_command(const char*, const char* payload, uint8_t source)
+{
+    font_subset_start(payload && *payload ? payload : haspPagesPath, false);
+}
+
+#endif
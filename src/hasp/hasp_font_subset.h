@@ -0,0 +1,40 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_FONT_SUBSET_H
+#define HASP_FONT_SUBSET_H
+
+#if HASP_USE_FONT_SUBSET > 0
+
+/* Binary fonts reduced to the characters used in a pages file
+ *
+ * The pages file is scanned for the text, txt, options and value_str attributes and the font each of them is
+ * drawn with, from text_font and value_font. Objects without a font attribute count for every font. For each
+ * font with a <name>.bin file a .bin in the same format is written with only those characters and the
+ * FONT_SUBSET_KEEP characters, the MDI icons in the text included, and the kerning pairs between them.
+ * The original is kept as <name>.bin.orig and used for the next subset, fonts that have one are subset again
+ * when the pages file of the configuration is uploaded.
+ * A worker task writes the subsets to <name>.bin.tmp, the GUI then moves them in place. A font that is loaded is
+ * freed first, one that is still used by an object keeps its file and is skipped.
+ * tools/hasp_font_subset.py does the same on the computer.
+ */
+
+#ifndef FONT_SUBSET_KEEP
+#define FONT_SUBSET_KEEP " 0123456789.,:;-+/%\xC2\xB0" // characters of values set at runtime, UTF-8
+#endif
+
+#ifndef FONT_SUBSET_STACK_SIZE
+#define FONT_SUBSET_STACK_SIZE (8 * 1024) // pages file parser
+#endif
+#ifndef FONT_SUBSET_POLL_INTERVAL
+#define FONT_SUBSET_POLL_INTERVAL 250 // [ms] only while the worker runs
+#endif
+
+#define FONT_SUBSET_ORIGINAL ".orig" // suffix of the full font file
+
+/* ===== Special Event Processors ===== */
+void font_subset_file_changed(const char* path); // path on the filesystem without the drive letter
+void font_subset_command(const char*, const char* payload, uint8_t source); // pages file, default the config
+
+#endif
+#endif
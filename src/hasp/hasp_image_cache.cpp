@@ -0,0 +1,391 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if HASP_USE_IMAGE_CACHE > 0
+
+#include "src/lv_misc/lv_gc.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "soc/soc_memory_layout.h"
+#endif
+
+#include "hasp_debug.h"
+
+/* Decoded image, kept open with the decoder that produced it */
+typedef struct image_cache_entry_t
+{
+    struct image_cache_entry_t* next; // most recently used first
+    lv_img_decoder_dsc_t dsc;         // open descriptor of the actual decoder, src is a copy for files
+    uint32_t size;                    // decoded bytes
+    uint16_t refs;                    // lvgl descriptors using the pixels
+    bool psram;
+    bool stale; // invalidated while in use, freed by the last close
+} image_cache_entry_t;
+
+/* Downloaded image descriptor, the url is stored behind it */
+typedef struct image_cache_src_t
+{
+    struct image_cache_src_t* next;
+    lv_img_dsc_t* img_dsc;
+    uint16_t refs; // image objects showing it
+    bool shared;   // found by its url, false after it was reloaded
+} image_cache_src_t;
+
+static lv_img_decoder_t* image_cache_decoder;
+static image_cache_entry_t* image_cache_head;
+static image_cache_src_t* image_cache_src_head;
+
+static uint32_t image_cache_used[2]; // internal ram and psram
+static uint32_t image_cache_hits;
+static uint32_t image_cache_misses;
+static uint32_t image_cache_evictions;
+
+static inline uint32_t image_cache_budget(bool psram)
+{
+    return psram ? IMAGE_CACHE_SIZE_PSRAM : IMAGE_CACHE_SIZE;
+}
+
+static inline bool image_cache_in_psram(const void* ptr)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return esp_ptr_external_ram(ptr);
+#else
+    return false;
+#endif
+}
+
+/* Where the decoders allocate, see hasp_malloc */
+static inline bool image_cache_psram_default()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return hasp_use_psram();
+#else
+    return false;
+#endif
+}
+
+static uint32_t image_cache_data_size(const lv_img_header_t* header)
+{
+    uint32_t px = (uint32_t)header->w * header->h;
+    switch(header->cf) {
+        case LV_IMG_CF_RAW_ALPHA: // decoded with an alpha byte per pixel
+            return px * LV_IMG_PX_SIZE_ALPHA_BYTE;
+        case LV_IMG_CF_RAW:
+        case LV_IMG_CF_RAW_CHROMA_KEYED:
+            return px * sizeof(lv_color_t);
+        default:
+            return lv_img_buf_get_img_size(header->w, header->h, header->cf);
+    }
+}
+
+static inline lv_img_decoder_t* image_cache_next_decoder(lv_img_decoder_t* decoder)
+{
+    if(!decoder) return (lv_img_decoder_t*)_lv_ll_get_head(&LV_GC_ROOT(_lv_img_defoder_ll));
+    return (lv_img_decoder_t*)_lv_ll_get_next(&LV_GC_ROOT(_lv_img_defoder_ll), decoder);
+}
+
+static bool image_cache_match(const image_cache_entry_t* entry, const void* src, lv_img_src_t src_type)
+{
+    if(entry->dsc.src_type != src_type) return false;
+    if(src_type == LV_IMG_SRC_FILE) return !strcmp((const char*)entry->dsc.src, (const char*)src);
+    return entry->dsc.src == src;
+}
+
+/* Find the entry of src and make it the most recently used */
+static image_cache_entry_t* image_cache_find(const void* src, lv_img_src_t src_type)
+{
+    image_cache_entry_t** link = &image_cache_head;
+    for(image_cache_entry_t* entry = image_cache_head; entry; link = &entry->next, entry = entry->next) {
+        if(!image_cache_match(entry, src, src_type)) continue;
+
+        *link            = entry->next;
+        entry->next      = image_cache_head;
+        image_cache_head = entry;
+        return entry;
+    }
+    return NULL;
+}
+
+static void image_cache_free(image_cache_entry_t* entry)
+{
+    lv_img_decoder_t* decoder = entry->dsc.decoder;
+    if(decoder->close_cb) decoder->close_cb(decoder, &entry->dsc);
+    if(entry->dsc.src_type == LV_IMG_SRC_FILE) lv_mem_free(entry->dsc.src);
+
+    image_cache_used[entry->psram] -= entry->size;
+    lv_mem_free(entry);
+}
+
+/* Remove the entry from the list, it is freed now or by its last close */
+static void image_cache_remove(image_cache_entry_t** link)
+{
+    image_cache_entry_t* entry = *link;
+    *link                      = entry->next;
+
+    if(entry->refs > 0)
+        entry->stale = true;
+    else
+        image_cache_free(entry);
+}
+
+/* Close the least recently used images that are not in use until size bytes fit in the budget */
+static bool image_cache_evict(bool psram, uint32_t size)
+{
+    if(size > image_cache_budget(psram)) return false;
+
+    while(image_cache_used[psram] + size > image_cache_budget(psram)) {
+        image_cache_entry_t** victim = NULL;
+        for(image_cache_entry_t** link = &image_cache_head; *link; link = &(*link)->next) {
+            if((*link)->refs == 0 && (*link)->psram == psram) victim = link;
+        }
+        if(!victim) return false; // all images are in use
+
+        LOG_DEBUG(TAG_IMG, F("Evicted %u bytes"), (*victim)->size);
+        image_cache_remove(victim);
+        image_cache_evictions++;
+    }
+    return true;
+}
+
+static image_cache_entry_t* image_cache_add(const lv_img_decoder_dsc_t* dsc, uint32_t size)
+{
+    bool psram = image_cache_in_psram(dsc->img_data);
+    if(!image_cache_evict(psram, size)) return NULL;
+
+    image_cache_entry_t* entry = (image_cache_entry_t*)lv_mem_alloc(sizeof(image_cache_entry_t));
+    if(!entry) return NULL;
+
+    entry->dsc = *dsc;
+    if(dsc->src_type == LV_IMG_SRC_FILE) { // lvgl frees its copy of the path on close
+        size_t len = strlen((const char*)dsc->src) + 1;
+        char* path = (char*)lv_mem_alloc(len);
+        if(!path) {
+            lv_mem_free(entry);
+            return NULL;
+        }
+        memcpy(path, dsc->src, len);
+        entry->dsc.src = path;
+    }
+
+    entry->size      = size;
+    entry->refs      = 1;
+    entry->psram     = psram;
+    entry->stale     = false;
+    entry->next      = image_cache_head;
+    image_cache_head = entry;
+    image_cache_used[psram] += size;
+    return entry;
+}
+
+static lv_res_t image_cache_decoder_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+    image_cache_entry_t* entry = image_cache_find(src, lv_img_src_get_type(src));
+    if(entry) {
+        *header = entry->dsc.header;
+        return LV_RES_OK;
+    }
+
+    for(lv_img_decoder_t* d = image_cache_next_decoder(NULL); d; d = image_cache_next_decoder(d)) {
+        if(d != decoder && d->info_cb && d->open_cb && d->info_cb(d, src, header) == LV_RES_OK) return LV_RES_OK;
+    }
+    return LV_RES_INV;
+}
+
+/* Open src with the decoder that supports it and keep the decoded pixels */
+static lv_res_t image_cache_decoder_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    image_cache_entry_t* entry = image_cache_find(dsc->src, dsc->src_type);
+    if(entry) {
+        image_cache_hits++;
+        entry->refs++;
+        dsc->header    = entry->dsc.header;
+        dsc->img_data  = entry->dsc.img_data;
+        dsc->user_data = entry;
+        return LV_RES_OK;
+    }
+
+    lv_img_decoder_t* built_in = (lv_img_decoder_t*)_lv_ll_get_tail(&LV_GC_ROOT(_lv_img_defoder_ll));
+
+    for(lv_img_decoder_t* d = image_cache_next_decoder(NULL); d; d = image_cache_next_decoder(d)) {
+        if(d == decoder || !d->info_cb || !d->open_cb) continue;
+
+        lv_img_decoder_dsc_t inner = *dsc;
+        if(d->info_cb(d, dsc->src, &inner.header) != LV_RES_OK) continue;
+
+        // The built-in decoder uses the data of the variable or reads .bin files per line
+        bool cacheable = d != built_in;
+        uint32_t size  = image_cache_data_size(&inner.header);
+        if(cacheable) image_cache_evict(image_cache_psram_default(), size); // make room before decoding
+
+        inner.decoder   = d;
+        inner.img_data  = NULL;
+        inner.error_msg = NULL;
+        inner.user_data = NULL;
+        if(d->open_cb(d, &inner) != LV_RES_OK) continue;
+
+        image_cache_misses++;
+        if(cacheable && inner.img_data) entry = image_cache_add(&inner, size);
+
+        if(entry) {
+            dsc->header    = inner.header;
+            dsc->img_data  = inner.img_data;
+            dsc->user_data = entry;
+        } else {
+            *dsc = inner; // not kept, lvgl uses the decoder directly
+        }
+        return LV_RES_OK;
+    }
+
+    return LV_RES_INV;
+}
+
+static void image_cache_decoder_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    image_cache_entry_t* entry = (image_cache_entry_t*)dsc->user_data;
+    if(!entry || entry->refs == 0) return;
+
+    entry->refs--;
+    if(entry->refs == 0 && entry->stale) image_cache_free(entry);
+}
+
+void image_cache_init(void)
+{
+    // Created last, so it is the first decoder lvgl tries
+    image_cache_decoder = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(image_cache_decoder, image_cache_decoder_info);
+    lv_img_decoder_set_open_cb(image_cache_decoder, image_cache_decoder_open);
+    lv_img_decoder_set_close_cb(image_cache_decoder, image_cache_decoder_close);
+}
+
+void image_cache_invalidate(const void* src)
+{
+    lv_img_src_t src_type = src ? lv_img_src_get_type(src) : LV_IMG_SRC_UNKNOWN;
+
+    image_cache_entry_t** link = &image_cache_head;
+    while(*link) {
+        if(src && !image_cache_match(*link, src, src_type))
+            link = &(*link)->next;
+        else
+            image_cache_remove(link);
+    }
+}
+
+void image_cache_invalidate_file(const char* path)
+{
+    bool in_use = false;
+
+    image_cache_entry_t** link = &image_cache_head;
+    while(*link) {
+        const char* src = (const char*)(*link)->dsc.src;
+        if((*link)->dsc.src_type == LV_IMG_SRC_FILE && src[0] && src[1] == ':' && !strcmp(src + 2, path)) {
+            if((*link)->refs > 0) in_use = true;
+            image_cache_remove(link);
+        } else {
+            link = &(*link)->next;
+        }
+    }
+
+    // Shown images are held open by the lvgl cache, closing them frees the stale entries
+    if(in_use) lv_img_cache_invalidate_src(NULL);
+}
+
+void image_cache_trim(void)
+{
+    image_cache_entry_t** link = &image_cache_head;
+    while(*link) {
+        if((*link)->refs > 0) {
+            link = &(*link)->next;
+        } else {
+            image_cache_remove(link);
+            image_cache_evictions++;
+        }
+    }
+}
+
+/* A descriptor loaded by another object, unless it is the one current already shows */
+lv_img_dsc_t* image_cache_get_src(const char* url, const void* current)
+{
+    for(image_cache_src_t* node = image_cache_src_head; node; node = node->next) {
+        if(!node->shared || strcmp(url, (const char*)node->img_dsc + sizeof(lv_img_dsc_t))) continue;
+        if(node->img_dsc == current) return NULL; // setting the same url again reloads it
+
+        node->refs++;
+        return node->img_dsc;
+    }
+    return NULL;
+}
+
+void image_cache_add_src(lv_img_dsc_t* img_dsc)
+{
+    const char* url = (const char*)img_dsc + sizeof(lv_img_dsc_t);
+
+    // A reloaded image replaces the previous descriptor for the objects that set it from now on
+    for(image_cache_src_t* node = image_cache_src_head; node; node = node->next) {
+        if(node->shared && !strcmp(url, (const char*)node->img_dsc + sizeof(lv_img_dsc_t))) node->shared = false;
+    }
+
+    image_cache_src_t* node = (image_cache_src_t*)lv_mem_alloc(sizeof(image_cache_src_t));
+    if(!node) return; // not shared, freed by its object
+
+    node->img_dsc        = img_dsc;
+    node->refs           = 1;
+    node->shared         = true;
+    node->next           = image_cache_src_head;
+    image_cache_src_head = node;
+}
+
+bool image_cache_release_src(const lv_img_dsc_t* img_dsc)
+{
+    for(image_cache_src_t** link = &image_cache_src_head; *link; link = &(*link)->next) {
+        image_cache_src_t* node = *link;
+        if(node->img_dsc != img_dsc) continue;
+
+        if(--node->refs > 0) return false;
+        *link = node->next;
+        lv_mem_free(node);
+        return true;
+    }
+    return true; // not shared
+}
+
+void image_cache_get_info(JsonDocument& doc)
+{
+    char size_buf[32];
+    char budget_buf[16];
+    uint16_t entries = 0;
+    uint16_t in_use  = 0;
+    uint16_t shared  = 0;
+
+    for(image_cache_entry_t* entry = image_cache_head; entry; entry = entry->next) {
+        entries++;
+        if(entry->refs > 0) in_use++;
+    }
+    for(image_cache_src_t* node = image_cache_src_head; node; node = node->next) shared++;
+
+    JsonObject info = doc.createNestedObject(F("Image Cache"));
+    snprintf_P(size_buf, sizeof(size_buf), PSTR("%u (%u in use)"), entries, in_use);
+    info[F("Images")]    = size_buf;
+    info[F("Hits")]      = image_cache_hits;
+    info[F("Misses")]    = image_cache_misses;
+    info[F("Evictions")] = image_cache_evictions;
+
+    Parser::format_bytes(image_cache_used[0], size_buf, sizeof(size_buf));
+    Parser::format_bytes(image_cache_budget(false), budget_buf, sizeof(budget_buf));
+    strncat(size_buf, " / ", sizeof(size_buf) - strlen(size_buf) - 1);
+    strncat(size_buf, budget_buf, sizeof(size_buf) - strlen(size_buf) - 1);
+    info[F("Internal RAM")] = size_buf;
+
+    if(image_cache_psram_default()) {
+        Parser::format_bytes(image_cache_used[1], size_buf, sizeof(size_buf));
+        Parser::format_bytes(image_cache_budget(true), budget_buf, sizeof(budget_buf));
+        strncat(size_buf, " / ", sizeof(size_buf) - strlen(size_buf) - 1);
+        strncat(size_buf, budget_buf, sizeof(size_buf) - strlen(size_buf) - 1);
+        info[F("PSRAM")] = size_buf;
+    }
+
+    info[F("Shared Downloads")] = shared;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_IMAGE_CACHE_H
+#define HASP_IMAGE_CACHE_H
+
+#if HASP_USE_IMAGE_CACHE > 0
+
+/* Decoded images shared by all image objects
+ *
+ * A decoder is registered in front of the other decoders. It opens an image with the decoder that supports it
+ * and keeps the decoded pixels open after lvgl closes it, so the next object or page using the same source
+ * gets the pixels without decoding again. Entries are counted by the lvgl descriptors that use them
+ * and only unused entries are closed, least recently used first, when the budget of their memory is exceeded.
+ * Images that are not decoded into one buffer, like split jpg or large images read per line, are passed on to their decoder.
+ *
+ * Downloaded images are also shared: objects with the same url get the same descriptor
+ * and it is only freed when the last object releases it.
+ */
+
+#ifndef IMAGE_CACHE_SIZE
+#define IMAGE_CACHE_SIZE (32 * 1024) // decoded bytes in internal ram
+#endif
+#ifndef IMAGE_CACHE_SIZE_PSRAM
+#define IMAGE_CACHE_SIZE_PSRAM (1024 * 1024) // decoded bytes in psram
+#endif
+
+/* ===== Default Event Processors ===== */
+void image_cache_init(void);
+
+/* ===== Special Event Processors ===== */
+void image_cache_invalidate(const void* src);      // descriptor or file source, NULL for all
+void image_cache_invalidate_file(const char* path); // path on the filesystem without the drive letter
+void image_cache_trim(void);                        // close all unused images
+
+/* ===== Shared Image Descriptors ===== */
+lv_img_dsc_t* image_cache_get_src(const char* url, const void* current); // adds a reference
+void image_cache_add_src(lv_img_dsc_t* img_dsc);                         // url behind the descriptor
+bool image_cache_release_src(const lv_img_dsc_t* img_dsc);               // true when it can be freed
+
+/* ===== Getter and Setter Functions ===== */
+void image_cache_get_info(JsonDocument& doc);
+
+#endif
+#endif
@@ -0,0 +1,645 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if HASP_USE_IMAGE_FETCH > 0
+
+#if HASP_USE_WIFI > 0 || HASP_USE_ETHERNET > 0
+#include <HTTPClient.h>
+#endif
+
+#include "rom/crc.h"
+
+#include "hasp_debug.h"
+#include "hasp_filesystem.h"
+
+#define IMAGE_FETCH_CACHE (IMAGE_FETCH_CACHE_FILE_SIZE > 0 && (HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0))
+
+enum : uint8_t { FETCH_FREE, FETCH_QUEUED, FETCH_LOADING, FETCH_DONE, FETCH_FAILED };
+
+/* The GUI owns a free, done or failed job, the worker a queued or loading one */
+typedef struct
+{
+    lv_obj_t* obj;
+    char* url;
+    volatile uint8_t state;
+    volatile bool cancelled; // the object was deleted or got another src
+    bool convert;            // url is a file on the filesystem to convert to .bin, there is no object
+    uint8_t* data;           // loaded image, until the descriptor is made
+    uint32_t data_size;
+    lv_img_header_t header;
+} image_fetch_job_t;
+
+static image_fetch_job_t image_fetch_jobs[IMAGE_FETCH_MAX_JOBS];
+static QueueHandle_t image_fetch_queue;
+static TaskHandle_t image_fetch_task;
+static lv_task_t* image_fetch_poll_task;
+
+/* Collects a chunked response body, writing fails when the job is cancelled */
+class ImageFetchBuffer : public Stream {
+  public:
+    ImageFetchBuffer(image_fetch_job_t* job) : _job(job), _buf(NULL), _len(0), _size(0), _pos(0)
+    {}
+    ~ImageFetchBuffer()
+    {
+        hasp_free(_buf);
+    }
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t* buf, size_t size) override
+    {
+        if(_job->cancelled || !reserve(_len + size)) return 0;
+        memcpy(_buf + _len, buf, size);
+        _len += size;
+        return size;
+    }
+    int available() override
+    {
+        return _len - _pos;
+    }
+    int read() override
+    {
+        return _pos < _len ? _buf[_pos++] : -1;
+    }
+    int peek() override
+    {
+        return _pos < _len ? _buf[_pos] : -1;
+    }
+    size_t readBytes(char* buffer, size_t length) override
+    {
+        length = min(length, _len - _pos);
+        memcpy(buffer, _buf + _pos, length);
+        _pos += length;
+        return length;
+    }
+
+    bool reserve(size_t size)
+    {
+        if(size <= _size) return true;
+        if(size > IMAGE_FETCH_MAX_SIZE) {
+            LOG_ERROR(TAG_IMG, F("Response is larger than %u bytes"), IMAGE_FETCH_MAX_SIZE);
+            return false;
+        }
+
+        size_t grow  = max(size, min(_size * 2, (size_t)IMAGE_FETCH_MAX_SIZE));
+        uint8_t* buf = (uint8_t*)hasp_realloc(_buf, grow);
+        if(!buf) {
+            LOG_ERROR(TAG_IMG, F(D_ERROR_OUT_OF_MEMORY));
+            return false;
+        }
+        _buf  = buf;
+        _size = grow;
+        return true;
+    }
+
+    size_t length()
+    {
+        return _len;
+    }
+
+  private:
+    image_fetch_job_t* _job;
+    uint8_t* _buf;
+    size_t _len;
+    size_t _size;
+    size_t _pos; // read by the decoder
+};
+
+/* Body of a response or file for the decoder, stops at its length or when the job is cancelled.
+ * A download can be copied to the cache file while it is decoded. */
+class ImageFetchInput : public Stream {
+  public:
+    ImageFetchInput(image_fetch_job_t* job, Stream& in, size_t len) : _job(job), _in(in), _left(len), _copy_ok(false)
+    {}
+
+    void copy_to(File& file)
+    {
+        _copy    = file;
+        _copy_ok = (bool)file;
+    }
+
+    size_t readBytes(char* buffer, size_t length) override
+    {
+        if(_job->cancelled) return 0;
+        size_t len = _in.readBytes(buffer, min(length, _left));
+        _left -= len;
+        if(_copy_ok && _copy.write((const uint8_t*)buffer, len) != len) _copy_ok = false;
+        return len;
+    }
+    int read() override
+    {
+        char c;
+        return readBytes(&c, 1) == 1 ? (uint8_t)c : -1;
+    }
+    int available() override
+    {
+        return _job->cancelled ? 0 : min((size_t)max(_in.available(), 0), _left);
+    }
+    int peek() override
+    {
+        return -1;
+    }
+    size_t write(uint8_t c) override
+    {
+        return 0;
+    }
+
+    /* Copy what the decoder left, like the last PNG chunks, true when the copy is complete */
+    bool finish_copy()
+    {
+        char buf[256];
+        while(_copy_ok && _left > 0 && readBytes(buf, sizeof(buf)) > 0) {
+        }
+        return _copy_ok && _left == 0 && !_job->cancelled;
+    }
+
+  private:
+    image_fetch_job_t* _job;
+    Stream& _in;
+    size_t _left;
+    bool _copy_ok;
+    File _copy;
+};
+
+/* ===== Worker ===== */
+
+/* Decode the image while it is read, PNG and JPEG straight into the native format */
+static bool image_fetch_decode(image_fetch_job_t* job, ImageFetchInput& in)
+{
+    job->data = image_stream_decode(in, &job->header, &job->data_size);
+    if(!job->data && !job->cancelled) LOG_ERROR(TAG_IMG, F("Decoding %s failed"), job->url);
+    return job->data != NULL;
+}
+
+static bool image_fetch_file(image_fetch_job_t* job, fs::FS& fs, const char* path)
+{
+    char native[64];
+    File file;
+    if(image_stream_native_path(path, native, sizeof(native)) && fs.exists(native)) file = fs.open(native, FILE_READ);
+    if(!file) file = fs.open(path, FILE_READ);
+    if(!file) {
+        LOG_WARNING(TAG_IMG, F(D_FILE_NOT_FOUND ": %s"), path);
+        return false;
+    }
+
+    ImageFetchInput in(job, file, file.size());
+    bool ok = image_fetch_decode(job, in);
+    file.close();
+    return ok;
+}
+
+#if IMAGE_STREAM_CONVERT > 0
+/* Write the .bin of a png or jpg file, to a temporary file first so it is never read half written */
+static bool image_fetch_convert_file(image_fetch_job_t* job)
+{
+    char target[64];
+    char temp[64];
+    if(!image_stream_native_path(job->url, target, sizeof(target))) return false;
+    snprintf_P(temp, sizeof(temp), PSTR("%s.tmp"), job->url);
+
+    File in = HASP_FS.open(job->url, FILE_READ);
+    if(!in) return false;
+
+    // The .bin can be much larger than the png or jpg, it must not fill up the filesystem
+    lv_img_header_t header;
+    size_t needed = 0;
+    if(image_stream_info(in, &header))
+        needed = image_stream_convert_size(&header, IMAGE_STREAM_CONVERT_RLE) + IMAGE_STREAM_CONVERT_RESERVE;
+    in.seek(0);
+    if(needed == 0 || HASP_FS.totalBytes() - HASP_FS.usedBytes() < needed) {
+        if(needed > 0) LOG_WARNING(TAG_IMG, F("Not enough space to convert %s, %u bytes needed"), job->url, needed);
+        in.close();
+        return false;
+    }
+
+    File out = HASP_FS.open(temp, FILE_WRITE);
+    if(!out) {
+        in.close();
+        return false;
+    }
+
+    uint32_t start = millis();
+    ImageFetchInput input(job, in, in.size());
+    bool ok     = image_stream_convert(input, out, IMAGE_STREAM_CONVERT_RLE);
+    size_t size = out.size();
+    in.close();
+    out.close();
+
+    if(ok && !job->cancelled) ok = filesystem_replace(HASP_FS, temp, target);
+    if(!ok) {
+        HASP_FS.remove(temp);
+        LOG_WARNING(TAG_IMG, F("Converting %s failed"), job->url);
+        return false;
+    }
+
+    LOG_TRACE(TAG_IMG, F("Converted %s in %u ms, %u bytes"), target, millis() - start, size);
+    return true;
+}
+#endif
+
+#if IMAGE_FETCH_CACHE
+static void image_fetch_cache_path(char* path, size_t size, const char* url, const char* ext)
+{
+    uint32_t hash = crc32_le(0, (const uint8_t*)url, strlen(url));
+    snprintf_P(path, size, PSTR(IMAGE_FETCH_CACHE_DIR "/%08x.%s"), hash, ext);
+}
+
+/* Remove the oldest downloads until size more bytes fit in IMAGE_FETCH_CACHE_SIZE, and any leftover temporary files.
+ * Only the worker writes the cache, so nothing is being written while the folder is walked. */
+static bool image_fetch_cache_trim(size_t size)
+{
+    if(size > IMAGE_FETCH_CACHE_SIZE) return false;
+
+    while(true) {
+        File dir = HASP_FS.open(IMAGE_FETCH_CACHE_DIR);
+        if(!dir || !dir.isDirectory()) return true;
+
+        char oldest[40] = "";
+        time_t oldest_time = 0;
+        size_t total       = 0;
+        File file          = dir.openNextFile();
+        while(file) {
+            String path = file.path();
+            if(path.endsWith(".tmp")) { // interrupted download
+                file.close();
+                HASP_FS.remove(path);
+            } else {
+                total += file.size();
+                if(!oldest[0] || file.getLastWrite() < oldest_time) {
+                    strncpy(oldest, path.c_str(), sizeof(oldest) - 1);
+                    oldest_time = file.getLastWrite();
+                }
+                file.close();
+            }
+            file = dir.openNextFile();
+        }
+        dir.close();
+
+        if(total + size <= IMAGE_FETCH_CACHE_SIZE || !oldest[0]) return true;
+        LOG_VERBOSE(TAG_IMG, F("Removing %s from the cache"), oldest);
+        if(!HASP_FS.remove(oldest)) return false;
+    }
+}
+
+/* Temporary file for the body with the url and its validators, it is written while the image is decoded */
+static File image_fetch_cache_begin(const char* url, const String& etag, const String& modified, size_t size)
+{
+    if(etag.length() == 0 && modified.length() == 0) return File(); // can not be validated
+    if(size > IMAGE_FETCH_CACHE_FILE_SIZE) return File();
+    if(!image_fetch_cache_trim(size + strlen(url) + etag.length() + modified.length() + 3)) return File();
+    if(HASP_FS.totalBytes() - HASP_FS.usedBytes() < size + 8192) return File(); // leave room for the user files
+
+    char temp[40];
+    image_fetch_cache_path(temp, sizeof(temp), url, "tmp");
+
+    if(!HASP_FS.exists(IMAGE_FETCH_CACHE_DIR)) HASP_FS.mkdir(IMAGE_FETCH_CACHE_DIR);
+    File file = HASP_FS.open(temp, FILE_WRITE);
+    if(!file) return file;
+
+    file.print(url);
+    file.print('\n');
+    file.print(etag);
+    file.print('\n');
+    file.print(modified);
+    file.print('\n');
+    return file;
+}
+
+/* Replace the cached copy only with a complete body */
+static void image_fetch_cache_end(const char* url, File& file, bool ok)
+{
+    if(!file) return;
+    file.close();
+
+    char path[40];
+    char temp[40];
+    image_fetch_cache_path(path, sizeof(path), url, "img");
+    image_fetch_cache_path(temp, sizeof(temp), url, "tmp");
+
+    if(ok) ok = filesystem_replace(HASP_FS, temp, path);
+    if(!ok) HASP_FS.remove(temp);
+}
+
+/* Read the validators of the cached copy, false if there is none */
+static bool image_fetch_cache_validators(const char* url, String& etag, String& modified)
+{
+    char path[40];
+    image_fetch_cache_path(path, sizeof(path), url, "img");
+
+    File file = HASP_FS.open(path, FILE_READ);
+    if(!file) return false;
+
+    bool found = file.readStringUntil('\n') == url; // not a file of another url with the same hash
+    etag       = file.readStringUntil('\n');
+    modified   = file.readStringUntil('\n');
+    file.close();
+    return found;
+}
+
+static bool image_fetch_cache_read(image_fetch_job_t* job)
+{
+    char path[40];
+    image_fetch_cache_path(path, sizeof(path), job->url, "img");
+
+    File file = HASP_FS.open(path, FILE_READ);
+    if(!file) return false;
+
+    file.readStringUntil('\n'); // url and validators
+    file.readStringUntil('\n');
+    file.readStringUntil('\n');
+
+    ImageFetchInput in(job, file, file.available());
+    bool ok = image_fetch_decode(job, in);
+    file.close();
+    return ok;
+}
+#endif // IMAGE_FETCH_CACHE
+
+static bool image_fetch_http(image_fetch_job_t* job)
+{
+#if HASP_USE_WIFI > 0 || HASP_USE_ETHERNET > 0
+    HTTPClient http;
+    http.begin(job->url);
+    http.setTimeout(IMAGE_FETCH_TIMEOUT);
+    http.setConnectTimeout(IMAGE_FETCH_TIMEOUT);
+
+    const char* headers[] = {"ETag", "Last-Modified"};
+    http.collectHeaders(headers, sizeof(headers) / sizeof(headers[0]));
+
+    bool cached = false;
+#if IMAGE_FETCH_CACHE
+    String etag;
+    String modified;
+    cached = image_fetch_cache_validators(job->url, etag, modified);
+    if(cached && etag.length() > 0) http.addHeader(F("If-None-Match"), etag);
+    if(cached && modified.length() > 0) http.addHeader(F("If-Modified-Since"), modified);
+#endif
+
+    int code = http.GET();
+    if(code == HTTP_CODE_OK && http.getStreamPtr()) {
+        // A body of known length is decoded from the connection, a chunked one is collected first
+        ImageFetchBuffer body(job);
+        Stream* stream = http.getStreamPtr();
+        int size       = http.getSize();
+        bool ok        = true;
+        if(size < 0) {
+            ok     = http.writeToStream(&body) >= 0;
+            stream = &body;
+            size   = body.length();
+        }
+
+        ImageFetchInput in(job, *stream, size);
+#if IMAGE_FETCH_CACHE
+        File copy = image_fetch_cache_begin(job->url, http.header("ETag"), http.header("Last-Modified"), size);
+        in.copy_to(copy);
+#endif
+        ok = ok && image_fetch_decode(job, in);
+#if IMAGE_FETCH_CACHE
+        image_fetch_cache_end(job->url, copy, ok && in.finish_copy());
+#endif
+        http.end();
+        if(!ok && !job->cancelled) LOG_ERROR(TAG_IMG, F("Download of %s failed"), job->url);
+        return ok;
+    }
+    http.end();
+
+#if IMAGE_FETCH_CACHE
+    if(cached && code == HTTP_CODE_NOT_MODIFIED) return image_fetch_cache_read(job);
+    if(cached && code < 0) { // server unreachable
+        LOG_WARNING(TAG_IMG, F("HTTP error %d, using the cached %s"), code, job->url);
+        return image_fetch_cache_read(job);
+    }
+#endif
+
+    LOG_WARNING(TAG_IMG, F("HTTP result %d for %s"), code, job->url);
+#endif // HASP_USE_WIFI || HASP_USE_ETHERNET
+    return false;
+}
+
+static void image_fetch_worker(void* args)
+{
+    uint8_t id;
+    while(xQueueReceive(image_fetch_queue, &id, portMAX_DELAY) == pdTRUE) {
+        image_fetch_job_t* job = &image_fetch_jobs[id];
+        bool ok                = false;
+
+        if(!job->cancelled) {
+            job->state = FETCH_LOADING;
+
+            if(job->convert) {
+#if IMAGE_STREAM_CONVERT > 0
+                ok = image_fetch_convert_file(job);
+#endif
+            } else if(job->url[0] == 'Z' && job->url[1] == ':') {
+#if HASP_USE_SDCARD > 0
+                ok = image_fetch_file(job, HASP_SD_FS, job->url + 2);
+#endif
+            } else {
+                ok = image_fetch_http(job);
+            }
+            ok = ok && !job->cancelled;
+        }
+
+        job->state = ok ? FETCH_DONE : FETCH_FAILED; // handed back to the GUI
+    }
+}
+
+/* ===== GUI ===== */
+
+static void image_fetch_free(image_fetch_job_t* job)
+{
+    hasp_free(job->data);
+    hasp_free(job->url);
+    job->data      = NULL;
+    job->url       = NULL;
+    job->obj       = NULL;
+    job->cancelled = false;
+    job->convert   = false;
+    job->state     = FETCH_FREE;
+}
+
+/* Descriptor with the url stored behind it, it takes over the data of the job */
+static lv_img_dsc_t* image_fetch_descriptor(image_fetch_job_t* job)
+{
+    size_t url_len        = strlen(job->url) + 1;
+    lv_img_dsc_t* img_dsc = (lv_img_dsc_t*)lv_mem_alloc(sizeof(lv_img_dsc_t) + url_len);
+    if(!img_dsc) {
+        LOG_ERROR(TAG_IMG, F(D_ERROR_OUT_OF_MEMORY));
+        return NULL;
+    }
+
+    memset(img_dsc, 0, sizeof(lv_img_dsc_t));
+    memcpy((char*)img_dsc + sizeof(lv_img_dsc_t), job->url, url_len);
+    img_dsc->header    = job->header;
+    img_dsc->data_size = job->data_size;
+    img_dsc->data      = job->data;
+    job->data          = NULL;
+    return img_dsc;
+}
+
+static void image_fetch_finish(image_fetch_job_t* job)
+{
+    if(job->convert) { // the converted file is used the next time the image is opened
+        image_fetch_free(job);
+        return;
+    }
+
+    if(job->cancelled || job->state != FETCH_DONE) {
+        if(!job->cancelled) LOG_WARNING(TAG_IMG, F("Loading %s failed"), job->url);
+        image_fetch_free(job);
+        return;
+    }
+
+    lv_obj_t* obj         = job->obj;
+    lv_img_dsc_t* img_dsc = image_fetch_descriptor(job);
+    image_fetch_free(job);
+    if(!img_dsc) return;
+
+#if HASP_USE_IMAGE_CACHE > 0
+    image_cache_add_src(img_dsc);
+#endif
+    my_image_release_resources(obj);
+    lv_img_set_src(obj, img_dsc);
+
+#if HASP_USE_IMAGE_CACHE > 0
+    // Objects still waiting for the same url show this image instead of loading it again
+    const char* url = (const char*)img_dsc + sizeof(lv_img_dsc_t);
+    for(uint8_t id = 0; id < IMAGE_FETCH_MAX_JOBS; id++) {
+        image_fetch_job_t* other = &image_fetch_jobs[id];
+        if(other->state == FETCH_FREE || other->cancelled || other->convert || strcmp(other->url, url)) continue;
+
+        lv_img_dsc_t* shared = image_cache_get_src(url, lv_img_get_src(other->obj));
+        if(!shared) continue;
+
+        lv_obj_t* other_obj = other->obj;
+        my_image_release_resources(other_obj); // cancels its job
+        lv_img_set_src(other_obj, shared);
+    }
+#endif
+}
+
+static void image_fetch_poll(lv_task_t* task)
+{
+    uint8_t pending = 0;
+
+    for(uint8_t id = 0; id < IMAGE_FETCH_MAX_JOBS; id++) {
+        image_fetch_job_t* job = &image_fetch_jobs[id];
+        if(job->state == FETCH_DONE || job->state == FETCH_FAILED)
+            image_fetch_finish(job);
+        else if(job->state != FETCH_FREE)
+            pending++;
+    }
+
+    if(pending == 0) {
+        lv_task_del(image_fetch_poll_task);
+        image_fetch_poll_task = NULL;
+    }
+}
+
+static bool image_fetch_begin(void)
+{
+    if(image_fetch_task) return true;
+
+    image_fetch_queue = xQueueCreate(IMAGE_FETCH_MAX_JOBS, sizeof(uint8_t));
+    if(image_fetch_queue &&
+       xTaskCreate(image_fetch_worker, "imgFetch", IMAGE_FETCH_STACK_SIZE, NULL, 1, &image_fetch_task) == pdPASS)
+        return true;
+
+    LOG_ERROR(TAG_IMG, F("Create task for image loading failed"));
+    if(image_fetch_queue) vQueueDelete(image_fetch_queue);
+    image_fetch_queue = NULL;
+    return false;
+}
+
+/* Hand a job to the worker, obj is NULL to convert a file */
+static bool image_fetch_queue_job(lv_obj_t* obj, const char* url, bool convert)
+{
+    if(!image_fetch_begin()) return false;
+
+    image_fetch_job_t* job = NULL;
+    uint8_t id;
+    for(id = 0; id < IMAGE_FETCH_MAX_JOBS; id++) {
+        if(image_fetch_jobs[id].state == FETCH_FREE) {
+            job = &image_fetch_jobs[id];
+            break;
+        }
+    }
+    if(!job) {
+        LOG_WARNING(TAG_IMG, F("Too many images loading, %s skipped"), url);
+        return false;
+    }
+
+    job->url = (char*)hasp_malloc(strlen(url) + 1);
+    if(!job->url) {
+        LOG_ERROR(TAG_IMG, F(D_ERROR_OUT_OF_MEMORY));
+        return false;
+    }
+    strcpy(job->url, url);
+    job->obj       = obj;
+    job->data      = NULL;
+    job->cancelled = false;
+    job->convert   = convert;
+    job->state     = FETCH_QUEUED;
+
+    if(xQueueSend(image_fetch_queue, &id, 0) != pdTRUE) {
+        image_fetch_free(job);
+        return false;
+    }
+
+    if(!image_fetch_poll_task)
+        image_fetch_poll_task = lv_task_create(image_fetch_poll, IMAGE_FETCH_POLL_INTERVAL, LV_TASK_PRIO_LOW, NULL);
+    return true;
+}
+
+bool image_fetch_start(lv_obj_t* obj, const char* url)
+{
+    image_fetch_cancel(obj); // the last src wins
+    if(!image_fetch_queue_job(obj, url, false)) return false;
+
+    // Placeholder, an image that is refreshed stays visible until the new one is loaded
+    lv_img_src_t src_type = lv_img_src_get_type(lv_img_get_src(obj));
+    if(src_type != LV_IMG_SRC_VARIABLE && src_type != LV_IMG_SRC_FILE) lv_img_set_src(obj, LV_SYMBOL_DUMMY);
+
+    LOG_VERBOSE(TAG_IMG, F("Loading %s"), url);
+    return true;
+}
+
+bool image_fetch_convert(const char* path)
+{
+#if IMAGE_STREAM_CONVERT > 0
+    return image_fetch_queue_job(NULL, path, true);
+#else
+    return false;
+#endif
+}
+
+void image_fetch_cancel(lv_obj_t* obj)
+{
+    for(uint8_t id = 0; id < IMAGE_FETCH_MAX_JOBS; id++) {
+        image_fetch_job_t* job = &image_fetch_jobs[id];
+        if(job->state == FETCH_FREE || job->convert || job->obj != obj) continue;
+
+        job->cancelled = true; // the worker skips or stops it, the poll frees it
+        job->obj       = NULL;
+    }
+}
+
+const char* image_fetch_pending_url(lv_obj_t* obj)
+{
+    for(uint8_t id = 0; id < IMAGE_FETCH_MAX_JOBS; id++) {
+        image_fetch_job_t* job = &image_fetch_jobs[id];
+        if(job->state != FETCH_FREE && !job->cancelled && job->obj == obj) return job->url;
+    }
+    return NULL;
+}
+
+bool image_fetch_in_worker(void)
+{
+    return image_fetch_task && xTaskGetCurrentTaskHandle() == image_fetch_task;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_IMAGE_FETCH_H
+#define HASP_IMAGE_FETCH_H
+
+#if HASP_USE_IMAGE_FETCH > 0
+
+/* Images of http(s):// and Z: (SD card) sources, loaded in the background
+ *
+ * Setting the src queues a job and returns at once. A worker task decodes the image while it is downloaded
+ * or read, see hasp_image_stream.h, the GUI polls for finished jobs and swaps the image in. The object shows an
+ * empty placeholder until then, or keeps the image it already had when it is refreshed.
+ * A job is cancelled when its object is deleted or gets another src, the worker stops reading at the next block.
+ *
+ * Downloads that have an ETag or Last-Modified header are kept in IMAGE_FETCH_CACHE_DIR on the filesystem.
+ * The next request for the url is a conditional GET and 304 Not Modified is served from the file,
+ * which is also used when the server can not be reached. The cache is kept below IMAGE_FETCH_CACHE_SIZE
+ * by removing the files that were downloaded longest ago.
+ */
+
+#ifndef IMAGE_FETCH_MAX_JOBS
+#define IMAGE_FETCH_MAX_JOBS 16 // images loading at the same time
+#endif
+#ifndef IMAGE_FETCH_MAX_SIZE
+#define IMAGE_FETCH_MAX_SIZE (512 * 1024) // largest chunked response, it is collected before decoding
+#endif
+#ifndef IMAGE_FETCH_TIMEOUT
+#define IMAGE_FETCH_TIMEOUT 5000 // [ms]
+#endif
+#ifndef IMAGE_FETCH_STACK_SIZE
+#define IMAGE_FETCH_STACK_SIZE (10 * 1024) // TLS handshake and PNG decoder
+#endif
+#ifndef IMAGE_FETCH_POLL_INTERVAL
+#define IMAGE_FETCH_POLL_INTERVAL 50 // [ms] only while jobs are pending
+#endif
+#ifndef IMAGE_FETCH_CACHE_DIR
+#define IMAGE_FETCH_CACHE_DIR "/cache"
+#endif
+#ifndef IMAGE_FETCH_CACHE_FILE_SIZE
+#define IMAGE_FETCH_CACHE_FILE_SIZE (64 * 1024) // largest download kept on the filesystem, 0 to disable
+#endif
+#ifndef IMAGE_FETCH_CACHE_SIZE
+#define IMAGE_FETCH_CACHE_SIZE (256 * 1024) // all cached downloads, the oldest are removed first
+#endif
+
+/* ===== Special Event Processors ===== */
+bool image_fetch_start(lv_obj_t* obj, const char* url);
+void image_fetch_cancel(lv_obj_t* obj);
+bool image_fetch_convert(const char* path); // write the .bin of a png or jpg file on the filesystem
+
+/* ===== Getter and Setter Functions ===== */
+const char* image_fetch_pending_url(lv_obj_t* obj); // NULL when nothing is loading
+bool image_fetch_in_worker(void);
+
+#endif
+#endif
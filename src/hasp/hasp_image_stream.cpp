@@ -0,0 +1,1152 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if HASP_USE_IMAGE_STREAM > 0
+
+#include "rom/miniz.h"
+
+#if CONFIG_IDF_TARGET_ESP32
+#include "esp32/rom/tjpgd.h"
+#define IMAGE_STREAM_JPG 1
+#elif CONFIG_IDF_TARGET_ESP32S3
+#include "esp32s3/rom/tjpgd.h"
+#define IMAGE_STREAM_JPG 1
+#elif CONFIG_IDF_TARGET_ESP32C3
+#include "esp32c3/rom/tjpgd.h"
+#define IMAGE_STREAM_JPG 1
+#else
+#define IMAGE_STREAM_JPG 0 // no TJpgDec in the ROM
+#endif
+
+#include "hasp_debug.h"
+#include "hasp_filesystem.h"
+
+#define IMAGE_STREAM_MAX_SIZE 2047 // lv_img_header_t
+#define IMAGE_STREAM_JPG_WORK 3100 // work area of TJpgDec
+#define IMAGE_STREAM_PATH_SIZE 64
+
+#define PNG_CHUNK_IHDR 0x49484452
+#define PNG_CHUNK_PLTE 0x504c5445
+#define PNG_CHUNK_TRNS 0x74524e53
+#define PNG_CHUNK_IDAT 0x49444154
+#define PNG_CHUNK_IEND 0x49454e44
+
+enum : uint8_t { PNG_GRAY = 0, PNG_RGB = 2, PNG_PALETTE = 3, PNG_GRAY_ALPHA = 4, PNG_RGBA = 6 };
+
+static const uint8_t png_magic[] = {0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a};
+
+enum : uint8_t { IMAGE_STREAM_PNG, IMAGE_STREAM_JPEG, IMAGE_STREAM_BIN, IMAGE_STREAM_RLE, IMAGE_STREAM_FORMATS };
+
+static const char* const image_stream_format_names[] = {"PNG", "JPEG", "BIN", "BIN RLE"};
+
+/* Decode times per format, for /api/info and tools/image_decode_bench.py */
+typedef struct
+{
+    uint32_t count;
+    uint32_t ms;
+} image_stream_stats_t;
+
+static image_stream_stats_t image_stream_stats[IMAGE_STREAM_FORMATS];
+
+static inline uint32_t image_stream_be32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint16_t image_stream_be16(const uint8_t* p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+/* Native pixel, followed by the alpha byte when the image has transparency */
+static inline uint8_t* image_stream_put(uint8_t* dst, uint8_t r, uint8_t g, uint8_t b, uint8_t a, bool alpha)
+{
+    lv_color_t color = lv_color_make(r, g, b);
+#if LV_COLOR_DEPTH == 32
+    color.ch.alpha = a;
+    memcpy(dst, &color, sizeof(color));
+    return dst + sizeof(color);
+#else
+    memcpy(dst, &color, sizeof(color));
+    dst += sizeof(color);
+    if(alpha) *dst++ = a;
+    return dst;
+#endif
+}
+
+/* The encoded stream, the first bytes are read ahead to find the format */
+class ImageStreamSource {
+  public:
+    ImageStreamSource(Stream& in) : _in(in), _pos(0), _len(0)
+    {}
+
+    bool begin()
+    {
+        _pos = 0;
+        _len = 0;
+        _len = read(_magic, sizeof(_magic)); // from the stream, nothing is read ahead yet
+        return _len == sizeof(_magic);
+    }
+    const uint8_t* magic()
+    {
+        return _magic;
+    }
+
+    /* Read or skip len bytes, buf can be NULL */
+    size_t read(uint8_t* buf, size_t len)
+    {
+        size_t n = 0;
+        if(_pos < _len) {
+            n = min(len, _len - _pos);
+            if(buf) memcpy(buf, _magic + _pos, n);
+            _pos += n;
+        }
+
+        while(n < len) {
+            uint8_t skip[64];
+            size_t want = buf ? len - n : min(len - n, sizeof(skip));
+            size_t got  = _in.readBytes(buf ? buf + n : skip, want);
+            if(got == 0) break;
+            n += got;
+        }
+        return n;
+    }
+
+  private:
+    Stream& _in;
+    uint8_t _magic[8];
+    size_t _pos;
+    size_t _len;
+};
+
+/* Image that is read one row at a time in the native format */
+class ImageStreamRows {
+  public:
+    virtual ~ImageStreamRows()
+    {}
+    virtual bool begin(lv_img_header_t* header) = 0;
+    virtual bool read_row(uint8_t* native) = 0;
+
+    uint16_t width;
+    uint16_t height;
+    uint16_t row;      // rows read
+    uint8_t native_px; // bytes per native pixel
+};
+
+/* ===== PNG ===== */
+
+/* Non-interlaced PNG, inflated and unfiltered one row at a time */
+class PngStream : public ImageStreamRows {
+  public:
+    PngStream(ImageStreamSource& src)
+        : _src(src), _rows(NULL), _inflator(NULL), _dict(NULL), _palette(NULL), _has_trns(false)
+    {}
+    ~PngStream()
+    {
+        hasp_free(_rows);
+        hasp_free(_inflator);
+        hasp_free(_dict);
+        hasp_free(_palette);
+    }
+
+    bool read_header(lv_img_header_t* header); // signature and chunks up to the image data
+    bool begin(lv_img_header_t* header) override;
+    bool read_row(uint8_t* native) override;
+
+  private:
+    bool fill();
+    bool inflate_row(uint8_t* cur);
+    bool unfilter(uint8_t* cur, const uint8_t* prev);
+    void convert(const uint8_t* raw, uint8_t* native);
+    uint16_t sample(const uint8_t* raw, uint32_t index);
+
+    ImageStreamSource& _src;
+    uint8_t _depth;
+    uint8_t _color_type;
+    bool _alpha;
+    size_t _bpp;    // bytes per complete pixel, at least 1
+    size_t _stride; // bytes per row after the filter byte
+
+    uint8_t* _rows; // previous and current row, with the filter byte
+    tinfl_decompressor* _inflator;
+    uint8_t* _dict;
+    size_t _dict_ofs;
+    const uint8_t* _pending; // inflated bytes not used yet
+    size_t _pending_len;
+    bool _done;
+
+    uint8_t _in_buf[256];
+    size_t _in_pos;
+    size_t _in_len;
+    uint32_t _chunk_left; // IDAT bytes not read yet
+    bool _idat_end;
+
+    uint8_t* _palette; // RGBA
+    bool _has_trns;
+    uint16_t _trns[3]; // transparent gray or RGB
+};
+
+bool PngStream::read_header(lv_img_header_t* header)
+{
+    uint8_t buf[13];
+    if(_src.read(buf, 8) != 8 || memcmp(buf, png_magic, sizeof(png_magic))) return false;
+
+    bool ihdr = false;
+    for(;;) {
+        if(_src.read(buf, 8) != 8) return false;
+        uint32_t len  = image_stream_be32(buf);
+        uint32_t type = image_stream_be32(buf + 4);
+
+        if(type == PNG_CHUNK_IHDR && len == 13) {
+            if(_src.read(buf, 13) != 13) return false;
+            uint32_t w  = image_stream_be32(buf);
+            uint32_t h  = image_stream_be32(buf + 4);
+            _depth      = buf[8];
+            _color_type = buf[9];
+            if(w == 0 || h == 0 || w > IMAGE_STREAM_MAX_SIZE || h > IMAGE_STREAM_MAX_SIZE) {
+                LOG_ERROR(TAG_IMG, F("Image is larger than %d pixels"), IMAGE_STREAM_MAX_SIZE);
+                return false;
+            }
+            if(buf[12] != 0) return false; // interlaced, left to lv_png
+            width  = w;
+            height = h;
+            ihdr   = true;
+
+        } else if(type == PNG_CHUNK_PLTE && len <= 256 * 3 && len % 3 == 0) {
+            if(!_palette) _palette = (uint8_t*)hasp_malloc(256 * 4);
+            if(!_palette) return false;
+            memset(_palette, 0xFF, 256 * 4);
+            for(uint32_t i = 0; i < len / 3; i++) {
+                if(_src.read(_palette + i * 4, 3) != 3) return false;
+            }
+
+        } else if(type == PNG_CHUNK_TRNS && len <= 256) {
+            uint8_t trns[256];
+            if(_src.read(trns, len) != len) return false;
+            if(_color_type == PNG_PALETTE && _palette) {
+                for(uint32_t i = 0; i < len; i++) _palette[i * 4 + 3] = trns[i];
+            } else if(_color_type == PNG_GRAY && len >= 2) {
+                _trns[0] = image_stream_be16(trns);
+            } else if(_color_type == PNG_RGB && len >= 6) {
+                for(uint8_t c = 0; c < 3; c++) _trns[c] = image_stream_be16(trns + c * 2);
+            }
+            _has_trns = true;
+
+        } else if(type == PNG_CHUNK_IDAT) {
+            _chunk_left = len;
+            break;
+
+        } else if(type == PNG_CHUNK_IEND) {
+            return false;
+
+        } else if(_src.read(NULL, len) != len) {
+            return false;
+        }
+
+        if(_src.read(NULL, 4) != 4) return false; // CRC
+    }
+
+    uint8_t channels;
+    switch(_color_type) {
+        case PNG_GRAY:
+            channels = 1;
+            break;
+        case PNG_RGB:
+            channels = 3;
+            break;
+        case PNG_PALETTE:
+            channels = 1;
+            if(!_palette) return false;
+            break;
+        case PNG_GRAY_ALPHA:
+            channels = 2;
+            break;
+        case PNG_RGBA:
+            channels = 4;
+            break;
+        default:
+            return false;
+    }
+    if(!ihdr || (_depth != 1 && _depth != 2 && _depth != 4 && _depth != 8 && _depth != 16)) return false;
+    if(_depth < 8 && _color_type != PNG_GRAY && _color_type != PNG_PALETTE) return false;
+    if(_depth == 16 && _color_type == PNG_PALETTE) return false;
+
+    uint32_t bits = channels * _depth;
+    _bpp          = max(bits / 8, (uint32_t)1);
+    _stride       = (width * bits + 7) / 8;
+    _alpha        = _color_type == PNG_GRAY_ALPHA || _color_type == PNG_RGBA || _has_trns;
+    native_px     = _alpha ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+
+    header->always_zero = 0;
+    header->w           = width;
+    header->h           = height;
+    header->cf          = _alpha ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+    return true;
+}
+
+bool PngStream::begin(lv_img_header_t* header)
+{
+    if(!read_header(header)) return false;
+
+    _rows     = (uint8_t*)hasp_calloc(2, _stride + 1);
+    _inflator = (tinfl_decompressor*)hasp_malloc(sizeof(tinfl_decompressor));
+    _dict     = (uint8_t*)hasp_malloc(TINFL_LZ_DICT_SIZE);
+    if(!_rows || !_inflator || !_dict) {
+        LOG_ERROR(TAG_IMG, F(D_ERROR_OUT_OF_MEMORY));
+        return false;
+    }
+
+    tinfl_init(_inflator);
+    _dict_ofs    = 0;
+    _pending     = NULL;
+    _pending_len = 0;
+    _done        = false;
+    _in_pos      = 0;
+    _in_len      = 0;
+    _idat_end    = false;
+    row          = 0;
+    return true;
+}
+
+/* Next block of compressed data, the IDAT chunks are one zlib stream */
+bool PngStream::fill()
+{
+    while(_chunk_left == 0) {
+        if(_idat_end) return false;
+
+        uint8_t buf[12]; // CRC of the last chunk, length and type of the next
+        if(_src.read(buf, sizeof(buf)) != sizeof(buf) || image_stream_be32(buf + 8) != PNG_CHUNK_IDAT) {
+            _idat_end = true;
+            return false;
+        }
+        _chunk_left = image_stream_be32(buf + 4);
+    }
+
+    size_t len = _src.read(_in_buf, min((size_t)_chunk_left, sizeof(_in_buf)));
+    if(len == 0) { // truncated or cancelled
+        _idat_end = true;
+        return false;
+    }
+    _chunk_left -= len;
+    _in_pos = 0;
+    _in_len = len;
+    return true;
+}
+
+/* Inflate the filter byte and the bytes of one row */
+bool PngStream::inflate_row(uint8_t* cur)
+{
+    size_t have = 0;
+    size_t need = _stride + 1;
+
+    while(have < need) {
+        if(_pending_len > 0) {
+            size_t len = min(_pending_len, need - have);
+            memcpy(cur + have, _pending, len);
+            _pending += len;
+            _pending_len -= len;
+            have += len;
+            continue;
+        }
+        if(_done) return false; // the image data ended early
+
+        if(_in_pos == _in_len) fill();
+        bool more_input  = !_idat_end || _chunk_left > 0;
+        size_t in_bytes  = _in_len - _in_pos;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - _dict_ofs;
+
+        tinfl_status status =
+            tinfl_decompress(_inflator, _in_buf + _in_pos, &in_bytes, _dict, _dict + _dict_ofs, &out_bytes,
+                             TINFL_FLAG_PARSE_ZLIB_HEADER | (more_input ? TINFL_FLAG_HAS_MORE_INPUT : 0));
+        _in_pos += in_bytes;
+        _pending     = _dict + _dict_ofs;
+        _pending_len = out_bytes;
+        _dict_ofs    = (_dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if(status == TINFL_STATUS_DONE) {
+            _done = true;
+        } else if(status < TINFL_STATUS_DONE) {
+            LOG_ERROR(TAG_IMG, F("PNG error: invalid image data"));
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline uint8_t png_paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+    int16_t p  = a + b - c;
+    int16_t pa = abs(p - a);
+    int16_t pb = abs(p - b);
+    int16_t pc = abs(p - c);
+    if(pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+bool PngStream::unfilter(uint8_t* cur, const uint8_t* prev)
+{
+    uint8_t filter = cur[0];
+    uint8_t* c     = cur + 1;
+    const uint8_t* p = prev + 1;
+
+    switch(filter) {
+        case 0: // none
+            break;
+        case 1: // sub
+            for(size_t i = _bpp; i < _stride; i++) c[i] += c[i - _bpp];
+            break;
+        case 2: // up
+            for(size_t i = 0; i < _stride; i++) c[i] += p[i];
+            break;
+        case 3: // average
+            for(size_t i = 0; i < _stride; i++) c[i] += ((i >= _bpp ? c[i - _bpp] : 0) + p[i]) >> 1;
+            break;
+        case 4: // paeth
+            for(size_t i = 0; i < _stride; i++)
+                c[i] += i >= _bpp ? png_paeth(c[i - _bpp], p[i], p[i - _bpp]) : png_paeth(0, p[i], 0);
+            break;
+        default:
+            LOG_ERROR(TAG_IMG, F("PNG error: invalid filter %d"), filter);
+            return false;
+    }
+    return true;
+}
+
+/* Sample of a gray or palette pixel, packed when the depth is below 8 bits */
+uint16_t PngStream::sample(const uint8_t* raw, uint32_t index)
+{
+    if(_depth == 16) return image_stream_be16(raw + index * 2);
+    if(_depth == 8) return raw[index];
+
+    uint32_t bit = index * _depth;
+    return (raw[bit / 8] >> (8 - _depth - bit % 8)) & ((1 << _depth) - 1);
+}
+
+void PngStream::convert(const uint8_t* raw, uint8_t* native)
+{
+    const uint8_t scale[] = {0, 255, 85, 0, 17}; // 1, 2 and 4 bit gray to 8 bits
+    uint8_t step          = _depth == 16 ? 2 : 1;
+
+    for(uint32_t x = 0; x < width; x++) {
+        uint8_t r, g, b, a = 0xFF;
+
+        switch(_color_type) {
+            case PNG_GRAY: {
+                uint16_t v = sample(raw, x);
+                if(_has_trns && v == _trns[0]) a = 0;
+                r = g = b = _depth == 16 ? v >> 8 : (_depth == 8 ? v : v * scale[_depth]);
+                break;
+            }
+            case PNG_RGB: {
+                const uint8_t* px = raw + x * 3 * step;
+                r                 = px[0];
+                g                 = px[step];
+                b                 = px[step * 2];
+                if(_has_trns) {
+                    bool match = step == 2 ? image_stream_be16(px) == _trns[0] &&
+                                                 image_stream_be16(px + 2) == _trns[1] &&
+                                                 image_stream_be16(px + 4) == _trns[2]
+                                           : r == _trns[0] && g == _trns[1] && b == _trns[2];
+                    if(match) a = 0;
+                }
+                break;
+            }
+            case PNG_PALETTE: {
+                const uint8_t* color = _palette + sample(raw, x) * 4;
+                r                    = color[0];
+                g                    = color[1];
+                b                    = color[2];
+                a                    = color[3];
+                break;
+            }
+            case PNG_GRAY_ALPHA: {
+                const uint8_t* px = raw + x * 2 * step;
+                r = g = b = px[0];
+                a         = px[step];
+                break;
+            }
+            default: { // PNG_RGBA
+                const uint8_t* px = raw + x * 4 * step;
+                r                 = px[0];
+                g                 = px[step];
+                b                 = px[step * 2];
+                a                 = px[step * 3];
+                break;
+            }
+        }
+
+        native = image_stream_put(native, r, g, b, a, _alpha);
+    }
+}
+
+bool PngStream::read_row(uint8_t* native)
+{
+    if(row >= height) return false;
+
+    uint8_t* prev = _rows + (row & 1) * (_stride + 1);
+    uint8_t* cur  = _rows + ((row + 1) & 1) * (_stride + 1);
+    if(!inflate_row(cur) || !unfilter(cur, prev)) return false;
+
+    convert(cur + 1, native);
+    row++;
+    return true;
+}
+
+/* All rows of a PNG or .bin image in one buffer */
+static uint8_t* image_stream_decode_rows(ImageStreamRows& rows, lv_img_header_t* header, uint32_t* size)
+{
+    if(!rows.begin(header)) return NULL;
+
+    uint32_t stride = rows.width * rows.native_px;
+    *size           = stride * rows.height;
+    uint8_t* data   = (uint8_t*)hasp_malloc(*size);
+    if(!data) {
+        LOG_ERROR(TAG_IMG, F(D_ERROR_OUT_OF_MEMORY));
+        return NULL;
+    }
+
+    for(uint16_t y = 0; y < rows.height; y++) {
+        if(!rows.read_row(data + y * stride)) {
+            hasp_free(data);
+            return NULL;
+        }
+    }
+    return data;
+}
+
+/* ===== JPEG ===== */
+
+#if IMAGE_STREAM_JPG
+typedef struct
+{
+    ImageStreamSource* src;
+    uint8_t* data;
+    uint16_t width;
+} image_stream_jpg_t;
+
+static UINT image_stream_jpg_input(JDEC* jd, BYTE* buf, UINT len)
+{
+    image_stream_jpg_t* jpg = (image_stream_jpg_t*)jd->device;
+    return jpg->src->read(buf, len); // buf is NULL to skip
+}
+
+/* One decoded block of RGB888 pixels */
+static UINT image_stream_jpg_output(JDEC* jd, void* bitmap, JRECT* rect)
+{
+    image_stream_jpg_t* jpg = (image_stream_jpg_t*)jd->device;
+    const uint8_t* rgb      = (const uint8_t*)bitmap;
+
+    for(uint16_t y = rect->top; y <= rect->bottom; y++) {
+        uint8_t* dst = jpg->data + ((uint32_t)y * jpg->width + rect->left) * sizeof(lv_color_t);
+        for(uint16_t x = rect->left; x <= rect->right; x++) {
+            dst = image_stream_put(dst, rgb[0], rgb[1], rgb[2], 0xFF, false);
+            rgb += 3;
+        }
+    }
+    return 1;
+}
+
+static uint8_t* image_stream_decode_jpg(ImageStreamSource& src, lv_img_header_t* header, uint32_t* size)
+{
+    void* work = malloc(IMAGE_STREAM_JPG_WORK); // internal ram for the ROM decoder
+    if(!work) {
+        LOG_ERROR(TAG_IMG, F(D_ERROR_OUT_OF_MEMORY));
+        return NULL;
+    }
+
+    JDEC jd;
+    image_stream_jpg_t jpg = {&src, NULL, 0};
+    JRESULT res            = jd_prepare(&jd, image_stream_jpg_input, work, IMAGE_STREAM_JPG_WORK, &jpg);
+    if(res != JDR_OK) {
+        LOG_ERROR(TAG_IMG, F("JPEG error %d, only baseline JPEG is supported"), res);
+        free(work);
+        return NULL;
+    }
+    if(jd.width > IMAGE_STREAM_MAX_SIZE || jd.height > IMAGE_STREAM_MAX_SIZE) {
+        LOG_ERROR(TAG_IMG, F("Image is larger than %d pixels"), IMAGE_STREAM_MAX_SIZE);
+        free(work);
+        return NULL;
+    }
+
+    *size     = jd.width * jd.height * sizeof(lv_color_t);
+    jpg.data  = (uint8_t*)hasp_malloc(*size);
+    jpg.width = jd.width;
+    if(jpg.data) {
+        res = jd_decomp(&jd, image_stream_jpg_output, 0);
+    } else {
+        LOG_ERROR(TAG_IMG, F(D_ERROR_OUT_OF_MEMORY));
+    }
+    free(work);
+
+    if(jpg.data && res != JDR_OK) {
+        LOG_ERROR(TAG_IMG, F("JPEG error %d"), res);
+        hasp_free(jpg.data);
+        return NULL;
+    }
+
+    header->always_zero = 0;
+    header->w           = jd.width;
+    header->h           = jd.height;
+    header->cf          = LV_IMG_CF_TRUE_COLOR;
+    return jpg.data;
+}
+#endif
+
+#if IMAGE_STREAM_JPG
+/* Size of a baseline JPEG from its frame header, progressive files are not supported */
+static bool image_stream_jpg_info(ImageStreamSource& src, lv_img_header_t* header)
+{
+    uint8_t buf[7];
+    if(src.read(buf, 2) != 2) return false; // SOI
+
+    for(uint8_t segments = 0; segments < 32; segments++) {
+        if(src.read(buf, 4) != 4 || buf[0] != 0xFF) return false;
+        uint8_t marker = buf[1];
+        uint16_t len   = image_stream_be16(buf + 2);
+        if(len < 2) return false;
+
+        if(marker == 0xC0 || marker == 0xC1) { // baseline frame
+            if(src.read(buf, 5) != 5) return false;
+            header->always_zero = 0;
+            header->h           = image_stream_be16(buf + 1);
+            header->w           = image_stream_be16(buf + 3);
+            header->cf          = LV_IMG_CF_TRUE_COLOR;
+            return header->w <= IMAGE_STREAM_MAX_SIZE && header->h <= IMAGE_STREAM_MAX_SIZE;
+        }
+        if(marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) return false;
+        if(src.read(NULL, len - 2) != len - 2u) return false;
+    }
+    return false;
+}
+#endif
+
+/* ===== LVGL .bin ===== */
+
+static uint8_t image_stream_bin_px(uint8_t cf)
+{
+    switch(cf) {
+        case LV_IMG_CF_TRUE_COLOR:
+        case LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED:
+            return sizeof(lv_color_t);
+        case LV_IMG_CF_TRUE_COLOR_ALPHA:
+            return LV_IMG_PX_SIZE_ALPHA_BYTE;
+        default:
+            return 0; // read at once or by the built-in decoder
+    }
+}
+
+/* True color .bin, the header is the first byte of the file with cf in the low bits */
+static bool image_stream_is_bin(const uint8_t* magic)
+{
+    return (magic[0] & 0xE0) == 0 && image_stream_bin_px(magic[0] & 0x1F) > 0;
+}
+
+/* LVGL .bin image of a true color format with the pixels as they are or run-length encoded.
+ * A run is a control byte with the number of pixels, followed by one pixel that is repeated or,
+ * when bit 7 is set, by the pixels to copy. Runs can continue on the next row. */
+class BinStream : public ImageStreamRows {
+  public:
+    BinStream(ImageStreamSource& src) : _src(src), _run_left(0)
+    {}
+
+    bool begin(lv_img_header_t* header) override
+    {
+        if(_src.read((uint8_t*)header, sizeof(lv_img_header_t)) != sizeof(lv_img_header_t)) return false;
+
+        native_px = image_stream_bin_px(header->cf);
+        if(header->always_zero || native_px == 0 || header->w == 0 || header->h == 0) return false;
+
+        _rle             = header->reserved & IMAGE_STREAM_FLAG_RLE;
+        header->reserved = 0; // the decoded pixels are plain
+        width            = header->w;
+        height           = header->h;
+        row              = 0;
+        _run_left        = 0;
+        return true;
+    }
+
+    bool read_row(uint8_t* native) override
+    {
+        if(row >= height) return false;
+        row++;
+        if(!_rle) return _src.read(native, width * native_px) == width * native_px;
+
+        for(uint16_t left = width; left > 0;) {
+            if(_run_left == 0) {
+                uint8_t ctrl;
+                if(_src.read(&ctrl, 1) != 1) return false;
+                _literal  = ctrl & 0x80;
+                _run_left = ctrl & 0x7F;
+                if(_run_left == 0) return false;
+                if(!_literal && _src.read(_run_px, native_px) != native_px) return false;
+            }
+
+            uint16_t count = min(left, (uint16_t)_run_left);
+            if(_literal) {
+                if(_src.read(native, count * native_px) != count * native_px) return false;
+                native += count * native_px;
+            } else {
+                for(uint16_t i = 0; i < count; i++, native += native_px) memcpy(native, _run_px, native_px);
+            }
+            left -= count;
+            _run_left -= count;
+        }
+        return true;
+    }
+
+    bool rle()
+    {
+        return _rle;
+    }
+
+  private:
+    ImageStreamSource& _src;
+    bool _rle;
+    bool _literal;
+    uint8_t _run_left;
+    uint8_t _run_px[LV_IMG_PX_SIZE_ALPHA_BYTE];
+};
+
+/* Run-length encode one row, out has room for the row and a control byte per 127 pixels */
+static size_t image_stream_rle_row(const uint8_t* row, uint16_t width, uint8_t px, uint8_t* out)
+{
+    uint8_t* dst = out;
+    for(uint16_t x = 0; x < width;) {
+        const uint8_t* pixel = row + x * px;
+
+        uint16_t run = 1;
+        while(x + run < width && run < 127 && !memcmp(pixel, pixel + run * px, px)) run++;
+        if(run > 1) {
+            *dst++ = run;
+            memcpy(dst, pixel, px);
+            dst += px;
+            x += run;
+            continue;
+        }
+
+        // Copy the pixels up to the next repeat
+        uint16_t count = 1;
+        while(x + count < width && count < 127 &&
+              (x + count + 1 == width || memcmp(pixel + count * px, pixel + (count + 1) * px, px)))
+            count++;
+        *dst++ = 0x80 | count;
+        memcpy(dst, pixel, count * px);
+        dst += count * px;
+        x += count;
+    }
+    return dst - out;
+}
+
+/* Other .bin formats, like indexed colors, are read at once */
+static uint8_t* image_stream_decode_bin(ImageStreamSource& src, lv_img_header_t* header, uint32_t* size)
+{
+    if(src.read((uint8_t*)header, sizeof(lv_img_header_t)) != sizeof(lv_img_header_t)) return NULL;
+
+    *size = header->always_zero || header->reserved ? 0 : lv_img_buf_get_img_size(header->w, header->h, header->cf);
+    if(*size == 0) return NULL;
+
+    uint8_t* data = (uint8_t*)hasp_malloc(*size);
+    if(!data) {
+        LOG_ERROR(TAG_IMG, F(D_ERROR_OUT_OF_MEMORY));
+        return NULL;
+    }
+    if(src.read(data, *size) != *size) {
+        hasp_free(data);
+        return NULL;
+    }
+    return data;
+}
+
+/* Row reader for the format of src, NULL for JPEG and .bin images that are not true color */
+static ImageStreamRows* image_stream_rows_create(ImageStreamSource& src)
+{
+    const uint8_t* magic = src.magic();
+    if(!memcmp(magic, png_magic, sizeof(png_magic))) return new PngStream(src);
+    if(image_stream_is_bin(magic)) return new BinStream(src);
+    return NULL;
+}
+
+/* ===== Special Event Processors ===== */
+
+uint8_t* image_stream_decode(Stream& in, lv_img_header_t* header, uint32_t* size)
+{
+    ImageStreamSource src(in);
+    if(!src.begin()) return NULL;
+
+    uint32_t start       = millis();
+    const uint8_t* magic = src.magic();
+    uint8_t* data        = NULL;
+    uint8_t format;
+
+    if(!memcmp(magic, png_magic, sizeof(png_magic))) {
+        PngStream png(src);
+        format = IMAGE_STREAM_PNG;
+        data   = image_stream_decode_rows(png, header, size);
+    } else if(magic[0] == 0xFF && magic[1] == 0xD8) {
+        format = IMAGE_STREAM_JPEG;
+#if IMAGE_STREAM_JPG
+        data = image_stream_decode_jpg(src, header, size);
+#else
+        LOG_ERROR(TAG_IMG, F("JPEG is not supported"));
+#endif
+    } else if(image_stream_is_bin(magic)) {
+        BinStream bin(src);
+        data   = image_stream_decode_rows(bin, header, size);
+        format = bin.rle() ? IMAGE_STREAM_RLE : IMAGE_STREAM_BIN;
+    } else {
+        format = IMAGE_STREAM_BIN;
+        data   = image_stream_decode_bin(src, header, size);
+    }
+
+    if(data) {
+        uint32_t ms = millis() - start;
+        image_stream_stats[format].count++;
+        image_stream_stats[format].ms += ms;
+        LOG_VERBOSE(TAG_IMG, F(D_BULLET "%s decoded in %u ms: w=%d h=%d cf=%d len=%u"),
+                    image_stream_format_names[format], ms, header->w, header->h, header->cf, *size);
+    }
+    return data;
+}
+
+bool image_stream_info(Stream& in, lv_img_header_t* header)
+{
+    ImageStreamSource src(in);
+    if(!src.begin()) return false;
+
+    const uint8_t* magic = src.magic();
+    if(!memcmp(magic, png_magic, sizeof(png_magic))) {
+        PngStream png(src);
+        return png.read_header(header);
+    }
+#if IMAGE_STREAM_JPG
+    if(magic[0] == 0xFF && magic[1] == 0xD8) return image_stream_jpg_info(src, header);
+#endif
+    if(image_stream_is_bin(magic)) {
+        BinStream bin(src);
+        return bin.begin(header);
+    }
+    return false;
+}
+
+uint32_t image_stream_convert_size(const lv_img_header_t* header, bool rle)
+{
+    uint32_t stride = header->w * image_stream_bin_px(header->cf);
+    if(rle) stride += header->w / 127 + 1; // runs that do not repeat
+    return sizeof(lv_img_header_t) + stride * header->h;
+}
+
+/* Write the image as a .bin file in the native format, PNG rows are converted one at a time */
+bool image_stream_convert(Stream& in, Print& out, bool rle)
+{
+    ImageStreamSource src(in);
+    if(!src.begin()) return false;
+
+    lv_img_header_t header;
+    ImageStreamRows* rows = NULL;
+    uint8_t* data         = NULL; // JPEG is decoded at once, TJpgDec writes blocks of 8 or 16 rows
+    const uint8_t* magic  = src.magic();
+
+    if(!memcmp(magic, png_magic, sizeof(png_magic))) {
+        rows = new PngStream(src);
+        if(!rows || !rows->begin(&header)) {
+            delete rows;
+            return false;
+        }
+#if IMAGE_STREAM_JPG
+    } else if(magic[0] == 0xFF && magic[1] == 0xD8) {
+        uint32_t size;
+        data = image_stream_decode_jpg(src, &header, &size);
+        if(!data) return false;
+#endif
+    } else {
+        return false; // already native
+    }
+
+    uint8_t px      = image_stream_bin_px(header.cf);
+    uint32_t stride = header.w * px;
+    uint8_t* line   = rows ? (uint8_t*)hasp_malloc(stride) : NULL;
+    uint8_t* packed = rle ? (uint8_t*)hasp_malloc(stride + header.w / 127 + 1) : NULL;
+
+    bool ok = (!rows || line) && (!rle || packed);
+    if(ok) {
+        header.reserved = rle ? IMAGE_STREAM_FLAG_RLE : 0;
+        ok              = out.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    }
+
+    for(uint16_t y = 0; ok && y < header.h; y++) {
+        const uint8_t* pixels = data ? data + y * stride : line;
+        if(rows && !rows->read_row(line)) {
+            ok = false;
+        } else if(rle) {
+            size_t len = image_stream_rle_row(pixels, header.w, px, packed);
+            ok         = out.write(packed, len) == len;
+        } else {
+            ok = out.write(pixels, stride) == stride;
+        }
+    }
+
+    delete rows;
+    hasp_free(data);
+    hasp_free(line);
+    hasp_free(packed);
+    return ok;
+}
+
+/* ===== LVGL Decoder ===== */
+
+/* File of the lvgl filesystem drivers */
+class ImageStreamFile : public Stream {
+  public:
+    ImageStreamFile() : _open(false)
+    {}
+    ~ImageStreamFile()
+    {
+        close();
+    }
+
+    bool open(const char* path)
+    {
+        close();
+        _open = lv_fs_open(&_file, path, LV_FS_MODE_RD) == LV_FS_RES_OK;
+        return _open;
+    }
+    void close()
+    {
+        if(_open) lv_fs_close(&_file);
+        _open = false;
+    }
+    bool rewind()
+    {
+        return _open && lv_fs_seek(&_file, 0) == LV_FS_RES_OK;
+    }
+
+    size_t readBytes(char* buffer, size_t length) override
+    {
+        uint32_t read = 0;
+        if(!_open || lv_fs_read(&_file, buffer, length, &read) != LV_FS_RES_OK) return 0;
+        return read;
+    }
+    int read() override
+    {
+        char c;
+        return readBytes(&c, 1) == 1 ? (uint8_t)c : -1;
+    }
+    int available() override
+    {
+        return _open ? 1 : 0;
+    }
+    int peek() override
+    {
+        return -1;
+    }
+    size_t write(uint8_t c) override
+    {
+        return 0;
+    }
+
+  private:
+    lv_fs_file_t _file;
+    bool _open;
+};
+
+/* Image file too large to decode at once, read again from the top when lvgl goes back up */
+typedef struct
+{
+    ImageStreamFile file;
+    ImageStreamSource* src;
+    ImageStreamRows* rows;
+    uint8_t* line; // the last row read, native format
+} image_stream_lines_t;
+
+enum : uint8_t { IMAGE_STREAM_EXT_NONE, IMAGE_STREAM_EXT_ENCODED, IMAGE_STREAM_EXT_BIN };
+
+static uint8_t image_stream_ext(const char* path)
+{
+    const char* ext = strrchr(path, '.');
+    if(!ext) return IMAGE_STREAM_EXT_NONE;
+    if(!strcasecmp(ext, ".bin")) return IMAGE_STREAM_EXT_BIN;
+    if(!strcasecmp(ext, ".png")) return IMAGE_STREAM_EXT_ENCODED;
+#if IMAGE_STREAM_JPG
+    if(!strcasecmp(ext, ".jpg") || !strcasecmp(ext, ".jpeg")) return IMAGE_STREAM_EXT_ENCODED;
+#endif
+    return IMAGE_STREAM_EXT_NONE;
+}
+
+bool image_stream_native_path(const char* path, char* native, size_t size)
+{
+    return image_stream_ext(path) == IMAGE_STREAM_EXT_ENCODED &&
+           snprintf_P(native, size, PSTR("%s.bin"), path) < (int)size;
+}
+
+static bool image_stream_is_file(const void* src)
+{
+    return lv_img_src_get_type(src) == LV_IMG_SRC_FILE && image_stream_ext((const char*)src) != IMAGE_STREAM_EXT_NONE;
+}
+
+/* A png or jpg file is read from its converted .bin when there is one, the src keeps the original name */
+static bool image_stream_open(ImageStreamFile& file, const char* path)
+{
+    char native[IMAGE_STREAM_PATH_SIZE];
+    if(image_stream_native_path(path, native, sizeof(native)) && file.open(native)) return true;
+    return file.open(path);
+}
+
+static lv_res_t image_stream_decoder_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+    if(!image_stream_is_file(src)) return LV_RES_INV;
+
+    ImageStreamFile file;
+    if(!image_stream_open(file, (const char*)src)) return LV_RES_INV;
+    return image_stream_info(file, header) ? LV_RES_OK : LV_RES_INV;
+}
+
+static void image_stream_lines_free(image_stream_lines_t* lines)
+{
+    delete lines->rows;
+    delete lines->src;
+    hasp_free(lines->line);
+    delete lines;
+}
+
+static bool image_stream_lines_begin(image_stream_lines_t* lines, lv_img_header_t* header)
+{
+    delete lines->rows;
+    delete lines->src;
+    lines->rows = NULL;
+    lines->src  = new ImageStreamSource(lines->file);
+    if(!lines->src || !lines->file.rewind() || !lines->src->begin()) return false;
+
+    lines->rows = image_stream_rows_create(*lines->src);
+    return lines->rows && lines->rows->begin(header);
+}
+
+static lv_res_t image_stream_decoder_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    if(!image_stream_is_file(dsc->src)) return LV_RES_INV;
+
+    const lv_img_header_t* header = &dsc->header;
+    uint32_t size =
+        header->w * header->h * (header->cf == LV_IMG_CF_TRUE_COLOR_ALPHA ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t));
+    uint32_t limit = hasp_use_psram() ? IMAGE_STREAM_BUFFER_SIZE_PSRAM : IMAGE_STREAM_BUFFER_SIZE;
+
+    if(size <= limit) {
+        ImageStreamFile file;
+        uint32_t start = millis();
+        if(!image_stream_open(file, (const char*)dsc->src)) return LV_RES_INV;
+        dsc->img_data = image_stream_decode(file, &dsc->header, &size);
+        if(dsc->img_data) {
+            dsc->time_to_open = millis() - start; // kept longer in the lvgl image cache
+            return LV_RES_OK;
+        }
+    }
+
+    // Too large for one buffer, PNG and .bin rows are read while they are drawn
+    image_stream_lines_t* lines = new image_stream_lines_t();
+    if(!lines) return LV_RES_INV;
+    lines->src  = NULL;
+    lines->rows = NULL;
+    lines->line = NULL;
+
+    lv_img_header_t rows_header;
+    if(!image_stream_open(lines->file, (const char*)dsc->src) || !image_stream_lines_begin(lines, &rows_header)) {
+        image_stream_lines_free(lines);
+        return LV_RES_INV; // JPEG is left to the split jpg decoder
+    }
+
+    lines->line = (uint8_t*)hasp_malloc(lines->rows->width * lines->rows->native_px);
+    if(!lines->line) {
+        image_stream_lines_free(lines);
+        return LV_RES_INV;
+    }
+
+    LOG_VERBOSE(TAG_IMG, F("Decoding %s per line, %u bytes"), (const char*)dsc->src, size);
+    dsc->img_data  = NULL;
+    dsc->user_data = lines;
+    return LV_RES_OK;
+}
+
+static lv_res_t image_stream_decoder_read_line(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc, lv_coord_t x,
+                                               lv_coord_t y, lv_coord_t len, uint8_t* buf)
+{
+    image_stream_lines_t* lines = (image_stream_lines_t*)dsc->user_data;
+    if(!lines || !lines->rows) return LV_RES_INV;
+
+    ImageStreamRows* rows = lines->rows;
+    if(y < rows->row - 1) {
+        lv_img_header_t header;
+        if(!image_stream_lines_begin(lines, &header)) return LV_RES_INV;
+        rows = lines->rows;
+    }
+
+    while(rows->row <= y) {
+        if(!rows->read_row(lines->line)) return LV_RES_INV;
+    }
+
+    memcpy(buf, lines->line + x * rows->native_px, len * rows->native_px);
+    return LV_RES_OK;
+}
+
+static void image_stream_decoder_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    if(dsc->user_data) {
+        image_stream_lines_free((image_stream_lines_t*)dsc->user_data);
+        dsc->user_data = NULL;
+    }
+    if(dsc->img_data) {
+        hasp_free((void*)dsc->img_data);
+        dsc->img_data = NULL;
+    }
+}
+
+void image_stream_init(void)
+{
+    // Created after lv_png, split jpg and the built-in .bin decoder, so it is tried before them
+    lv_img_decoder_t* decoder = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(decoder, image_stream_decoder_info);
+    lv_img_decoder_set_open_cb(decoder, image_stream_decoder_open);
+    lv_img_decoder_set_read_line_cb(decoder, image_stream_decoder_read_line);
+    lv_img_decoder_set_close_cb(decoder, image_stream_decoder_close);
+}
+
+/* Keep the .bin of an uploaded png or jpg file in step with it */
+void image_stream_file_changed(const char* path)
+{
+    char other[IMAGE_STREAM_PATH_SIZE];
+    size_t len = strlen(path);
+    if(len + 5 > sizeof(other)) return;
+
+    switch(image_stream_ext(path)) {
+        case IMAGE_STREAM_EXT_BIN: // a converted file was uploaded, the original src shows it now
+            memcpy(other, path, len - 4);
+            other[len - 4] = '\0';
+#if HASP_USE_IMAGE_CACHE > 0
+            if(image_stream_ext(other) == IMAGE_STREAM_EXT_ENCODED) image_cache_invalidate_file(other);
+#endif
+            break;
+
+        case IMAGE_STREAM_EXT_ENCODED:
+            image_stream_native_path(path, other, sizeof(other));
+            if(HASP_FS.exists(other)) HASP_FS.remove(other); // stale
+#if IMAGE_STREAM_CONVERT > 0 && HASP_USE_IMAGE_FETCH > 0
+            if(HASP_FS.exists(path)) image_fetch_convert(path);
+#endif
+            break;
+    }
+}
+
+void image_stream_get_info(JsonDocument& doc)
+{
+    char buffer[32];
+    JsonObject info = doc.createNestedObject(F("Image Decoder"));
+
+    for(uint8_t format = 0; format < IMAGE_STREAM_FORMATS; format++) {
+        const image_stream_stats_t* stats = &image_stream_stats[format];
+        if(stats->count == 0) continue;
+        snprintf_P(buffer, sizeof(buffer), PSTR("%u x %u ms"), stats->count, stats->ms / stats->count);
+        info[image_stream_format_names[format]] = buffer;
+    }
+}
+
+#endif
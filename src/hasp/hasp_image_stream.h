@@ -0,0 +1,57 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_IMAGE_STREAM_H
+#define HASP_IMAGE_STREAM_H
+
+#if HASP_USE_IMAGE_STREAM > 0
+
+/* PNG and baseline JPEG decoded while they are read
+ *
+ * The encoded file is never held in memory. PNG rows are inflated with the ROM inflate into a 32 KiB window
+ * and two rows of the image, baseline JPEG blocks are decoded with the ROM TJpgDec. The pixels are written
+ * into a buffer of the native format, with an alpha byte only when the PNG has transparency.
+ * Image files that do not fit in IMAGE_STREAM_BUFFER_SIZE(_PSRAM) are decoded one line at a time
+ * while they are drawn, so the memory then depends on the width of the PNG only.
+ * Interlaced PNG and progressive JPEG files are left to the lv_png and split jpg decoders.
+ *
+ * A png or jpg file is read from <name>.bin next to it when it exists, an LVGL .bin image in the native
+ * true color format that only has to be copied. The pixels can be run-length encoded, marked by
+ * IMAGE_STREAM_FLAG_RLE in the reserved bits of the header. With IMAGE_STREAM_CONVERT uploaded files are
+ * converted in the background when the .bin fits, tools/hasp_image_convert.py converts them on the computer.
+ */
+
+#ifndef IMAGE_STREAM_BUFFER_SIZE
+#define IMAGE_STREAM_BUFFER_SIZE (64 * 1024) // largest decoded image in internal ram
+#endif
+#ifndef IMAGE_STREAM_BUFFER_SIZE_PSRAM
+#define IMAGE_STREAM_BUFFER_SIZE_PSRAM (2048 * 1024) // largest decoded image in psram
+#endif
+#ifndef IMAGE_STREAM_CONVERT
+#define IMAGE_STREAM_CONVERT 0 // uploaded png and jpg files get a .bin, it takes flash space
+#endif
+#ifndef IMAGE_STREAM_CONVERT_RESERVE
+#define IMAGE_STREAM_CONVERT_RESERVE (16 * 1024) // free filesystem space left after a conversion
+#endif
+#ifndef IMAGE_STREAM_CONVERT_RLE
+#define IMAGE_STREAM_CONVERT_RLE 1 // run-length encode the converted pixels
+#endif
+
+#define IMAGE_STREAM_FLAG_RLE 0x01 // lv_img_header_t.reserved
+
+/* ===== Default Event Processors ===== */
+void image_stream_init(void); // decoder of png, jpg and .bin files
+
+/* ===== Special Event Processors ===== */
+uint8_t* image_stream_decode(Stream& in, lv_img_header_t* header, uint32_t* size); // PNG, JPEG or LVGL .bin
+bool image_stream_info(Stream& in, lv_img_header_t* header);
+bool image_stream_convert(Stream& in, Print& out, bool rle); // PNG or JPEG to LVGL .bin
+uint32_t image_stream_convert_size(const lv_img_header_t* header, bool rle); // largest .bin it writes
+void image_stream_file_changed(const char* path);          // path on the filesystem without the drive letter
+
+/* ===== Getter and Setter Functions ===== */
+bool image_stream_native_path(const char* path, char* native, size_t size); // false if it is not png or jpg
+void image_stream_get_info(JsonDocument& doc);
+
+#endif
+#endif
@@ -0,0 +1,456 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hasp_img_encoder.h"
+#include "../drv/gpu/pixel_kernels.h"
+
+/* ===== Output ===== */
+
+static void enc_write(img_encoder_t* enc, const uint8_t* data, size_t len)
+{
+    if(enc->error || len == 0) return;
+    if(enc->write(data, len) != len) enc->error = true;
+    enc->total += len;
+}
+
+static uint32_t enc_crc32(uint32_t crc, const uint8_t* data, size_t len)
+{
+    // nibble table, small enough for flash and fast enough for 512 byte chunks
+    static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                       0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                       0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    crc = ~crc;
+    for(size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static void put_be32(uint8_t* dest, uint32_t value)
+{
+    dest[0] = value >> 24;
+    dest[1] = value >> 16;
+    dest[2] = value >> 8;
+    dest[3] = value;
+}
+
+/* ===== PNG ===== */
+
+static void png_chunk(img_encoder_t* enc, const char* type, const uint8_t* data, size_t len)
+{
+    uint8_t header[8];
+    uint8_t footer[4];
+    put_be32(header, len);
+    memcpy(header + 4, type, 4);
+    put_be32(footer, enc_crc32(enc_crc32(0, header + 4, 4), data, len));
+
+    enc_write(enc, header, sizeof(header));
+    enc_write(enc, data, len);
+    enc_write(enc, footer, sizeof(footer));
+}
+
+static void png_flush(img_encoder_t* enc)
+{
+    png_chunk(enc, "IDAT", enc->buf, enc->buf_len);
+    enc->buf_len = 0;
+}
+
+static inline void png_byte(img_encoder_t* enc, uint8_t value)
+{
+    enc->buf[enc->buf_len++] = value;
+    if(enc->buf_len == sizeof(enc->buf)) png_flush(enc);
+}
+
+static inline void png_bits(img_encoder_t* enc, uint32_t value, uint8_t count)
+{
+    enc->bits |= value << enc->bit_count;
+    enc->bit_count += count;
+    while(enc->bit_count >= 8) {
+        png_byte(enc, enc->bits);
+        enc->bits >>= 8;
+        enc->bit_count -= 8;
+    }
+}
+
+// Huffman codes are stored most significant bit first
+static inline void png_code(img_encoder_t* enc, uint32_t code, uint8_t count)
+{
+    uint32_t reversed = 0;
+    for(uint8_t i = 0; i < count; i++, code >>= 1) reversed = (reversed << 1) | (code & 1);
+    png_bits(enc, reversed, count);
+}
+
+// Fixed Huffman literal/length alphabet of RFC 1951
+static inline void png_symbol(img_encoder_t* enc, uint16_t symbol)
+{
+    if(symbol < 144)
+        png_code(enc, 0x30 + symbol, 8);
+    else if(symbol < 256)
+        png_code(enc, 0x190 + symbol - 144, 9);
+    else if(symbol < 280)
+        png_code(enc, symbol - 256, 7);
+    else
+        png_code(enc, 0xC0 + symbol - 280, 8);
+}
+
+static void png_match(img_encoder_t* enc, uint16_t length, uint8_t distance)
+{
+    static const uint16_t base[29]  = {3,  4,  5,  6,  7,  8,  9,  10,  11,  13,  15,  17,  19,  23, 27,
+                                       31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const uint8_t extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    uint8_t i = 28;
+    while(base[i] > length) i--;
+    png_symbol(enc, 257 + i);
+    if(extra[i]) png_bits(enc, length - base[i], extra[i]);
+    png_code(enc, distance - 1, 5); // distance 1 to 4 are codes 0 to 3 without extra bits
+}
+
+static void png_adler32(img_encoder_t* enc, const uint8_t* data, size_t len)
+{
+    uint32_t a = enc->adler & 0xFFFF;
+    uint32_t b = enc->adler >> 16;
+    while(len > 0) {
+        size_t count = len < 5552 ? len : 5552; // largest block without overflow
+        len -= count;
+        while(count--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    enc->adler = (b << 16) | a;
+}
+
+/* Compress a filtered row, only matching the previous byte or the previous pixel
+ * Filtered flat areas become runs of zeros and repeated pixels, which is where a UI spends its bytes */
+static void png_deflate(img_encoder_t* enc, const uint8_t* data, size_t len)
+{
+    size_t i = 0;
+    while(i < len) {
+        uint16_t best_len  = 0;
+        uint8_t best_dist = 0;
+        for(uint8_t dist = 1; dist <= 3; dist += 2) {
+            uint16_t count = 0;
+            size_t max     = len - i < 258 ? len - i : 258;
+            while(count < max) {
+                size_t pos = i + count;
+                if(pos < dist && enc->row == 0) break; // no history before the first row
+                uint8_t match = pos >= dist ? data[pos - dist] : enc->hist[3 + pos - dist];
+                if(data[pos] != match) break;
+                count++;
+            }
+            if(count > best_len) {
+                best_len  = count;
+                best_dist = dist;
+            }
+        }
+
+        if(best_len >= 3) {
+            png_match(enc, best_len, best_dist);
+            i += best_len;
+        } else {
+            png_symbol(enc, data[i++]);
+        }
+    }
+    memcpy(enc->hist, data + len - 3, 3);
+}
+
+static inline uint8_t png_cost(uint8_t value)
+{
+    return value < 128 ? value : 256 - value;
+}
+
+static void png_row(img_encoder_t* enc)
+{
+    size_t len        = enc->width * 3;
+    const uint8_t* px = enc->line;
+    const uint8_t* up = enc->prev;
+    uint32_t cost_sub = 0, cost_up = 0;
+
+    for(size_t i = 0; i < len; i++) {
+        cost_sub += png_cost(px[i] - (i >= 3 ? px[i - 3] : 0));
+        cost_up += png_cost(px[i] - up[i]);
+    }
+
+    uint8_t* out = enc->filt;
+    if(cost_sub < cost_up) {
+        *out++ = 1; // Sub
+        for(size_t i = 0; i < len; i++) *out++ = px[i] - (i >= 3 ? px[i - 3] : 0);
+    } else {
+        *out++ = 2; // Up
+        for(size_t i = 0; i < len; i++) *out++ = px[i] - up[i];
+    }
+
+    png_adler32(enc, enc->filt, len + 1);
+    png_deflate(enc, enc->filt, len + 1);
+
+    enc->prev = enc->line; // swap buffers
+    enc->line = (uint8_t*)up;
+}
+
+static void png_begin(img_encoder_t* enc)
+{
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t ihdr[13];
+    put_be32(ihdr, enc->width);
+    put_be32(ihdr + 4, enc->height);
+    ihdr[8]  = 8; // bit depth
+    ihdr[9]  = 2; // truecolor RGB
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // adaptive filtering
+    ihdr[12] = 0; // no interlace
+
+    enc_write(enc, signature, sizeof(signature));
+    png_chunk(enc, "IHDR", ihdr, sizeof(ihdr));
+
+    enc->adler = 1;
+    png_byte(enc, 0x78); // zlib header, deflate
+    png_byte(enc, 0x01);
+    png_bits(enc, 1, 1); // single final block
+    png_bits(enc, 1, 2); // fixed Huffman codes
+}
+
+static void png_end(img_encoder_t* enc)
+{
+    png_symbol(enc, 256); // end of block
+    if(enc->bit_count > 0) png_bits(enc, 0, 8 - enc->bit_count);
+
+    uint8_t adler[4];
+    put_be32(adler, enc->adler);
+    for(uint8_t b : adler) png_byte(enc, b);
+    png_flush(enc);
+    png_chunk(enc, "IEND", NULL, 0);
+}
+
+/* ===== QOI ===== */
+
+static inline void qoi_byte(img_encoder_t* enc, uint8_t value)
+{
+    enc->buf[enc->buf_len++] = value;
+    if(enc->buf_len == sizeof(enc->buf)) {
+        enc_write(enc, enc->buf, enc->buf_len);
+        enc->buf_len = 0;
+    }
+}
+
+static void qoi_flush_run(img_encoder_t* enc)
+{
+    if(enc->qoi_run == 0) return;
+    qoi_byte(enc, 0xC0 | (enc->qoi_run - 1)); // QOI_OP_RUN
+    enc->qoi_run = 0;
+}
+
+static void qoi_row(img_encoder_t* enc)
+{
+    const uint8_t* px = enc->line;
+    uint8_t* prev     = enc->qoi_prev;
+
+    for(uint16_t x = 0; x < enc->width; x++, px += 3) {
+        if(px[0] == prev[0] && px[1] == prev[1] && px[2] == prev[2]) {
+            if(++enc->qoi_run == 62) qoi_flush_run(enc);
+            continue;
+        }
+        qoi_flush_run(enc);
+
+        uint8_t hash  = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) % 64;
+        uint8_t* slot = enc->qoi_index + hash * 4;
+        if(slot[3] && slot[0] == px[0] && slot[1] == px[1] && slot[2] == px[2]) {
+            qoi_byte(enc, hash); // QOI_OP_INDEX
+        } else {
+            memcpy(slot, px, 3);
+            slot[3] = 255;
+
+            int8_t vr   = px[0] - prev[0];
+            int8_t vg   = px[1] - prev[1];
+            int8_t vb   = px[2] - prev[2];
+            int8_t vg_r = vr - vg;
+            int8_t vg_b = vb - vg;
+            if(vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1) {
+                qoi_byte(enc, 0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)); // QOI_OP_DIFF
+            } else if(vg >= -32 && vg <= 31 && vg_r >= -8 && vg_r <= 7 && vg_b >= -8 && vg_b <= 7) {
+                qoi_byte(enc, 0x80 | (vg + 32)); // QOI_OP_LUMA
+                qoi_byte(enc, (vg_r + 8) << 4 | (vg_b + 8));
+            } else {
+                qoi_byte(enc, 0xFE); // QOI_OP_RGB
+                qoi_byte(enc, px[0]);
+                qoi_byte(enc, px[1]);
+                qoi_byte(enc, px[2]);
+            }
+        }
+        memcpy(prev, px, 3);
+    }
+}
+
+static void qoi_begin(img_encoder_t* enc)
+{
+    uint8_t header[14] = {'q', 'o', 'i', 'f'};
+    put_be32(header + 4, enc->width);
+    put_be32(header + 8, enc->height);
+    header[12] = 3; // RGB
+    header[13] = 0; // sRGB
+    enc_write(enc, header, sizeof(header));
+}
+
+static void qoi_end(img_encoder_t* enc)
+{
+    qoi_flush_run(enc);
+    for(uint8_t i = 0; i < 7; i++) qoi_byte(enc, 0x00);
+    qoi_byte(enc, 0x01);
+    enc_write(enc, enc->buf, enc->buf_len);
+    enc->buf_len = 0;
+}
+
+/* ===== Encoder ===== */
+
+static void enc_free(img_encoder_t* enc)
+{
+    free(enc->line < enc->prev ? enc->line : enc->prev); // line and prev share one allocation
+    free(enc->filt);
+    free(enc->src_rgb);
+    free(enc->accu);
+    free(enc->tmp);
+    enc->line = enc->prev = enc->filt = enc->src_rgb = NULL;
+    enc->accu = enc->tmp = NULL;
+}
+
+bool img_encoder_init(img_encoder_t* enc, uint8_t format, uint16_t max_width, uint8_t scale, bool swapped)
+{
+    memset(enc, 0, sizeof(img_encoder_t));
+    if(scale < 1 || scale > IMG_ENCODER_MAX_SCALE || max_width < scale) return false;
+
+    enc->format    = format;
+    enc->scale     = scale;
+    enc->swapped   = swapped;
+    enc->max_width = max_width;
+
+    size_t line_len = max_width / scale * 3;
+    enc->line       = (uint8_t*)malloc(2 * line_len);
+    enc->prev       = enc->line + line_len;
+    bool ok         = enc->line != NULL;
+    if(format == IMG_ENCODER_PNG) ok &= (enc->filt = (uint8_t*)malloc(line_len + 1)) != NULL;
+    if(scale > 1) {
+        ok &= (enc->src_rgb = (uint8_t*)malloc(max_width * 3)) != NULL;
+        ok &= (enc->accu = (uint16_t*)malloc(line_len * sizeof(uint16_t))) != NULL;
+    }
+    if(swapped) ok &= (enc->tmp = (uint16_t*)malloc(max_width * sizeof(uint16_t))) != NULL;
+    if(!ok) enc_free(enc);
+    return ok;
+}
+
+bool img_encoder_begin(img_encoder_t* enc, uint16_t width, uint16_t height, img_encoder_write_t write)
+{
+    uint8_t scale = enc->scale;
+    if(!enc->line || width > enc->max_width || width < scale || height < scale || !write) return false;
+
+    // reset the image state, the buffers are kept
+    enc->write      = write;
+    enc->error      = false;
+    enc->src_width  = width;
+    enc->src_height = height;
+    enc->src_row    = 0;
+    enc->width      = width / scale;
+    enc->height     = height / scale;
+    enc->row        = 0;
+    enc->total      = 0;
+    enc->buf_len    = 0;
+    enc->bits       = 0;
+    enc->bit_count  = 0;
+    enc->qoi_run    = 0;
+    memset(enc->qoi_index, 0, sizeof(enc->qoi_index));
+    memset(enc->qoi_prev, 0, sizeof(enc->qoi_prev));
+
+    size_t line_len = enc->width * 3;
+    if(enc->prev < enc->line) enc->line = enc->prev; // restore the order of the shared allocation
+    enc->prev = enc->line + enc->max_width / scale * 3;
+    memset(enc->prev, 0, line_len); // the up filter of the first row
+    if(enc->accu) memset(enc->accu, 0, line_len * sizeof(uint16_t));
+
+    if(enc->format == IMG_ENCODER_PNG)
+        png_begin(enc);
+    else
+        qoi_begin(enc);
+    return !enc->error;
+}
+
+static void enc_emit_row(img_encoder_t* enc)
+{
+    if(enc->format == IMG_ENCODER_PNG)
+        png_row(enc);
+    else
+        qoi_row(enc);
+    enc->row++;
+}
+
+void img_encoder_push(img_encoder_t* enc, const uint16_t* pixels, uint16_t rows)
+{
+    uint8_t scale   = enc->scale;
+    size_t line_len = enc->width * 3;
+
+    for(uint16_t r = 0; r < rows && !enc->error; r++, pixels += enc->src_width) {
+        if(enc->row >= enc->height) break; // remainder rows of a thumbnail
+
+        const uint16_t* src = pixels;
+        if(enc->swapped) {
+            pixel_kernels->swap16(enc->tmp, src, enc->src_width);
+            src = enc->tmp;
+        }
+
+        if(scale == 1) {
+            pixel_kernels->to_rgb888(enc->line, src, enc->width);
+            enc_emit_row(enc);
+            continue;
+        }
+
+        // box filter, sum scale x scale source pixels per thumbnail pixel
+        pixel_kernels->to_rgb888(enc->src_rgb, src, enc->src_width);
+        const uint8_t* in = enc->src_rgb;
+        for(size_t x = 0; x < enc->width; x++) {
+            uint16_t* sum = enc->accu + x * 3;
+            for(uint8_t s = 0; s < scale; s++, in += 3) {
+                sum[0] += in[0];
+                sum[1] += in[1];
+                sum[2] += in[2];
+            }
+        }
+
+        if(++enc->src_row % scale == 0) {
+            uint16_t area = scale * scale;
+            for(size_t i = 0; i < line_len; i++) {
+                enc->line[i] = (enc->accu[i] + area / 2) / area;
+                enc->accu[i] = 0;
+            }
+            enc_emit_row(enc);
+        }
+    }
+}
+
+size_t img_encoder_end(img_encoder_t* enc)
+{
+    if(enc->row != enc->height) enc->error = true; // incomplete image
+
+    if(!enc->error) {
+        if(enc->format == IMG_ENCODER_PNG)
+            png_end(enc);
+        else
+            qoi_end(enc);
+    }
+
+    return enc->error ? 0 : enc->total;
+}
+
+void img_encoder_free(img_encoder_t* enc)
+{
+    enc_free(enc);
+}
+
+const char* img_encoder_mimetype(uint8_t format)
+{
+    return format == IMG_ENCODER_PNG ? "image/png" : "image/qoi";
+}
@@ -0,0 +1,72 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_IMG_ENCODER_H
+#define HASP_IMG_ENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Streaming PNG and QOI encoder for RGB565 rows
+ *
+ * Rows are pushed top to bottom as they are flushed by lvgl and the compressed image is handed to the
+ * write callback in small pieces, so neither the image nor the compressed file is ever held in memory.
+ * An optional scale factor produces a box filtered thumbnail. PNG uses a fixed Huffman deflate stream
+ * with run matching, which suits the flat areas of a user interface and needs no window.
+ */
+
+enum img_encoder_format_t : uint8_t {
+    IMG_ENCODER_PNG = 0,
+    IMG_ENCODER_QOI = 1,
+};
+
+#define IMG_ENCODER_MAX_SCALE 8
+#define IMG_ENCODER_BUFSIZE 512 // bytes per write callback and per PNG IDAT chunk
+
+typedef size_t (*img_encoder_write_t)(const uint8_t* buf, size_t len);
+
+typedef struct
+{
+    img_encoder_write_t write;
+    uint8_t format;
+    uint8_t scale;
+    bool swapped; // source pixels are RGB565 with the bytes swapped
+    bool error;
+    uint16_t max_width; // source pixels the buffers are allocated for
+    uint16_t src_width, src_height, src_row;
+    uint16_t width, height, row;
+    size_t total; // bytes written
+
+    uint8_t* line;    // current output row, RGB888
+    uint8_t* prev;    // previous output row, for the PNG up filter
+    uint8_t* filt;    // filtered PNG row, including the filter type byte
+    uint8_t* src_rgb; // source row, RGB888, when scaling
+    uint16_t* accu;   // box filter sums, when scaling
+    uint16_t* tmp;    // unswapped source row
+
+    uint8_t buf[IMG_ENCODER_BUFSIZE];
+    size_t buf_len;
+
+    // PNG deflate state
+    uint32_t adler;
+    uint32_t bits;
+    uint8_t bit_count;
+    uint8_t hist[3]; // last bytes of the previous row, for matches across rows
+
+    // QOI state
+    uint8_t qoi_index[64 * 4]; // RGBA, a zero alpha marks an unused slot
+    uint8_t qoi_prev[3];
+    uint8_t qoi_run;
+} img_encoder_t;
+
+/* The buffers are allocated once by img_encoder_init and reused by every image until img_encoder_free,
+ * nothing is written before img_encoder_begin */
+bool img_encoder_init(img_encoder_t* enc, uint8_t format, uint16_t max_width, uint8_t scale, bool swapped);
+bool img_encoder_begin(img_encoder_t* enc, uint16_t width, uint16_t height, img_encoder_write_t write);
+void img_encoder_push(img_encoder_t* enc, const uint16_t* pixels, uint16_t rows); // full width rows
+size_t img_encoder_end(img_encoder_t* enc); // returns the image size, or 0 on error
+void img_encoder_free(img_encoder_t* enc);
+
+const char* img_encoder_mimetype(uint8_t format);
+
+#endif // HASP_IMG_ENCODER_H
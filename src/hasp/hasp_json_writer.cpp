@@ -0,0 +1,123 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasp_json_writer.h"
+
+#ifdef ARDUINO
+
+void JsonStreamWriter::separator()
+{
+    if(_need_comma) _out.write(',');
+    _need_comma = false;
+}
+
+void JsonStreamWriter::write_string(const char* str)
+{
+    _out.write('"');
+    if(str) {
+        const char* start = str;
+        for(; *str; str++) {
+            uint8_t c = *str;
+            if(c >= 0x20 && c != '"' && c != '\\') continue;
+
+            _out.write((const uint8_t*)start, str - start); // unescaped part
+            start = str + 1;
+            _out.write('\\');
+            switch(c) {
+                case '"':
+                case '\\':
+                    _out.write(c);
+                    break;
+                case '\b':
+                    _out.write('b');
+                    break;
+                case '\f':
+                    _out.write('f');
+                    break;
+                case '\n':
+                    _out.write('n');
+                    break;
+                case '\r':
+                    _out.write('r');
+                    break;
+                case '\t':
+                    _out.write('t');
+                    break;
+                default:
+                    _out.printf("u%04x", c);
+            }
+        }
+        _out.write((const uint8_t*)start, str - start);
+    }
+    _out.write('"');
+}
+
+void JsonStreamWriter::begin_object()
+{
+    separator();
+    _out.write('{');
+}
+
+void JsonStreamWriter::end_object()
+{
+    _out.write('}');
+    _need_comma = true;
+}
+
+void JsonStreamWriter::begin_array()
+{
+    separator();
+    _out.write('[');
+}
+
+void JsonStreamWriter::end_array()
+{
+    _out.write(']');
+    _need_comma = true;
+}
+
+void JsonStreamWriter::key(const char* name)
+{
+    separator();
+    write_string(name);
+    _out.write(':');
+}
+
+void JsonStreamWriter::key(const __FlashStringHelper* name)
+{
+    char buffer[32];
+    strncpy_P(buffer, (PGM_P)name, sizeof(buffer));
+    buffer[sizeof(buffer) - 1] = 0;
+    key(buffer);
+}
+
+void JsonStreamWriter::value(const char* str)
+{
+    separator();
+    write_string(str);
+    _need_comma = true;
+}
+
+void JsonStreamWriter::value(JsonVariantConst value)
+{
+    separator();
+    serializeJson(value, _out);
+    _need_comma = true;
+}
+
+void JsonStreamWriter::serialized(const char* json)
+{
+    separator();
+    _out.print(json);
+    _need_comma = true;
+}
+
+void JsonStreamWriter::merge(JsonObjectConst obj)
+{
+    for(JsonPairConst kv : obj) {
+        key(kv.key().c_str());
+        value(kv.value());
+    }
+}
+
+#endif
@@ -0,0 +1,51 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_JSON_WRITER_H
+#define HASP_JSON_WRITER_H
+
+#include "hasplib.h"
+
+#ifdef ARDUINO
+
+/* Streaming JSON writer
+ *
+ * Writes a JSON document to a Print token by token, so large responses are never held in memory.
+ * Only the subtree being written needs a JsonDocument, which can be cleared and reused between calls.
+ * Commas between members and elements are inserted automatically.
+ */
+class JsonStreamWriter {
+
+  public:
+    JsonStreamWriter(Print& out) : _out(out), _need_comma(false)
+    {}
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+
+    void key(const char* name);
+    void key(const __FlashStringHelper* name);
+    void value(const char* str);
+    void value(JsonVariantConst value);
+    void serialized(const char* json); // value that is already valid JSON
+    void merge(JsonObjectConst obj); // members of obj into the current object
+
+    template <typename T> void number(T value)
+    {
+        separator();
+        _out.print(value);
+        _need_comma = true;
+    }
+
+  private:
+    Print& _out;
+    bool _need_comma;
+
+    void separator();
+    void write_string(const char* str);
+};
+
+#endif
+#endif
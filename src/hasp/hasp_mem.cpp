@@ -53,12 +53,18 @@ void* lodepng_malloc(size_t size)
     if(size > LODEPNG_MAX_ALLOC) return 0;
 #endif
 
-    // void* ptr = hasp_malloc(size);
-    // if(ptr) return ptr;
+    void* ptr = hasp_malloc(size);
+#if HASP_USE_IMAGE_CACHE > 0
+    if(ptr) return ptr;
+#if HASP_USE_IMAGE_FETCH > 0
+    if(image_fetch_in_worker()) return ptr; // the cache belongs to the GUI thread
+#endif
 
-    // /* PSram was full retry after clearing cache*/
-    // lv_img_cache_invalidate_src(NULL);
-    return hasp_malloc(size);
+    /* Memory was full, retry after closing the cached images that are not shown */
+    image_cache_trim();
+    ptr = hasp_malloc(size);
+#endif
+    return ptr;
 }
 
 /* NOTE: when realloc returns NULL, it leaves the original memory untouched */
@@ -740,4 +740,5 @@ void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
     }
 
     hasp_parse_json_attributes(obj, config);
+    font_prewarm(obj, config);
 }
@@ -19,6 +19,7 @@ typedef struct
     char* action;
     char* tag;
     const char* swipe;
+    const lv_font_t** fonts; // fonts retained by the object, NULL terminated
 } hasp_ext_user_data_t;
 
 typedef struct
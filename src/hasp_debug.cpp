@@ -328,6 +328,9 @@ void debug_get_tag(uint8_t tag, char* buffer)
         case TAG_FONT:
             memcpy_P(buffer, PSTR("FONT"), 5);
             break;
+        case TAG_IMG:
+            memcpy_P(buffer, PSTR("IMG "), 5);
+            break;
 
         case TAG_CUSTOM:
             memcpy_P(buffer, PSTR("CUST"), 5);
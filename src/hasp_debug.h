@@ -199,6 +199,7 @@ enum {
     TAG_LVGL = 90,
     TAG_LVFS = 91,
     TAG_FONT = 92,
+    TAG_IMG  = 93,
 
     TAG_CUSTOM = 99
 };
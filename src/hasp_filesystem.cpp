@@ -37,118 +37,135 @@ extern const uint8_t PAGES_JSONL_END[] asm("_binary_data_pages_pages_jsonl_end")
 
 #include "hasp_debug.h"
 #include "hasp_filesystem.h"
+#include "hasp/hasp_json_writer.h"
 
 #if defined(ARDUINO_ARCH_ESP32)
 #include "rom/crc.h"
+#include "hasp_unzip.h"
 
-void filesystemUnzip(const char*, const char* filename, uint8_t source)
+#if HASP_USE_IMAGE_CACHE > 0 || HASP_USE_IMAGE_STREAM > 0
+#include "lvgl.h"
+#endif
+#if HASP_USE_IMAGE_CACHE > 0
+#include "hasp/hasp_image_cache.h"
+#endif
+#if HASP_USE_IMAGE_STREAM > 0
+#include "hasp/hasp_image_stream.h"
+#endif
+
+#define FILESYSTEM_CRC_DIR "/.crc" // one small file per hashed file, short names also fit SPIFFS
+
+/* Content hash of a file with the size and modification time it was calculated for */
+typedef struct
 {
-    File zipfile = HASP_FS.open(filename, FILE_READ);
-    if(!zipfile) {
-        return;
-    }
+    uint32_t size;
+    uint32_t modified;
+    uint32_t crc;
+} filesystem_crc_t;
+
+static void filesystem_crc_path(const char* path, char* crc_path, size_t size)
+{
+    snprintf_P(crc_path, size, PSTR(FILESYSTEM_CRC_DIR "/%08x"), crc32_le(0, (const uint8_t*)path, strlen(path)));
+}
+
+static bool filesystem_crc_read(const char* crc_path, filesystem_crc_t* entry)
+{
+    if(!HASP_FS.exists(crc_path)) return false;
+
+    File file = HASP_FS.open(crc_path, FILE_READ);
+    bool ok   = file && file.read((uint8_t*)entry, sizeof(*entry)) == sizeof(*entry);
+    file.close();
+    return ok;
+}
+
+static void filesystem_crc_write(const char* crc_path, const filesystem_crc_t* entry)
+{
+    if(!HASP_FS.exists(FILESYSTEM_CRC_DIR)) HASP_FS.mkdir(FILESYSTEM_CRC_DIR);
+
+    File file = HASP_FS.open(crc_path, FILE_WRITE);
+    if(file) file.write((const uint8_t*)entry, sizeof(*entry));
+    file.close();
+}
 
-    int32_t head;
+static void filesystem_crc_calc(File& file, filesystem_crc_t* entry)
+{
+    uint8_t buffer[512];
     size_t len;
-    bool done = false;
-
-    zipfile.seek(0);
-    while(!done) {
-        len = zipfile.read((uint8_t*)&head, sizeof(head));
-        if(len != sizeof(head)) {
-            done = true;
-            continue;
-        }
+    entry->size     = file.size();
+    entry->modified = file.getLastWrite();
+    entry->crc      = 0;
+    file.seek(0);
+    while((len = file.read(buffer, sizeof(buffer))) > 0) entry->crc = crc32_le(entry->crc, buffer, len);
+    file.seek(0);
+}
 
-        switch(head) {
-            case 0x04034b50: {
-                zip_file_header_t fh;
-                zipfile.seek(zipfile.position() - 2, SeekSet); // rewind for struct alignment (26-28)
-                len = zipfile.read((uint8_t*)(&fh), sizeof(zip_file_header_t));
-                if(len != sizeof(zip_file_header_t)) {
-                    done = true;
-                    continue;
-                }
+uint32_t filesystem_get_crc(File& file)
+{
+    char crc_path[24];
+    filesystem_crc_t entry;
+    filesystem_crc_path(file.path(), crc_path, sizeof(crc_path));
+
+    // Files written without filesystem_changed() are caught by their size and modification time
+    if(filesystem_crc_read(crc_path, &entry) && entry.size == file.size() &&
+       entry.modified == (uint32_t)file.getLastWrite())
+        return entry.crc;
+
+    filesystem_crc_calc(file, &entry);
+    filesystem_crc_write(crc_path, &entry);
+    return entry.crc;
+}
 
-                if(fh.filename_length >= 255) {
-                    LOG_WARNING(TAG_FILE, F("filename length too long %d"), fh.filename_length);
-                    zipfile.seek(fh.filename_length + fh.extra_length, SeekCur); // skip extra field
-                    continue;
-                    // } else {
-                    //     LOG_WARNING(TAG_FILE, F("min %d - flag %d - len %d - xtra %d"), fh.min_version, fh.flags,
-                    //                 fh.filename_length, fh.extra_length);
-                }
-                char name[257] = {0};
-                name[0]        = '/';
-
-                len = zipfile.read((uint8_t*)&name[1], fh.filename_length);
-                if(len != fh.filename_length) {
-                    LOG_WARNING(TAG_FILE, F("filename read failed %d != %d"), fh.filename_length, len);
-                    done = true;
-                    continue;
-                }
-                zipfile.seek(fh.extra_length, SeekCur); // skip extra field
+/* Move a completed temporary file over its target
+ * LittleFS renames onto an existing file in one atomic step, so a reset never leaves the target missing.
+ * SPIFFS and FAT can not rename onto an existing file, there the target is removed first. */
+bool filesystem_replace(fs::FS& fs, const char* temp, const char* path)
+{
+#if HASP_USE_LITTLEFS > 0 && HASP_USE_SPIFFS == 0
+    if(&fs == &HASP_FS) return fs.rename(temp, path);
+#endif
+    if(fs.exists(path)) fs.remove(path);
+    return fs.rename(temp, path);
+}
 
-                if(fh.compression_method != ZIP_NO_COMPRESSION) {
-                    LOG_WARNING(TAG_FILE, F("Compression is not supported %d"), fh.compression_method);
-                    zipfile.seek(fh.compressed_size, SeekCur); // skip compressed file
-                } else {
+void filesystem_changed(const char* path)
+{
+    char crc_path[24];
+    filesystem_crc_path(path, crc_path, sizeof(crc_path));
 
-                    if(HASP_FS.exists(name)) HASP_FS.remove(name);
-
-                    File f = HASP_FS.open(name, FILE_WRITE);
-                    if(f) {
-                        uint8_t buffer[512];
-                        uint32_t crc32 = 0;
-
-                        while(!done && fh.compressed_size >= 512) {
-                            len = zipfile.readBytes((char*)&buffer, 512);
-                            if(len != 512) done = true;
-                            fh.compressed_size -= len;
-                            crc32 = crc32_le(crc32, buffer, len);
-                            f.write(buffer, len);
-                        }
-
-                        if(!done && fh.compressed_size > 0) {
-                            len = zipfile.readBytes((char*)&buffer, fh.compressed_size);
-                            if(len != fh.compressed_size) done = true;
-                            fh.compressed_size -= len;
-                            crc32 = crc32_le(crc32, buffer, len);
-                            f.write(buffer, len);
-                        }
-
-                        if(crc32 != fh.crc) done = true;
-
-                        if(!done) {
-                            Parser::format_bytes(fh.uncompressed_size, (char*)buffer, sizeof(buffer));
-                            LOG_VERBOSE(TAG_FILE, F(D_BULLET "%s (%s)"), name, buffer);
-                        } else {
-                            LOG_ERROR(TAG_FILE, F(D_FILE_SAVE_FAILED), name);
-                        }
-
-                        f.close();
-                    }
-                }
+    // The new content is hashed by the next filesystem_get_crc, not while a batch of files is written
+    if(HASP_FS.exists(crc_path)) HASP_FS.remove(crc_path);
 
-                break;
-            }
-            case 0x02014b50:
-                done = true;
-                break;
-            case 0x06054b50:
-                // end of file
-                done = true;
-                break;
-            default: {
-                char outputString[9];
-                itoa(head, outputString, 16);
-                LOG_WARNING(TAG_FILE, F("invalid %s"), outputString);
-                done = true;
-            }
-        }
+#if HASP_USE_IMAGE_CACHE > 0
+    image_cache_invalidate_file(path); // decode the new content
+#endif
+#if HASP_USE_IMAGE_STREAM > 0
+    image_stream_file_changed(path); // convert png and jpg files to .bin
+#endif
+#if HASP_USE_FONT_SUBSET > 0
+    font_subset_file_changed(path); // subset the fonts again for the new pages
+#endif
+}
+
+void filesystemUnzip(const char*, const char* filename, uint8_t source)
+{
+    File zipfile = HASP_FS.open(filename, FILE_READ);
+    if(!zipfile) {
+        return;
+    }
+
+    Unzipper unzip(HASP_FS, "/");
+    uint8_t buffer[512];
+    size_t len;
+    while((len = zipfile.read(buffer, sizeof(buffer))) > 0) {
+        if(!unzip.write(buffer, len)) break;
     }
     zipfile.close();
-    LOG_VERBOSE(TAG_FILE, F("extracting %s complete"), filename);
+
+    if(unzip.end()) {
+        LOG_VERBOSE(TAG_FILE, F("extracting %s complete"), filename);
+    } else {
+        LOG_ERROR(TAG_FILE, F("extracting %s failed, %u files saved"), filename, unzip.files());
+    }
 }
 #endif
 
@@ -236,10 +253,11 @@ void listDir_SD(fs::FS &fs, const char *dirname, uint8_t levels) {
   }
 }
 
-String filesystem_list(fs::FS& fs, const char* dirname, uint8_t levels)
+/* Write the directory tree as a JSON array, one entry at a time */
+void filesystem_list(JsonStreamWriter& json, fs::FS& fs, const char* dirname, uint8_t levels)
 {
     LOG_VERBOSE(TAG_FILE, "Listing directory: %s\n", dirname);
-    String data = "[";
+    json.begin_array();
 
     File root = fs.open(dirname);
     if(!root) {
@@ -249,33 +267,33 @@ String filesystem_list(fs::FS& fs, const char* dirname, uint8_t levels)
     } else {
         File file = root.openNextFile();
         while(file) {
-
-            if(data != "[") {
-                data += ",";
+            if(!strncmp_P(file.path(), PSTR(FILESYSTEM_CRC_DIR), sizeof(FILESYSTEM_CRC_DIR) - 1)) {
+                file = root.openNextFile(); // content hashes are internal
+                continue;
             }
-            data += "{\"name\":\"";
-            data += file.name();
-            data += "\"";
+            json.begin_object();
+            json.key("name");
+            json.value(file.name());
 
             if(file.isDirectory()) {
-                data += ",\"children\":";
+                json.key("children");
                 if(levels) {
                     String dir = dirname;
                     dir += file.name();
                     dir += '/';
-                    data += filesystem_list(fs, dir.c_str(), levels - 1);
+                    filesystem_list(json, fs, dir.c_str(), levels - 1);
                 } else {
-                    data += "[]";
+                    json.begin_array();
+                    json.end_array();
                 }
             }
-            data += "}";
+            json.end_object();
             file = root.openNextFile();
         }
         root.close();
     }
 
-    data += "]";
-    return data;
+    json.end_array();
 }
 #endif
 
@@ -14,24 +14,6 @@ void filesystemList();
 void filesystemInfo();
 void filesystemSetupFiles();
 
-enum { ZIP_NO_COMPRESSION = 0, ZIP_DEFLTATE = 8 };
-typedef uint16_t zip_compression_method_t;
-
-typedef struct
-{
-    uint16_t dummy_bytes; // total struct needs to be a multiple of 4 bytes
-    uint16_t min_version;
-    uint16_t flags;
-    zip_compression_method_t compression_method;
-    uint16_t time_modified;
-    uint16_t date_modified;
-    uint32_t crc;
-    uint32_t compressed_size;
-    uint32_t uncompressed_size;
-    uint16_t filename_length; // OK
-    uint16_t extra_length;
-} zip_file_header_t;
-
 #if defined(ARDUINO_ARCH_ESP32)
 #if HASP_USE_SPIFFS > 0
 #include "SPIFFS.h"
@@ -73,8 +55,13 @@ typedef struct
 #endif // ARDUINO_ARCH
 
 #if defined(ARDUINO_ARCH_ESP32)
+class JsonStreamWriter;
+
 void filesystemUnzip(const char*, const char* filename, uint8_t source);
-String filesystem_list(fs::FS& fs, const char* dirname, uint8_t levels);
+uint32_t filesystem_get_crc(File& file);   // content hash, only read again after the file has changed
+void filesystem_changed(const char* path); // drop the hash of a written file, forget its decoded image
+bool filesystem_replace(fs::FS& fs, const char* temp, const char* path); // atomic on LittleFS
+void filesystem_list(JsonStreamWriter& json, fs::FS& fs, const char* dirname, uint8_t levels);
 void listDir_SD(fs::FS &fs, const char *dirname, uint8_t levels); 
 #endif
 
@@ -10,11 +10,21 @@
 #include "dev/device.h"
 #include "drv/tft/tft_driver.h"
 #include "drv/touch/touch_driver.h"
+#include "drv/gpu/gpu_driver.h"
+#include "drv/gpu/pixel_kernels.h"
+
+#if defined(POSIX) && USE_FBDEV
+#include "dev/posix/hasp_posix_sched.h"
+#endif
 
 #include "hasp_debug.h"
 #include "hasp_gui.h"
 #include "hasp_oobe.h"
 
+#if HASP_USE_REMOTE_VIEW > 0
+#include "sys/svc/hasp_remote_view.h"
+#endif
+
 // #include "tpcal.h"
 
 #define BACKLIGHT_CHANNEL 0 // pwm channel 0-15
@@ -39,6 +49,13 @@ static TaskHandle_t g_lvgl_task_handle;
 #ifndef INVERT_COLORS
 #define INVERT_COLORS 0
 #endif
+#ifndef GUI_REFR_PERIOD_SHORT
+#define GUI_REFR_PERIOD_SHORT 100 // [ms] display refresh period during short idle
+#endif
+#ifndef GUI_REFR_PERIOD_LONG
+#define GUI_REFR_PERIOD_LONG 250 // [ms] display refresh period during long idle
+#endif
+#define GUI_BOOST_TIME 2000 // [ms] run at the active refresh rate after an incoming command
 
 // HASP_ATTRIBUTE_FAST_MEM static void  lv_tick_handler(void);
 
@@ -46,7 +63,8 @@ gui_conf_t gui_settings = {.show_pointer   = false,
                            .backlight_pin  = TFT_BCKL,
                            .rotation       = TFT_ROTATION,
                            .invert_display = INVERT_COLORS,
-                           .cal_data       = {0, 65535, 0, 65535, 0}};
+                           .cal_data       = {0, 65535, 0, 65535, 0},
+                           .refresh_period = {LV_DISP_DEF_REFR_PERIOD, GUI_REFR_PERIOD_SHORT, GUI_REFR_PERIOD_LONG}};
 lv_obj_t* cursor;
 
 uint16_t tft_width  = TFT_WIDTH;
@@ -58,6 +76,22 @@ void (*drv_display_flush_cb)(struct _disp_drv_t* disp_drv, const lv_area_t* area
 
 static lv_disp_buf_t disp_buf;
 
+static uint8_t gui_refresh_level = HASP_SLEEP_LAST; // forces the first update
+static uint32_t gui_loop_delay   = 2;               // [ms]
+static uint32_t gui_boost_start;
+static bool gui_boosted;
+
+/* Measured cost of each refresh level, reported in the info */
+typedef struct
+{
+    uint64_t time;    // [ms] spent at this level
+    uint64_t busy_us; // time spent in lv_task_handler
+    uint32_t loops;   // lv_task_handler calls
+} gui_level_stats_t;
+
+static gui_level_stats_t gui_level_stats[HASP_SLEEP_LAST];
+static uint32_t gui_level_start;
+
 static inline void gui_init_lvgl()
 {
     LOG_VERBOSE(TAG_LVGL, F("Version    : %u.%u.%u %s"), LVGL_VERSION_MAJOR, LVGL_VERSION_MINOR, LVGL_VERSION_PATCH,
@@ -100,14 +134,194 @@ void gui_hide_pointer(bool hidden)
     if(cursor) lv_obj_set_hidden(cursor, hidden || !gui_settings.show_pointer);
 }
 
+/* Slow down the display refresh, input polling and main loop when idle */
+static void gui_apply_refresh_level(uint8_t level)
+{
+    uint32_t now = millis();
+    if(gui_refresh_level < HASP_SLEEP_LAST) gui_level_stats[gui_refresh_level].time += now - gui_level_start;
+    gui_level_start   = now;
+    gui_refresh_level = level;
+
+    uint16_t period = gui_settings.refresh_period[level];
+    if(period < 1) period = LV_DISP_DEF_REFR_PERIOD;
+    uint32_t read_period = LV_INDEV_DEF_READ_PERIOD;
+    if(level != HASP_SLEEP_OFF && period / 2 > read_period) read_period = period / 2;
+
+    lv_disp_t* disp = lv_disp_get_default();
+    if(disp && disp->refr_task) lv_task_set_period(disp->refr_task, period);
+
+    lv_indev_t* indev = NULL;
+    while((indev = lv_indev_get_next(indev))) {
+        if(indev->driver.read_task) lv_task_set_period(indev->driver.read_task, read_period);
+    }
+
+    gui_loop_delay = read_period / 10; // 2 ms when active
+    LOG_VERBOSE(TAG_GUI, F("Refresh    : %u ms, input %u ms"), period, read_period);
+}
+
+/* Called with the new idle level, commands keep the active rate for GUI_BOOST_TIME */
+void gui_set_refresh_level(uint8_t level)
+{
+    if(level >= HASP_SLEEP_LAST) return;
+    if(gui_boosted) {
+        if(millis() - gui_boost_start < GUI_BOOST_TIME)
+            level = HASP_SLEEP_OFF;
+        else
+            gui_boosted = false;
+    }
+    if(level != gui_refresh_level) gui_apply_refresh_level(level);
+}
+
+/* Restore the active rate immediately, e.g. when a command is received while idle */
+void gui_boost_refresh(void)
+{
+    gui_boost_start = millis();
+    gui_boosted     = true;
+    if(gui_refresh_level != HASP_SLEEP_OFF && gui_refresh_level < HASP_SLEEP_LAST)
+        gui_apply_refresh_level(HASP_SLEEP_OFF);
+}
+
+uint32_t gui_get_loop_delay(void)
+{
+    return gui_loop_delay;
+}
+
+/* Run the lvgl tasks and count their cost against the current refresh level */
+static uint32_t gui_task_handler(void)
+{
+    uint32_t start      = micros();
+    uint32_t sleep_time = lv_task_handler();
+
+    if(gui_refresh_level < HASP_SLEEP_LAST) {
+        gui_level_stats[gui_refresh_level].busy_us += micros() - start;
+        gui_level_stats[gui_refresh_level].loops++;
+    }
+    return sleep_time;
+}
+
+void gui_get_info(JsonDocument& doc)
+{
+    static const char* const names[HASP_SLEEP_LAST] = {"Active", "Short Idle", "Long Idle"};
+    char buffer[64];
+
+    JsonObject info = doc.createNestedObject(F("Refresh"));
+    for(uint8_t level = 0; level < HASP_SLEEP_LAST; level++) {
+        gui_level_stats_t& stats = gui_level_stats[level];
+        uint64_t time            = stats.time;
+        if(level == gui_refresh_level) time += millis() - gui_level_start;
+        if(time == 0) continue;
+
+        // cpu load in 0.1 % and lvgl loops per second, measured while at this level
+        uint32_t load  = stats.busy_us / time;
+        uint32_t loops = stats.loops * 1000ULL / time;
+        snprintf_P(buffer, sizeof(buffer), PSTR("%u ms, %u.%u%% cpu, %u loops/s, %us"),
+                   gui_settings.refresh_period[level], load / 10, load % 10, loops, (uint32_t)(time / 1000));
+        info[names[level]] = buffer;
+    }
+}
+
+#if HASP_USE_SHADOW_FB > 0
+/* Copy of the display contents in the coordinates of the flush callback */
+static lv_color_t* gui_shadow_fb;
+static lv_coord_t gui_shadow_width;
+static lv_coord_t gui_shadow_height;
+
+static void gui_init_shadow_fb(lv_disp_t* disp)
+{
+#ifdef ESP32
+    if(!hasp_use_psram()) { // too large for the internal ram
+        LOG_VERBOSE(TAG_LVGL, F("Shadow FB  : " D_SETTING_DISABLED));
+        return;
+    }
+#endif
+
+    // The flushed areas are in display coordinates when lvgl rotates the pixels itself
+    gui_shadow_width  = disp->driver.sw_rotate ? disp->driver.hor_res : lv_disp_get_hor_res(disp);
+    gui_shadow_height = disp->driver.sw_rotate ? disp->driver.ver_res : lv_disp_get_ver_res(disp);
+    gui_shadow_fb     = (lv_color_t*)hasp_calloc(gui_shadow_width * gui_shadow_height, sizeof(lv_color_t));
+
+    if(gui_shadow_fb)
+        LOG_VERBOSE(TAG_LVGL, F("Shadow FB  : %ux%u"), gui_shadow_width, gui_shadow_height);
+    else
+        LOG_ERROR(TAG_LVGL, F(D_ERROR_OUT_OF_MEMORY));
+}
+
+IRAM_ATTR static void gui_shadow_fb_update(const lv_area_t* area, const lv_color_t* color_p)
+{
+    if(!gui_shadow_fb || area->x1 < 0 || area->y1 < 0 || area->x2 >= gui_shadow_width ||
+       area->y2 >= gui_shadow_height)
+        return;
+
+    lv_coord_t width  = lv_area_get_width(area);
+    lv_color_t* dest  = gui_shadow_fb + area->y1 * gui_shadow_width + area->x1;
+    for(lv_coord_t y = area->y1; y <= area->y2; y++, dest += gui_shadow_width, color_p += width)
+        memcpy(dest, color_p, width * sizeof(lv_color_t));
+}
+
+/* The display contents in the same byte order as the draw buffer, or NULL */
+const lv_color_t* gui_shadow_fb_get(lv_coord_t* width, lv_coord_t* height)
+{
+    *width  = gui_shadow_width;
+    *height = gui_shadow_height;
+    return gui_shadow_fb;
+}
+
+/* Wait until lvgl and the display driver are done with the draw buffer */
+static void gui_shadow_fb_flush_wait(lv_disp_drv_t* disp_drv)
+{
+    while(disp_buf.flushing) { // like lv_refr, lv_disp_flush_ready may be called from an interrupt
+        if(disp_drv->wait_cb) disp_drv->wait_cb(disp_drv);
+    }
+#ifdef USE_DMA_TO_TFT
+    haspTft.tft.dmaWait(); // flush_pixels returns while the dma still reads the buffer
+#endif
+}
+
+/* Draw the display contents from the shadow framebuffer, without rendering */
+bool gui_shadow_fb_restore(void)
+{
+    if(!gui_shadow_fb) return false;
+
+    // Bounce through the draw buffer, the display driver may need dma capable memory
+    lv_disp_drv_t* disp_drv = &lv_disp_get_default()->driver;
+    lv_color_t* buf         = (lv_color_t*)disp_buf.buf1;
+    lv_coord_t rows         = disp_buf.size / gui_shadow_width;
+    lv_area_t area          = {0, 0, (lv_coord_t)(gui_shadow_width - 1), 0};
+    if(rows < 1) return false;
+
+    while(area.y1 < gui_shadow_height) {
+        area.y2 = LV_MATH_MIN(area.y1 + rows, gui_shadow_height) - 1;
+        gui_shadow_fb_flush_wait(disp_drv); // the previous band may still be in transfer
+        memcpy(buf, gui_shadow_fb + area.y1 * gui_shadow_width,
+               lv_area_get_size(&area) * sizeof(lv_color_t));
+        haspTft.flush_pixels(disp_drv, &area, buf);
+        area.y1 = area.y2 + 1;
+    }
+    gui_shadow_fb_flush_wait(disp_drv); // lvgl renders into the buffer next
+    return true;
+}
+#endif
+
 IRAM_ATTR void gui_flush_cb(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
 {
     haspTft.flush_pixels(disp, area, color_p);
     screenshotIsDirty = true;
+
+#if HASP_USE_SHADOW_FB > 0
+    gui_shadow_fb_update(area, color_p);
+#endif
+
+#if HASP_USE_REMOTE_VIEW > 0
+    remote_view_flush(disp, area, color_p); // the draw buffer is not reused before we return
+#endif
 }
 
 void gui_antiburn_cb(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
 {
+#if HASP_USE_SHADOW_FB > 0
+    gui_shadow_fb_update(area, color_p); // keep track of changes while the noise is shown
+#endif
+
     /*  uint32_t w   = (area->x2 - area->x1 + 1);
         uint32_t h   = (area->y2 - area->y1 + 1);
         uint32_t len = w * h;
@@ -134,6 +348,26 @@ IRAM_ATTR void gui_monitor_cb(lv_disp_drv_t* disp_drv, uint32_t time, uint32_t p
     screenshotIsDirty = true;
 }
 
+#if LV_USE_GPU
+/* Fill and blend large areas with the 2D accelerator or the vectorized pixel kernels */
+IRAM_ATTR void gui_gpu_fill_cb(lv_disp_drv_t* disp_drv, lv_color_t* dest_buf, lv_coord_t dest_width,
+                               const lv_area_t* fill_area, lv_color_t color)
+{
+    haspGpu.fill(dest_buf, dest_width, fill_area, color);
+}
+
+IRAM_ATTR void gui_gpu_blend_cb(lv_disp_drv_t* disp_drv, lv_color_t* dest, const lv_color_t* src, uint32_t length,
+                                lv_opa_t opa)
+{
+    haspGpu.blend(dest, src, length, opa);
+}
+
+IRAM_ATTR void gui_gpu_wait_cb(lv_disp_drv_t* disp_drv)
+{
+    haspGpu.wait();
+}
+#endif
+
 IRAM_ATTR bool gui_touch_read(lv_indev_drv_t* indev_driver, lv_indev_data_t* data)
 {
     return haspTouch.read(indev_driver, data);
@@ -199,6 +433,18 @@ static inline void gui_init_images()
     lv_split_jpeg_init(); // Initialize JPG decoder
 #endif
 
+#if HASP_USE_IMAGE_STREAM > 0
+    image_stream_init(); // PNG and JPEG files, tried before lv_png and split jpg
+#endif
+
+#if HASP_USE_IMAGE_CACHE > 0
+    image_cache_init(); // Keep decoded images, after the decoders it opens
+#endif
+
+#if HASP_USE_ASSETS > 0
+    asset_init(); // .bin images used in place, tried before the image cache
+#endif
+
 #if defined(ARDUINO_ARCH_ESP32)
     if(hasp_use_psram()) lv_img_cache_set_size(LV_IMG_CACHE_DEF_SIZE_PSRAM);
 #endif
@@ -292,6 +538,18 @@ void guiSetup()
 #endif
     disp_drv.monitor_cb = gui_monitor_cb;
 
+#if HASP_USE_SHADOW_FB > 0
+    gui_init_shadow_fb(display);
+#endif
+
+#if LV_USE_GPU
+    haspGpu.init();
+    display->driver.gpu_fill_cb  = gui_gpu_fill_cb;
+    display->driver.gpu_blend_cb = gui_gpu_blend_cb;
+    display->driver.gpu_wait_cb  = gui_gpu_wait_cb;
+    LOG_VERBOSE(TAG_LVGL, F("Pixel ops  : %s"), haspGpu.get_name());
+#endif
+
     // register a touchscreen/mouse driver - only on real hardware and SDL2
     // Win32 and POSIX handles input drivers in tft_driver
 #if TOUCH_DRIVER != -1 || USE_MONITOR
@@ -374,12 +632,14 @@ void guiSetup()
     }
 #endif // ESP32 && HASP_USE_ESP_MQTT
 
+    gui_set_refresh_level(HASP_SLEEP_OFF);
+
     LOG_INFO(TAG_LVGL, F(D_SERVICE_STARTED));
 }
 
 IRAM_ATTR void guiLoop(void)
 {
-    lv_task_handler(); // process animations
+    gui_task_handler(); // process animations
 
 #if defined(STM32F4xx)
     //  tick.update();
@@ -404,14 +664,17 @@ void gui_task(void* args)
 #if defined(ESP32) && defined(HASP_USE_ESP_MQTT)
         /* Try to take the semaphore, call lvgl related function on success */
         if(pdTRUE == xSemaphoreTake(xGuiSemaphore, portMAX_DELAY)) {
-            lv_task_handler();
+            gui_task_handler();
             xSemaphoreGive(xGuiSemaphore);
             vTaskDelay(pdMS_TO_TICKS(5));
         }
+#elif defined(POSIX) && USE_FBDEV
+        // sleep until the next lv_task, input event or wakeup instead of polling
+        posix_sched_run(gui_task_handler); // counted in the refresh statistics like the other loops
 #else
         // optimize lv_task_handler() by actually using the returned delay value
         auto time_start     = millis();
-        uint32_t sleep_time = lv_task_handler();
+        uint32_t sleep_time = gui_task_handler();
         delay(sleep_time);
         auto time_end = millis();
         lv_tick_inc(time_end - time_start);
@@ -420,6 +683,24 @@ void gui_task(void* args)
 }
 #endif // HASP_USE_LVGL_TASK
 
+/* Wake up the GUI task early, called after another thread has changed lvgl objects */
+void gui_wakeup(void)
+{
+#if HASP_USE_LVGL_TASK == 1 && defined(POSIX) && USE_FBDEV
+    posix_sched_wakeup();
+#endif
+}
+
+/* Milliseconds until the GUI task runs its next lvgl task, the other loops need not sleep longer */
+uint32_t gui_time_till_next(void)
+{
+#if HASP_USE_LVGL_TASK == 1 && defined(POSIX) && USE_FBDEV
+    return posix_sched_time_till_next();
+#else
+    return gui_get_loop_delay();
+#endif
+}
+
 #if defined(ESP32) && defined(HASP_USE_ESP_MQTT)
 
 #if HASP_USE_LVGL_TASK == 1
@@ -494,6 +775,20 @@ bool guiGetConfig(const JsonObject& settings)
     if(gui_settings.invert_display != settings[FPSTR(FP_GUI_INVERT)].as<bool>()) changed = true;
     settings[FPSTR(FP_GUI_INVERT)] = (uint8_t)gui_settings.invert_display;
 
+    /* Check refresh periods array has changed */
+    JsonArray refresh = settings[FPSTR(FP_GUI_REFRESH)].as<JsonArray>();
+    size_t levels     = sizeof(gui_settings.refresh_period) / sizeof(gui_settings.refresh_period[0]);
+    if(refresh.size() != levels) {
+        refresh = settings[FPSTR(FP_GUI_REFRESH)].to<JsonArray>(); // Clear JsonArray
+        for(size_t i = 0; i < levels; i++) refresh.add(gui_settings.refresh_period[i]);
+        changed = true;
+    } else {
+        for(size_t i = 0; i < levels; i++) {
+            if(refresh[i].as<uint16_t>() != gui_settings.refresh_period[i]) changed = true;
+            refresh[i] = gui_settings.refresh_period[i];
+        }
+    }
+
     /* Check CalData array has changed */
     JsonArray array = settings[FPSTR(FP_GUI_CALIBRATION)].as<JsonArray>();
     uint8_t i       = 0;
@@ -577,6 +872,24 @@ bool guiSetConfig(const JsonObject& settings)
         gui_hide_pointer(false);
     }
 
+    if(!settings[FPSTR(FP_GUI_REFRESH)].isNull()) {
+        bool status     = false;
+        size_t i        = 0;
+        size_t levels   = sizeof(gui_settings.refresh_period) / sizeof(gui_settings.refresh_period[0]);
+        JsonArray array = settings[FPSTR(FP_GUI_REFRESH)].as<JsonArray>();
+        for(JsonVariant v : array) {
+            if(i < levels && v.as<uint16_t>() > 0 && gui_settings.refresh_period[i] != v.as<uint16_t>()) {
+                gui_settings.refresh_period[i] = v.as<uint16_t>();
+                status                         = true;
+            }
+            i++;
+        }
+
+        // only apply when lvgl is already running
+        if(status && gui_refresh_level < HASP_SLEEP_LAST) gui_apply_refresh_level(gui_refresh_level);
+        changed |= status;
+    }
+
     if(!settings[FPSTR(FP_GUI_CALIBRATION)].isNull()) {
         bool status = false;
         int i       = 0;
@@ -666,6 +979,54 @@ void gui_flush_not_complete()
 {
     LOG_WARNING(TAG_GUI, F("Pixelbuffer not completely sent"));
 }
+
+/* Write the pixels of a flushed area in the RGB565 bitmap format
+ * When lvgl renders in panel byte order the conversion happens here instead of in the flush path */
+template <typename W> static void gui_screenshot_write(W write, const lv_color_t* color_p, size_t pixels)
+{
+    size_t len = pixels * sizeof(lv_color_t); /* Number of bytes */
+    size_t res = 0;
+
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP != 0
+    uint16_t chunk[256]; // the draw buffer still has to go to the display unchanged
+    while(pixels > 0) {
+        size_t count = pixels < 256 ? pixels : 256;
+        pixel_kernels->swap16(chunk, (const uint16_t*)color_p, count);
+        res += write((uint8_t*)chunk, count * sizeof(lv_color_t));
+        color_p += count;
+        pixels -= count;
+    }
+#else
+    res = write((uint8_t*)color_p, len);
+#endif
+
+    if(res != len) gui_flush_not_complete();
+}
+
+/* The shadow framebuffer when it holds the screen in screen orientation, or NULL */
+static const lv_color_t* gui_screenshot_shadow_fb()
+{
+#if HASP_USE_SHADOW_FB > 0
+    lv_disp_t* disp = lv_disp_get_default();
+    lv_coord_t width, height;
+    if(disp->driver.sw_rotate && disp->driver.rotated != LV_DISP_ROT_NONE) return NULL;
+    return gui_shadow_fb_get(&width, &height);
+#else
+    return NULL;
+#endif
+}
+
+/* Write the screen from the shadow framebuffer, no extra render pass is needed */
+template <typename W> static bool gui_screenshot_from_shadow_fb(W write)
+{
+    const lv_color_t* fb = gui_screenshot_shadow_fb();
+    if(!fb) return false;
+
+    lv_obj_t* scr = lv_disp_get_scr_act(NULL);
+    lv_refr_now(NULL); /* draw the pending changes */
+    gui_screenshot_write(write, fb, lv_obj_get_width(scr) * lv_obj_get_height(scr));
+    return true;
+}
 #endif // HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0 || HASP_USE_HTTP > 0
 
 #if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
@@ -673,9 +1034,7 @@ void gui_flush_not_complete()
 static void gui_screenshot_to_file(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
 {
     size_t len = (area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1); /* Number of pixels */
-    len *= sizeof(lv_color_t);                                          /* Number of bytes */
-    size_t res = pFileOut.write((uint8_t*)color_p, len);
-    if(res != len) gui_flush_not_complete();
+    gui_screenshot_write([](const uint8_t* buf, size_t size) { return pFileOut.write(buf, size); }, color_p, len);
 
     // indirect callback to flush screenshot data to the screen
     drv_display_flush_cb(disp, area, color_p);
@@ -702,14 +1061,17 @@ void guiTakeScreenshot(const char* pFileName)
         if(len == sizeof(buffer)) {
             LOG_VERBOSE(TAG_GUI, F("Bitmap header written"));
 
-            /* Refresh screen to screenshot callback */
-            lv_disp_t* disp       = lv_disp_get_default();
-            drv_display_flush_cb  = disp->driver.flush_cb; /* store callback */
-            disp->driver.flush_cb = gui_screenshot_to_file;
+            if(!gui_screenshot_from_shadow_fb(
+                   [](const uint8_t* buf, size_t size) { return pFileOut.write(buf, size); })) {
+                /* Refresh screen to screenshot callback */
+                lv_disp_t* disp       = lv_disp_get_default();
+                drv_display_flush_cb  = disp->driver.flush_cb; /* store callback */
+                disp->driver.flush_cb = gui_screenshot_to_file;
 
-            lv_obj_invalidate(lv_scr_act());
-            lv_refr_now(NULL);                            /* Will call our disp_drv.disp_flush function */
-            disp->driver.flush_cb = drv_display_flush_cb; /* restore callback */
+                lv_obj_invalidate(lv_scr_act());
+                lv_refr_now(NULL);                            /* Will call our disp_drv.disp_flush function */
+                disp->driver.flush_cb = drv_display_flush_cb; /* restore callback */
+            }
 
             LOG_VERBOSE(TAG_GUI, F("Bitmap data flushed to %s"), pFileName);
 
@@ -725,13 +1087,13 @@ void guiTakeScreenshot(const char* pFileName)
 #endif
 
 #if HASP_USE_HTTP > 0
+static img_encoder_write_t gui_screenshot_http_write;
+
 /* Flush VDB bytes to a webclient */
 static void gui_screenshot_to_http(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
 {
     size_t len = (area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1); /* Number of pixels */
-    len *= sizeof(lv_color_t);                                          /* Number of bytes */
-    size_t res = httpClientWrite((uint8_t*)color_p, len);
-    if(res != len) gui_flush_not_complete();
+    gui_screenshot_write(gui_screenshot_http_write, color_p, len);
 
     lv_disp_flush_ready(disp);
 }
@@ -748,21 +1110,26 @@ static void gui_screenshot_to_both(lv_disp_drv_t* disp, const lv_area_t* area, l
  *
  * Flush buffer into a http client.
  *
+ * @param[in] write    Receives the bitmap, httpClientWrite or a buffer that is sent later.
+ *
  * @note: data pixel should be formatted to uint16_t RGB. Set by Bitmap header.
  *
  **/
-void guiTakeScreenshot()
+void guiTakeScreenshot(img_encoder_write_t write)
 {
     uint8_t buffer[sizeof(bmp_header_t) + 2];
     gui_get_bitmap_header(buffer, sizeof(buffer));
+    gui_screenshot_http_write = write;
 
-    if(httpClientWrite(buffer, sizeof(buffer)) == sizeof(buffer)) {
+    if(write(buffer, sizeof(buffer)) == sizeof(buffer)) {
         LOG_VERBOSE(TAG_GUI, F("Bitmap header sent"));
 
         lv_disp_t* disp      = lv_disp_get_default();
         drv_display_flush_cb = disp->driver.flush_cb; /* store callback */
 
-        if(disp->driver.sw_rotate) {
+        if(gui_screenshot_from_shadow_fb(write)) {
+            LOG_DEBUG(TAG_GUI, F("Bitmap data read from the shadow framebuffer"));
+        } else if(disp->driver.sw_rotate) {
             disp->driver.flush_cb  = gui_screenshot_to_http;
             disp->driver.sw_rotate = 0;
             lv_obj_invalidate(lv_scr_act());
@@ -787,6 +1154,94 @@ void guiTakeScreenshot()
     }
 }
 
+static img_encoder_t* gui_encoder;
+static lv_coord_t gui_encoder_row;
+
+/* Feed flushed bands to the image encoder, they are not drawn on the display */
+static void gui_screenshot_to_encoder(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
+{
+    // The screen is invalidated as a whole, so lvgl renders full width bands from top to bottom
+    if(area->x1 != 0 || area->x2 != gui_encoder->src_width - 1 || area->y1 != gui_encoder_row) {
+        gui_encoder->error = true;
+    } else {
+        img_encoder_push(gui_encoder, (const uint16_t*)color_p, area->y2 - area->y1 + 1);
+        gui_encoder_row = area->y2 + 1;
+    }
+
+    lv_disp_flush_ready(disp);
+}
+
+/* Allocate the encoder of a compressed screenshot, nothing is written yet. NULL when out of memory */
+img_encoder_t* guiScreenshotEncoder(uint8_t format, uint8_t scale)
+{
+    lv_obj_t* scr      = lv_disp_get_scr_act(lv_disp_get_default());
+    img_encoder_t* enc = (img_encoder_t*)hasp_malloc(sizeof(img_encoder_t));
+
+    if(!enc || !img_encoder_init(enc, format, lv_obj_get_width(scr), scale, LV_COLOR_16_SWAP != 0)) {
+        LOG_ERROR(TAG_GUI, F(D_ERROR_OUT_OF_MEMORY));
+        hasp_free(enc);
+        return NULL;
+    }
+    return enc;
+}
+
+/** Take a compressed Screenshot.
+ *
+ * Encode the screen while lvgl renders it band by band, without redrawing the display.
+ *
+ * @param[in] enc      Encoder of guiScreenshotEncoder with the format and scale, freed when done.
+ * @param[in] write    Receives the compressed image in small pieces.
+ *
+ * @return Image size in bytes, or 0 on error.
+ **/
+size_t guiTakeScreenshot(img_encoder_t* enc, img_encoder_write_t write)
+{
+    lv_disp_t* disp   = lv_disp_get_default();
+    lv_obj_t* scr     = lv_disp_get_scr_act(disp);
+    lv_coord_t width  = lv_obj_get_width(scr);
+    lv_coord_t height = lv_obj_get_height(scr);
+    uint32_t start    = millis();
+
+    if(!img_encoder_begin(enc, width, height, write)) {
+        img_encoder_free(enc);
+        hasp_free(enc);
+        return 0;
+    }
+
+    lv_refr_now(NULL); /* draw pending changes first, the display is skipped during the capture */
+
+    if(const lv_color_t* fb = gui_screenshot_shadow_fb()) {
+        img_encoder_push(enc, (const uint16_t*)fb, height);
+    } else {
+        gui_encoder          = enc;
+        gui_encoder_row      = 0;
+        drv_display_flush_cb = disp->driver.flush_cb; /* store callback */
+        uint8_t sw_rotate    = disp->driver.sw_rotate;
+
+        disp->driver.flush_cb  = gui_screenshot_to_encoder;
+        disp->driver.sw_rotate = 0; /* encode in screen orientation */
+        lv_obj_invalidate(scr);
+        lv_refr_now(NULL);                             /* Will call our disp_drv.disp_flush function */
+        disp->driver.flush_cb  = drv_display_flush_cb; /* restore callback */
+        disp->driver.sw_rotate = sw_rotate;
+        gui_encoder            = NULL;
+    }
+
+    size_t size    = img_encoder_end(enc);
+    uint8_t format = enc->format;
+    img_encoder_free(enc);
+    hasp_free(enc);
+
+    if(size) {
+        screenshotIsDirty = false;
+        LOG_VERBOSE(TAG_GUI, F("%s of %u bytes sent in %u ms"), img_encoder_mimetype(format), size,
+                    millis() - start);
+    } else {
+        LOG_ERROR(TAG_GUI, F("Data sent does not match image size"));
+    }
+    return size;
+}
+
 bool guiScreenshotIsDirty()
 {
     return screenshotIsDirty;
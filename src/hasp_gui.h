@@ -5,6 +5,7 @@
 #define HASP_GUI_H
 
 #include "hasplib.h"
+#include "hasp/hasp_img_encoder.h"
 
 struct bmp_header_t
 {
@@ -38,6 +39,7 @@ struct gui_conf_t
 #else
     uint16_t cal_data[8];
 #endif
+    uint16_t refresh_period[3]; // display refresh period in ms when active, short idle and long idle
 };
 
 /* ===== Default Event Processors ===== */
@@ -48,13 +50,23 @@ void guiEverySecond(void);
 void guiStart(void);
 void guiStop(void);
 void gui_hide_pointer(bool hidden);
+void gui_set_refresh_level(uint8_t level);
+void gui_boost_refresh(void);
+uint32_t gui_get_loop_delay(void);
+void gui_get_info(JsonDocument& doc);
 
 /* ===== Special Event Processors ===== */
 void guiCalibrate(void);
-void guiTakeScreenshot(const char* pFileName); // to file
-void guiTakeScreenshot(void);                  // webclient
+void guiTakeScreenshot(const char* pFileName);                                      // to file
+void guiTakeScreenshot(img_encoder_write_t write);                                 // webclient
+img_encoder_t* guiScreenshotEncoder(uint8_t format, uint8_t scale);                 // png or qoi, NULL on OOM
+size_t guiTakeScreenshot(img_encoder_t* enc, img_encoder_write_t write);            // frees the encoder
 bool guiScreenshotIsDirty();
 uint32_t guiScreenshotEtag();
+#if HASP_USE_SHADOW_FB > 0
+const lv_color_t* gui_shadow_fb_get(lv_coord_t* width, lv_coord_t* height);
+bool gui_shadow_fb_restore(void);
+#endif
 
 /* ===== Callbacks ===== */
 void gui_flush_cb(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p);
@@ -64,6 +76,8 @@ void gui_antiburn_cb(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* col
 #if HASP_USE_LVGL_TASK == 1
 void gui_task(void* args);
 #endif
+void gui_wakeup(void);
+uint32_t gui_time_till_next(void);
 
 /* ===== Locks ===== */
 #ifdef ESP32
@@ -0,0 +1,359 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && (HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0)
+
+#include "rom/crc.h"
+
+#include "hasp_debug.h"
+#include "hasp_unzip.h"
+
+#define ZIP_LOCAL_FILE_SIGNATURE 0x04034b50
+#define ZIP_CENTRAL_DIRECTORY_SIGNATURE 0x02014b50
+#define ZIP_END_OF_DIRECTORY_SIGNATURE 0x06054b50
+#define ZIP_DATA_DESCRIPTOR_SIGNATURE 0x08074b50
+
+#define ZIP_FLAG_ENCRYPTED 0x0001
+#define ZIP_FLAG_DATA_DESCRIPTOR 0x0008 // crc and sizes follow the data
+
+#define ZIP_STORED 0
+#define ZIP_DEFLATED 8
+
+#define UNZIP_PATH_SIZE (sizeof(_folder) + sizeof(_name) + 1) // folder, name and ~
+
+static inline uint16_t zip_le16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t zip_le32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+Unzipper::Unzipper(fs::FS& fs, const char* folder)
+    : _state(STATE_SIGNATURE), _fs(fs), _have(0), _need(4), _files(0), _failed(0), _inflator(NULL), _dict(NULL)
+{
+    snprintf_P(_folder, sizeof(_folder), PSTR("%s"), folder && *folder ? folder : "/");
+    size_t len = strlen(_folder);
+    if(_folder[len - 1] != '/' && len < sizeof(_folder) - 1) strcat(_folder, "/");
+}
+
+Unzipper::~Unzipper()
+{
+    if(_file) { // interrupted entry
+        char path[UNZIP_PATH_SIZE];
+        entry_path(path, sizeof(path), true);
+        _file.close();
+        _fs.remove(path);
+    }
+    hasp_free(_inflator);
+    hasp_free(_dict);
+}
+
+/* The name must stay inside the target folder: not absolute and without .. segments */
+static bool zip_name_is_safe(const char* name)
+{
+    if(name[0] == '\0' || name[0] == '/' || name[0] == '\\' || strchr(name, ':')) return false;
+
+    for(const char* segment = name; *segment;) {
+        size_t len = strcspn(segment, "/\\");
+        if(len == 2 && segment[0] == '.' && segment[1] == '.') return false;
+        segment += len;
+        if(*segment) segment++;
+    }
+    return true;
+}
+
+void Unzipper::entry_path(char* path, size_t size, bool temp)
+{
+    snprintf_P(path, size, temp ? PSTR("%s%s~") : PSTR("%s%s"), _folder, _name);
+}
+
+void Unzipper::fail(const char* reason)
+{
+    LOG_ERROR(TAG_FILE, F("Unzip failed: %s"), reason);
+    if(_file) {
+        char path[UNZIP_PATH_SIZE];
+        entry_path(path, sizeof(path), true);
+        _file.close();
+        _fs.remove(path);
+    }
+    _state = STATE_ERROR;
+}
+
+/* Copy up to _need bytes into dest, returns the bytes used */
+size_t Unzipper::collect(uint8_t* dest, const uint8_t* buf, size_t len)
+{
+    size_t used = min(len, _need - _have);
+    if(dest) memcpy(dest + _have, buf, used);
+    _have += used;
+    return used;
+}
+
+void Unzipper::parse_header()
+{
+    _flags     = zip_le16(_hdr + 2);
+    _method    = zip_le16(_hdr + 4);
+    _crc       = zip_le32(_hdr + 10);
+    _remaining = zip_le32(_hdr + 14);
+    _size      = zip_le32(_hdr + 18);
+    _have      = 0;
+    _need      = zip_le16(_hdr + 22); // filename length
+    _state     = STATE_NAME;
+}
+
+/* Open the temporary file of the entry, returns false when the data can not be processed */
+bool Unzipper::open_entry()
+{
+    bool known_size = !(_flags & ZIP_FLAG_DATA_DESCRIPTOR);
+    _crc_calc       = 0;
+    _size_calc      = 0;
+    _entry_ok       = true;
+
+    if(_flags & ZIP_FLAG_ENCRYPTED || (_method != ZIP_STORED && _method != ZIP_DEFLATED)) {
+        LOG_WARNING(TAG_FILE, F("Compression is not supported %d"), _method);
+        if(!known_size) return false; // the end of the data can not be found
+        _failed++;
+        _state = STATE_SKIP;
+        return true;
+    }
+    if(_method == ZIP_STORED && !known_size) return false;
+
+    bool safe = zip_name_is_safe(_name);
+    if(!safe) LOG_WARNING(TAG_FILE, F("Path outside the folder skipped %s"), _name);
+
+    size_t len = strlen(_name);
+    if(len > 0 && _name[len - 1] == '/') { // directory
+        _name[len - 1] = '\0';
+        char path[UNZIP_PATH_SIZE];
+        entry_path(path, sizeof(path), false);
+        if(safe) _fs.mkdir(path);
+        _state = STATE_SKIP;
+        return true;
+    }
+
+    if(_name_too_long) {
+        LOG_WARNING(TAG_FILE, F("filename length too long %s..."), _name);
+        _entry_ok = false; // the data is still read to find the next entry
+    } else if(!safe) {
+        _entry_ok = false;
+    } else {
+        char path[UNZIP_PATH_SIZE];
+        entry_path(path, sizeof(path), true);
+        _file = _fs.open(path, FILE_WRITE);
+        if(!_file) {
+            LOG_ERROR(TAG_FILE, F(D_FILE_SAVE_FAILED), path);
+            _entry_ok = false;
+        }
+    }
+
+    if(_method == ZIP_DEFLATED) {
+        if(!_inflator) _inflator = (tinfl_decompressor*)hasp_malloc(sizeof(tinfl_decompressor));
+        if(!_dict) _dict = (uint8_t*)hasp_malloc(TINFL_LZ_DICT_SIZE);
+        if(!_inflator || !_dict) {
+            LOG_ERROR(TAG_FILE, F(D_ERROR_OUT_OF_MEMORY));
+            return false;
+        }
+        tinfl_init(_inflator);
+        _dict_ofs = 0;
+        _state    = STATE_DEFLATED;
+    } else {
+        _state = STATE_STORED;
+        if(_remaining == 0) finish_entry(); // empty file
+    }
+    return true;
+}
+
+void Unzipper::output(const uint8_t* buf, size_t len)
+{
+    _crc_calc = crc32_le(_crc_calc, buf, len);
+    _size_calc += len;
+    if(_file && _file.write(buf, len) != len) _entry_ok = false;
+}
+
+/* Inflate the compressed data into the dictionary, returns the bytes used */
+size_t Unzipper::inflate(const uint8_t* buf, size_t len)
+{
+    bool known_size = !(_flags & ZIP_FLAG_DATA_DESCRIPTOR);
+    if(known_size && len > _remaining) len = _remaining;
+
+    size_t used = 0;
+    for(;;) {
+        size_t in_bytes  = len - used;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - _dict_ofs;
+        bool more_input  = !known_size || _remaining > in_bytes;
+
+        tinfl_status status = tinfl_decompress(_inflator, buf + used, &in_bytes, _dict, _dict + _dict_ofs, &out_bytes,
+                                               more_input ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+        used += in_bytes;
+        if(known_size) _remaining -= in_bytes;
+        output(_dict + _dict_ofs, out_bytes);
+        _dict_ofs = (_dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if(status == TINFL_STATUS_DONE) {
+            if(known_size && _remaining > 0) { // trailing bytes, read up to the next entry
+                _entry_ok = false;
+                _state    = STATE_STORED;
+            } else if(!known_size) {
+                _have  = 0;
+                _need  = 4;
+                _state = STATE_DESCRIPTOR;
+            } else {
+                finish_entry();
+            }
+            return used;
+        }
+
+        if(status < TINFL_STATUS_DONE) {
+            fail("invalid deflate data");
+            return used;
+        }
+
+        if(status == TINFL_STATUS_NEEDS_MORE_INPUT && used == len) return used;
+    }
+}
+
+/* Verify the entry and replace the file */
+void Unzipper::finish_entry()
+{
+    bool ok = _entry_ok && _crc_calc == _crc && _size_calc == _size;
+
+    if(_file) {
+        char path[UNZIP_PATH_SIZE];
+        entry_path(path, sizeof(path), true);
+        _file.close();
+
+        if(ok) {
+            char target[UNZIP_PATH_SIZE];
+            entry_path(target, sizeof(target), false);
+            ok = filesystem_replace(_fs, path, target);
+            if(&_fs == &HASP_FS) filesystem_changed(target); // the hashes and caches only cover HASP_FS
+        }
+        if(!ok) _fs.remove(path);
+    }
+
+    if(ok) {
+        char size[16];
+        Parser::format_bytes(_size, size, sizeof(size));
+        LOG_VERBOSE(TAG_FILE, F(D_BULLET "%s (%s)"), _name, size);
+        _files++;
+    } else {
+        LOG_ERROR(TAG_FILE, F(D_FILE_SAVE_FAILED), _name);
+        _failed++;
+    }
+
+    _have  = 0;
+    _need  = 4;
+    _state = STATE_SIGNATURE;
+}
+
+bool Unzipper::write(const uint8_t* buf, size_t len)
+{
+    while(len > 0 && _state != STATE_DONE && _state != STATE_ERROR) {
+        size_t used = 0;
+
+        switch(_state) {
+            case STATE_SIGNATURE:
+                used = collect(_hdr, buf, len);
+                if(_have < _need) break;
+
+                switch(zip_le32(_hdr)) {
+                    case ZIP_LOCAL_FILE_SIGNATURE:
+                        _have  = 0;
+                        _need  = sizeof(_hdr);
+                        _state = STATE_HEADER;
+                        break;
+                    case ZIP_CENTRAL_DIRECTORY_SIGNATURE:
+                    case ZIP_END_OF_DIRECTORY_SIGNATURE:
+                        _state = STATE_DONE; // all entries are read
+                        break;
+                    default:
+                        fail("invalid signature");
+                }
+                break;
+
+            case STATE_HEADER:
+                used = collect(_hdr, buf, len);
+                if(_have == _need) parse_header();
+                break;
+
+            case STATE_NAME:
+                if(_have < sizeof(_name) - 1) { // keep the start of a long name for the log
+                    size_t part = min(min(len, _need - _have), sizeof(_name) - 1 - _have);
+                    memcpy(_name + _have, buf, part);
+                }
+                used = collect(NULL, buf, len);
+                if(_have < _need) break;
+
+                _name[min(_need, sizeof(_name) - 1)] = '\0';
+                _name_too_long = _need >= sizeof(_name);
+                _have          = 0;
+                _need          = zip_le16(_hdr + 24); // extra field length
+                _state         = STATE_EXTRA;
+                if(_need > 0) break;
+                // fall through
+
+            case STATE_EXTRA:
+                used += collect(NULL, buf + used, len - used);
+                if(_have < _need) break;
+
+                if(!open_entry()) fail("unsupported entry");
+                break;
+
+            case STATE_STORED:
+                used = min(len, (size_t)_remaining);
+                output(buf, used);
+                _remaining -= used;
+                if(_remaining == 0) finish_entry();
+                break;
+
+            case STATE_DEFLATED:
+                used = inflate(buf, len);
+                break;
+
+            case STATE_SKIP:
+                used = min(len, (size_t)_remaining);
+                _remaining -= used;
+                if(_remaining > 0) break;
+                _have  = 0;
+                _need  = 4;
+                _state = STATE_SIGNATURE;
+                break;
+
+            case STATE_DESCRIPTOR:
+                used = collect(_hdr, buf, len);
+                if(_have == 4 && _need == 4 && zip_le32(_hdr) == ZIP_DATA_DESCRIPTOR_SIGNATURE)
+                    _need = 16;
+                else if(_have == 4 && _need == 4)
+                    _need = 12;
+                if(_have < _need) break;
+
+                _crc  = zip_le32(_hdr + _need - 12);
+                _size = zip_le32(_hdr + _need - 4);
+                finish_entry();
+                break;
+
+            default:;
+        }
+
+        buf += used;
+        len -= used;
+    }
+
+    return _state != STATE_ERROR;
+}
+
+bool Unzipper::end()
+{
+    if(_state == STATE_ERROR) return false;
+    if(_state != STATE_DONE) {
+        fail("archive is incomplete");
+        return false;
+    }
+    return _failed == 0;
+}
+
+#endif
@@ -0,0 +1,91 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_UNZIP_H
+#define HASP_UNZIP_H
+
+#include "hasp_conf.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && (HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0)
+
+#include <FS.h>
+#include "rom/miniz.h"
+
+/* ZIP archive that is extracted while it is received
+ *
+ * The archive is pushed in pieces of any size and read front to back, the central directory is not needed.
+ * Stored and deflated entries are supported, also with a data descriptor after the data.
+ * Each entry is written to "<name>~" and only renamed to its name when the size and CRC32 are correct,
+ * so an interrupted or corrupt archive never leaves a half written file behind.
+ * Entries with an absolute name or a .. segment would land outside the folder and are skipped.
+ * The inflate dictionary of 32 KiB is only allocated for the first deflated entry.
+ */
+class Unzipper {
+
+  public:
+    Unzipper(fs::FS& fs, const char* folder);
+    ~Unzipper();
+
+    bool write(const uint8_t* buf, size_t len); // false after an error
+    bool end();                                 // true if the archive was complete and valid
+
+    uint16_t files()
+    {
+        return _files;
+    }
+    uint16_t failed()
+    {
+        return _failed;
+    }
+
+  private:
+    enum : uint8_t {
+        STATE_SIGNATURE,
+        STATE_HEADER,
+        STATE_NAME,
+        STATE_EXTRA,
+        STATE_STORED,
+        STATE_DEFLATED,
+        STATE_SKIP,
+        STATE_DESCRIPTOR,
+        STATE_DONE,
+        STATE_ERROR
+    } _state;
+
+    fs::FS& _fs;
+    File _file;
+    char _folder[32];
+    char _name[64];
+    uint8_t _hdr[26]; // local file header after the signature
+    size_t _have;     // bytes collected in _hdr or _name
+    size_t _need;
+
+    uint16_t _flags;
+    uint16_t _method;
+    uint32_t _crc;        // expected
+    uint32_t _size;       // expected uncompressed size
+    uint32_t _remaining;  // compressed bytes left
+    uint32_t _crc_calc;
+    uint32_t _size_calc;
+    bool _entry_ok;
+    bool _name_too_long; // only the start of the name is kept
+
+    uint16_t _files;
+    uint16_t _failed;
+
+    tinfl_decompressor* _inflator;
+    uint8_t* _dict;
+    size_t _dict_ofs;
+
+    size_t collect(uint8_t* dest, const uint8_t* buf, size_t len);
+    void parse_header();
+    bool open_entry();
+    void output(const uint8_t* buf, size_t len);
+    size_t inflate(const uint8_t* buf, size_t len);
+    void finish_entry();
+    void entry_path(char* path, size_t size, bool temp);
+    void fail(const char* reason);
+};
+
+#endif
+#endif
@@ -34,6 +34,26 @@
 #include "hasp/hasp_parser.h"
 #include "hasp/hasp_lvfs.h"
 
+#if HASP_USE_IMAGE_CACHE > 0
+#include "hasp/hasp_image_cache.h"
+#endif
+
+#if HASP_USE_IMAGE_STREAM > 0
+#include "hasp/hasp_image_stream.h"
+#endif
+
+#if HASP_USE_IMAGE_FETCH > 0
+#include "hasp/hasp_image_fetch.h"
+#endif
+
+#if HASP_USE_ASSETS > 0
+#include "hasp/hasp_asset.h"
+#endif
+
+#if HASP_USE_FONT_SUBSET > 0
+#include "hasp/hasp_font_subset.h"
+#endif
+
 #include "hasp/lv_theme_hasp.h"
 
 #ifdef ESP32
@@ -22,9 +22,7 @@
 #include "hasp_macro.h"
 #endif
 
-#if HASP_USE_CONFIG > 0
-#include "hasp_gui.h"
-#endif
+#include "hasp_gui.h" // gui_get_loop_delay() is also used without HASP_USE_CONFIG
 
 static bool isConnected;
 static uint8_t mainLoopCounter        = 0;
@@ -265,6 +263,8 @@ IRAM_ATTR void loop()
 #endif
                 break;
         }
+
+        gui_wakeup(); // a GUI task sleeping until its next lvgl task picks up changes made by the timers
     }
 
 #if defined(ESP32) && defined(HASP_USE_ESP_MQTT)
@@ -273,12 +273,18 @@ IRAM_ATTR void loop()
 
 // allow the cpu to switch to other tasks
 #if HASP_USE_LVGL_TASK == 0
-#ifdef ARDUINO_ARCH_ESP8266
-    delay(2); // ms
+    delay(gui_get_loop_delay()); // 2 ms, longer when idle
+#else // HASP_USE_LVGL_TASK != 0
+#if defined(POSIX) && USE_FBDEV
+    // the GUI runs in its own task, sleep until its next lvgl task or the next timer slot
+    unsigned long elapsed = millis() - mainLastLoopTime;
+    if(elapsed < 1000) {
+        uint32_t sleep_time = 1000 - elapsed;
+        uint32_t gui_time   = gui_time_till_next();
+        delay(gui_time < sleep_time ? gui_time : sleep_time);
+    }
 #else
-    delay(2); // ms
+    delay(gui_get_loop_delay()); // 2 ms, longer when idle
 #endif
-#else // HASP_USE_LVGL_TASK != 0
-    delay(2); // ms
 #endif
 }
@@ -48,6 +48,7 @@ const char FP_CONFIG_GROUP[] PROGMEM = "group";
 
 #include "hasp/hasp_dispatch.h" // for dispatch_topic_payload
 #include "hasp_debug.h" // for logging
+#include "hasp_gui.h"   // for gui_wakeup
 
 #if !defined(_WIN32)
 #include <unistd.h>
@@ -221,6 +222,7 @@ static int mqtt_message_arrived(void* context, char* topicName, int topicLen, MQ
     msg[message->payloadlen] = '\0';
 
     mqtt_message_cb(topicName, msg, message->payloadlen);
+    gui_wakeup(); // the GUI task may be sleeping, let it process the changes
 
     MQTTAsync_freeMessage(&message);
     MQTTAsync_free(topicName);
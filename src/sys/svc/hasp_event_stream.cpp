@@ -0,0 +1,327 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if HASP_USE_EVENT_STREAM > 0
+
+#include "hasp_debug.h"
+#include "hasp/hasp_json_writer.h"
+#include "hasp_event_stream.h"
+
+/* Queued message: length as little endian uint16, key length, key, event text
+ * The key is the topic of a value update that may be replaced by a newer one, it is empty for all other messages */
+#define EVENT_STREAM_ENTRY_HEADER 3
+
+typedef struct
+{
+    bool active;
+    char filter[EVENT_STREAM_FILTER_SIZE];
+    uint8_t* buf;
+    size_t len;          // queued bytes
+    size_t sent;         // bytes of the first message that were sent
+    uint32_t last_time;  // last queued message
+    uint32_t dropped;    // messages replaced or discarded
+} event_stream_client_t;
+
+static event_stream_client_t event_stream_clients[EVENT_STREAM_MAX_CLIENTS];
+static uint8_t event_stream_count = 0;
+
+/* Writes the event text into a fixed buffer and remembers when it did not fit
+ * In data mode a line break starts a new data: line, the client joins the lines with \n again */
+class EventStreamPrint : public Print {
+  public:
+    EventStreamPrint(char* buf, size_t size) : _buf(buf), _size(size), _len(0), _overflow(false), _data(false), _prev(0)
+    {}
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t* buf, size_t size) override
+    {
+        if(!_data) return append(buf, size);
+
+        size_t done = 0;
+        for(size_t i = 0; i < size; i++) {
+            uint8_t c = buf[i];
+            bool crlf = c == '\n' && _prev == '\r';
+            _prev     = c;
+            if(c != '\n' && c != '\r') continue;
+
+            append(buf + done, i - done);
+            if(!crlf) append((const uint8_t*)"\ndata: ", 7); // \r, \n and \r\n all end an event stream line
+            done = i + 1;
+        }
+        append(buf + done, size - done);
+        return _overflow ? 0 : size;
+    }
+
+    void data(bool enable)
+    {
+        _data = enable;
+        _prev = 0;
+    }
+
+    size_t length()
+    {
+        return _overflow ? 0 : _len;
+    }
+
+  private:
+    size_t append(const uint8_t* buf, size_t size)
+    {
+        if(_size - _len < size) {
+            _overflow = true;
+            return 0;
+        }
+        memcpy(_buf + _len, buf, size);
+        _len += size;
+        return size;
+    }
+
+    char* _buf;
+    size_t _size;
+    size_t _len;
+    bool _overflow;
+    bool _data;
+    uint8_t _prev;
+};
+
+/* Glob match of one pattern of the filter, it ends at a comma */
+static bool event_stream_match_pattern(const char* pattern, const char* topic)
+{
+    const char* star  = NULL;
+    const char* retry = NULL;
+
+    while(*topic) {
+        if(*pattern == '*') {
+            star  = ++pattern;
+            retry = topic;
+        } else if(*pattern && *pattern != ',' && (*pattern == '?' || *pattern == *topic)) {
+            pattern++;
+            topic++;
+        } else if(star) {
+            pattern = star;
+            topic   = ++retry;
+        } else {
+            return false;
+        }
+    }
+
+    while(*pattern == '*') pattern++;
+    return *pattern == '\0' || *pattern == ',';
+}
+
+static bool event_stream_match(const char* filter, const char* topic)
+{
+    if(*filter == '\0') return true; // no filter
+
+    for(const char* pattern = filter; pattern; pattern = strchr(pattern, ',')) {
+        if(*pattern == ',') pattern++;
+        if(event_stream_match_pattern(pattern, topic)) return true;
+    }
+    return false;
+}
+
+static size_t event_stream_entry_size(const uint8_t* entry)
+{
+    return EVENT_STREAM_ENTRY_HEADER + entry[2] + (entry[0] | (entry[1] << 8));
+}
+
+static void event_stream_remove(event_stream_client_t* client, size_t pos)
+{
+    size_t size = event_stream_entry_size(client->buf + pos);
+    memmove(client->buf + pos, client->buf + pos + size, client->len - pos - size);
+    client->len -= size;
+}
+
+/* First message that can still be dropped, the one being sent is kept */
+static size_t event_stream_first_unsent(event_stream_client_t* client)
+{
+    if(client->len == 0 || client->sent == 0) return 0;
+    return event_stream_entry_size(client->buf);
+}
+
+static void event_stream_queue(event_stream_client_t* client, const char* topic, const char* msg, size_t len)
+{
+    size_t topic_len = strlen(topic);
+    size_t size      = EVENT_STREAM_ENTRY_HEADER + topic_len + len;
+    if(topic_len > 0xFF || size > EVENT_STREAM_BUFSIZE) {
+        client->dropped++;
+        return;
+    }
+
+    // Replace the stale value of the same topic, messages without a key are never replaced
+    if(topic_len > 0) {
+        for(size_t pos = event_stream_first_unsent(client); pos < client->len;
+            pos += event_stream_entry_size(client->buf + pos)) {
+            const uint8_t* entry = client->buf + pos;
+            if(entry[2] == topic_len && !memcmp(entry + EVENT_STREAM_ENTRY_HEADER, topic, topic_len)) {
+                event_stream_remove(client, pos);
+                client->dropped++;
+                break;
+            }
+        }
+    }
+
+    // Make room by dropping the oldest messages
+    while(EVENT_STREAM_BUFSIZE - client->len < size) {
+        size_t pos = event_stream_first_unsent(client);
+        if(pos >= client->len) {
+            client->dropped++; // only the message being sent is left
+            return;
+        }
+        event_stream_remove(client, pos);
+        client->dropped++;
+    }
+
+    uint8_t* entry = client->buf + client->len;
+    entry[0]       = len & 0xFF;
+    entry[1]       = len >> 8;
+    entry[2]       = topic_len;
+    memcpy(entry + EVENT_STREAM_ENTRY_HEADER, topic, topic_len);
+    memcpy(entry + EVENT_STREAM_ENTRY_HEADER + topic_len, msg, len);
+    client->len += size;
+    client->last_time = millis();
+}
+
+int8_t event_stream_open(const char* filter)
+{
+    for(uint8_t id = 0; id < EVENT_STREAM_MAX_CLIENTS; id++) {
+        event_stream_client_t* client = &event_stream_clients[id];
+        if(client->active) continue;
+
+        client->buf = (uint8_t*)hasp_malloc(EVENT_STREAM_BUFSIZE);
+        if(!client->buf) {
+            LOG_ERROR(TAG_HTTP, F(D_ERROR_OUT_OF_MEMORY));
+            return -1;
+        }
+
+        client->active  = true;
+        client->len     = 0;
+        client->sent    = 0;
+        client->dropped = 0;
+        strncpy(client->filter, filter ? filter : "", sizeof(client->filter));
+        client->filter[sizeof(client->filter) - 1] = '\0';
+        event_stream_count++;
+
+        const char retry[] = "retry: 3000\n\n"; // reconnect delay of the browser
+        event_stream_queue(client, "", retry, sizeof(retry) - 1);
+        LOG_VERBOSE(TAG_HTTP, F("Event stream %u opened: %s"), id, client->filter);
+        return id;
+    }
+
+    return -1;
+}
+
+void event_stream_close(uint8_t id)
+{
+    if(!event_stream_is_open(id)) return;
+
+    event_stream_client_t* client = &event_stream_clients[id];
+    hasp_free(client->buf);
+    client->buf    = NULL;
+    client->active = false;
+    event_stream_count--;
+    LOG_VERBOSE(TAG_HTTP, F("Event stream %u closed, %u messages dropped"), id, client->dropped);
+}
+
+/* Keep idle connections alive */
+void event_stream_loop(void)
+{
+    if(event_stream_count == 0) return;
+
+    const char ping[] = ": ping\n\n";
+    for(uint8_t id = 0; id < EVENT_STREAM_MAX_CLIENTS; id++) {
+        event_stream_client_t* client = &event_stream_clients[id];
+        if(client->active && client->len == 0 && millis() - client->last_time >= EVENT_STREAM_PING_INTERVAL)
+            event_stream_queue(client, "", ping, sizeof(ping) - 1);
+    }
+}
+
+void event_stream_send(const char* subtopic, const char* payload)
+{
+    if(event_stream_count == 0) return;
+
+    bool match = false;
+    for(uint8_t id = 0; id < EVENT_STREAM_MAX_CLIENTS; id++) {
+        event_stream_client_t* client = &event_stream_clients[id];
+        if(client->active && event_stream_match(client->filter, subtopic)) match = true;
+    }
+    if(!match) return;
+
+    // Format the event once for all clients
+    char msg[EVENT_STREAM_MESSAGE_SIZE];
+    EventStreamPrint out(msg, sizeof(msg));
+    JsonStreamWriter json(out);
+
+    out.print(F("data: "));
+    out.data(true); // a serialized payload can contain line breaks
+    json.begin_object();
+    json.key(F("topic"));
+    json.value(subtopic);
+    json.key(F("payload"));
+    if(payload[0] == '{' || payload[0] == '[')
+        json.serialized(payload);
+    else
+        json.value(payload);
+    json.end_object();
+    out.data(false);
+    out.print(F("\n\n"));
+
+    size_t len = out.length();
+    if(len == 0) LOG_WARNING(TAG_HTTP, F("Event %s is longer than %u bytes"), subtopic, sizeof(msg));
+
+    // Only value updates are coalesced, every transition like down, up or changed must reach the client
+    const char* key = strncmp_P(payload, PSTR("{\"event\":"), 9) ? subtopic : "";
+
+    for(uint8_t id = 0; id < EVENT_STREAM_MAX_CLIENTS; id++) {
+        event_stream_client_t* client = &event_stream_clients[id];
+        if(!client->active || !event_stream_match(client->filter, subtopic)) continue;
+
+        if(len > 0)
+            event_stream_queue(client, key, msg, len);
+        else
+            client->dropped++;
+    }
+}
+
+bool event_stream_is_open(uint8_t id)
+{
+    return id < EVENT_STREAM_MAX_CLIENTS && event_stream_clients[id].active;
+}
+
+const uint8_t* event_stream_peek(uint8_t id, size_t* len)
+{
+    *len = 0;
+    if(!event_stream_is_open(id)) return NULL;
+
+    event_stream_client_t* client = &event_stream_clients[id];
+    if(client->len == 0) return NULL;
+
+    const uint8_t* entry = client->buf;
+    *len                 = (entry[0] | (entry[1] << 8)) - client->sent;
+    return entry + EVENT_STREAM_ENTRY_HEADER + entry[2] + client->sent;
+}
+
+void event_stream_consume(uint8_t id, size_t len)
+{
+    if(!event_stream_is_open(id) || len == 0) return;
+
+    event_stream_client_t* client = &event_stream_clients[id];
+    if(client->len == 0) return;
+
+    client->sent += len;
+    if(client->sent >= (size_t)(client->buf[0] | (client->buf[1] << 8))) {
+        client->sent = 0;
+        event_stream_remove(client, 0);
+    }
+}
+
+uint32_t event_stream_dropped(uint8_t id)
+{
+    return event_stream_is_open(id) ? event_stream_clients[id].dropped : 0;
+}
+
+#endif
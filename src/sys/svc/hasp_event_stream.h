@@ -0,0 +1,55 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_EVENT_STREAM_H
+#define HASP_EVENT_STREAM_H
+
+#include "hasplib.h"
+
+#if HASP_USE_EVENT_STREAM > 0
+
+/* State messages as server-sent events
+ *
+ * Every message passed to dispatch_state_subtopic is queued for the clients whose filter matches the subtopic:
+ *   data: {"topic":"p1b2","payload":{"event":"up","val":1}}
+ * A JSON payload with line breaks is split over several data: lines, which the client joins again.
+ * The filter is a comma separated list of patterns, * matches any text and ? a single character.
+ * Each client has a bounded queue that is never allowed to block the loop:
+ *  - a new value update replaces a queued value update of the same topic that has not been started yet,
+ *    object events like {"event":"down"} are never replaced
+ *  - when the queue is full, the oldest messages are dropped
+ * A comment is queued when a client was idle for EVENT_STREAM_PING_INTERVAL, to detect closed sockets.
+ */
+
+#ifndef EVENT_STREAM_MAX_CLIENTS
+#define EVENT_STREAM_MAX_CLIENTS 4
+#endif
+#ifndef EVENT_STREAM_BUFSIZE
+#define EVENT_STREAM_BUFSIZE 2048 // queued messages per client
+#endif
+#ifndef EVENT_STREAM_MESSAGE_SIZE
+#define EVENT_STREAM_MESSAGE_SIZE 512 // longest event, larger messages are dropped
+#endif
+#ifndef EVENT_STREAM_FILTER_SIZE
+#define EVENT_STREAM_FILTER_SIZE 64
+#endif
+#ifndef EVENT_STREAM_PING_INTERVAL
+#define EVENT_STREAM_PING_INTERVAL 15000 // [ms]
+#endif
+
+/* ===== Default Event Processors ===== */
+int8_t event_stream_open(const char* filter); // returns the client id or -1
+void event_stream_close(uint8_t id);
+void event_stream_loop(void);
+
+/* ===== Special Event Processors ===== */
+void event_stream_send(const char* subtopic, const char* payload);
+
+/* ===== Getter and Setter Functions ===== */
+bool event_stream_is_open(uint8_t id);
+const uint8_t* event_stream_peek(uint8_t id, size_t* len); // unsent bytes of the first message
+void event_stream_consume(uint8_t id, size_t len);         // bytes that were sent
+uint32_t event_stream_dropped(uint8_t id);
+
+#endif
+#endif
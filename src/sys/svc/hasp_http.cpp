@@ -26,6 +26,17 @@
 
 #include "sys/net/hasp_network.h"
 #include "sys/net/hasp_time.h"
+#include "hasp/hasp_json_writer.h"
+#include "hasp/hasp_command_batch.h"
+#include "StreamUtils.h" // for WriteBufferingPrint
+
+#if HASP_USE_REMOTE_VIEW > 0
+#include "sys/svc/hasp_remote_view.h"
+#endif
+
+#if HASP_USE_EVENT_STREAM > 0
+#include "sys/svc/hasp_event_stream.h"
+#endif
 
 #if(HASP_USE_CAPTIVE_PORTAL > 0) && (HASP_USE_WIFI > 0)
 #include <DNSServer.h>
@@ -49,6 +60,11 @@ IPAddress apIP(192, 168, 4, 1);
 hasp_http_config_t http_config;
 
 #define HTTP_PAGE_SIZE (6 * 256)
+#define HTTP_JSON_CHUNK_SIZE 1024 // bytes per chunk of a streamed JSON response
+#define HTTP_STATIC_MAX_AGE (365 * 24 * 60 * 60) // [s] embedded files are versioned by the commit hash
+#ifndef HTTP_ETAG_CONTENT_HASH
+#define HTTP_ETAG_CONTENT_HASH 1 // ETag of filesystem files from their content instead of the modification time
+#endif
 
 #if(defined(STM32F4xx) || defined(STM32F7xx)) && HASP_USE_ETHERNET > 0
 #include <EthernetWebServer_STM32.h>
@@ -71,7 +87,198 @@ ESP8266WebServer webServer(80);
 #if defined(ARDUINO_ARCH_ESP32)
 #include <WebServer.h>
 #include <detail/mimetable.h>
-WebServer webServer(80);
+
+/* Web server that can hand the socket of a request over to a stream fed from httpLoop */
+class HaspWebServer : public WebServer {
+  public:
+    using WebServer::WebServer;
+
+    // Forget the client of the current request, handleClient() then drops it at once instead of
+    // keeping it in HC_WAIT_CLOSE for HTTP_MAX_CLOSE_WAIT. The socket stays open for the other copies.
+    void releaseClient()
+    {
+        _currentClient = WiFiClient();
+    }
+};
+HaspWebServer webServer(80);
+
+#include <errno.h>
+#include <fcntl.h>
+#include <lwip/sockets.h>
+
+/* WiFiClient::write waits in select() while the send buffer is full, which stalls the loop on a slow client.
+ * Sockets fed from httpLoop are switched to non-blocking mode and written with http_client_write instead. */
+static void http_client_set_nonblocking(WiFiClient& client)
+{
+    int fd = client.fd();
+    if(fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+/* Bytes accepted by a non-blocking socket, 0 when the send buffer is full and -1 when the connection failed */
+static int http_client_write(WiFiClient& client, const uint8_t* data, size_t len)
+{
+    int fd = client.fd();
+    if(fd < 0) return -1;
+
+    int sent = send(fd, data, len, 0);
+    if(sent >= 0) return sent;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+}
+
+/* Large responses are sent from httpLoop, so a download or screenshot does not hold up the loop.
+ * The headers are sent by the webserver and the socket is kept after the request, like the remote view.
+ * The body is read from a file or from a buffer, e.g. a captured screenshot. */
+#define HTTP_STREAM_MAX 2             // concurrent responses, more are sent at once
+#define HTTP_STREAM_SEGMENT 1460      // bytes per write
+#define HTTP_STREAM_BUDGET (2 * 1460) // bytes per response per loop
+#define HTTP_STREAM_TIMEOUT 10000     // [ms] without progress before a response is aborted
+#define HTTP_CAPTURE_RESERVE 8192     // initial buffer of a compressed screenshot, it grows as needed
+
+typedef struct
+{
+    WiFiClient client;
+    File file;
+    uint8_t* data;       // body sent instead of the file, freed when done
+    size_t offset;       // bytes of data that were sent
+    size_t remaining;    // bytes of the body that were not sent yet
+    uint16_t pos;        // bytes of the segment that were sent
+    uint16_t len;        // bytes read from the file into the segment
+    uint32_t last_write; // last progress, to drop stalled clients
+    uint8_t segment[HTTP_STREAM_SEGMENT];
+} http_stream_t;
+
+static http_stream_t httpStreams[HTTP_STREAM_MAX];
+
+static bool http_stream_is_free(const http_stream_t& stream)
+{
+    return !stream.file && !stream.data;
+}
+
+/* Take over the client of the current request, the body is len bytes from the file or data */
+static bool http_stream_start(File* file, uint8_t* data, size_t len)
+{
+    for(auto& stream : httpStreams) {
+        if(!http_stream_is_free(stream)) continue;
+        if(file) stream.file = *file;
+        stream.data       = data;
+        stream.offset     = 0;
+        stream.remaining  = len;
+        stream.pos        = 0;
+        stream.len        = 0;
+        stream.last_write = millis();
+        stream.client     = webServer.client();
+        http_client_set_nonblocking(stream.client);
+        webServer.releaseClient();
+        return true;
+    }
+    return false;
+}
+
+static void http_stream_loop()
+{
+    for(auto& stream : httpStreams) {
+        if(http_stream_is_free(stream)) continue;
+
+        size_t budget = HTTP_STREAM_BUDGET;
+        bool failed   = !stream.client.connected();
+        while(!failed && budget > 0 && stream.remaining > 0) {
+            const uint8_t* data;
+            size_t len;
+            if(stream.data) {
+                data = stream.data + stream.offset;
+                len  = stream.remaining;
+            } else {
+                if(stream.pos == stream.len) { // read the next segment once the previous one is sent
+                    stream.pos = 0;
+                    stream.len = stream.file.read(stream.segment, min(sizeof(stream.segment), stream.remaining));
+                    if(stream.len == 0) {
+                        failed = true;
+                        break;
+                    }
+                }
+                data = stream.segment + stream.pos;
+                len  = stream.len - stream.pos;
+            }
+
+            int sent = http_client_write(stream.client, data, min(len, budget));
+            if(sent <= 0) { // the socket is full, the unsent bytes are kept for the next loop
+                failed = sent < 0;
+                break;
+            }
+            if(stream.data)
+                stream.offset += sent;
+            else
+                stream.pos += sent;
+            stream.remaining -= sent;
+            budget -= sent;
+            stream.last_write = millis();
+        }
+
+        if(!failed && stream.remaining > 0 && millis() - stream.last_write < HTTP_STREAM_TIMEOUT) continue;
+
+        if(stream.remaining > 0)
+            LOG_WARNING(TAG_HTTP, F("Download of %s aborted"), stream.file ? stream.file.name() : "response");
+        stream.file.close();
+        stream.file = File();
+        hasp_free(stream.data);
+        stream.data = NULL;
+        stream.client.stop();
+    }
+}
+
+/* A screenshot is captured in memory and sent from httpLoop, so a slow client does not hold up the render */
+static struct
+{
+    uint8_t* data;
+    size_t size; // allocated bytes
+    size_t len;  // captured bytes
+} httpCapture;
+
+static bool http_capture_begin(size_t size)
+{
+    httpCapture.data = (uint8_t*)hasp_malloc(size);
+    httpCapture.size = httpCapture.data ? size : 0;
+    httpCapture.len  = 0;
+    return httpCapture.data != NULL;
+}
+
+static size_t http_capture_write(const uint8_t* buf, size_t size)
+{
+    if(httpCapture.size - httpCapture.len < size) {
+        size_t grow   = max(httpCapture.size * 2, httpCapture.len + size);
+        uint8_t* data = (uint8_t*)hasp_realloc(httpCapture.data, grow);
+        if(!data) return 0;
+        httpCapture.data = data;
+        httpCapture.size = grow;
+    }
+    memcpy(httpCapture.data + httpCapture.len, buf, size);
+    httpCapture.len += size;
+    return size;
+}
+
+/* Send the captured body with the headers of the current request from httpLoop, or drop it */
+static void http_capture_send(const String& contentType, size_t len)
+{
+    if(len > 0 && len == httpCapture.len) {
+        webServer.setContentLength(len);
+        webServer.send(200, contentType, "");
+        if(http_stream_start(NULL, httpCapture.data, len)) httpCapture.data = NULL;
+    } else {
+        webServer.send_P(503, PSTR("text/plain"), PSTR(D_ERROR_OUT_OF_MEMORY));
+    }
+    hasp_free(httpCapture.data); // only when the stream did not take it over
+    httpCapture.data = NULL;
+}
+
+static bool http_stream_available()
+{
+    for(auto& stream : httpStreams)
+        if(http_stream_is_free(stream)) return true;
+    return false;
+}
+
+#include "rom/crc.h"
+#include "hasp_unzip.h"
 
 #if defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_IDF_TARGET_ESP32S2) || defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
 extern const uint8_t EDIT_HTM_GZ_START[] asm("_binary_data_static_edit_htm_gz_start");
@@ -266,8 +473,13 @@ static void webSendFooter()
 
 static void http_send_cache_header(int size, int age = 3600)
 {
+    String cache((char*)0);
+    cache = F("public, max-age=");
+    cache += age;
+    if(age >= HTTP_STATIC_MAX_AGE) cache += F(", immutable"); // versioned url, don't revalidate on reload
+
     webServer.sendHeader("Content-Length", (String)(size));
-    webServer.sendHeader("Cache-Control", (String)(F("public, max-age=")) + (String)(age));
+    webServer.sendHeader("Cache-Control", cache);
 }
 
 static int http_send_cached(int statuscode, const char* contenttype, const char* data, size_t size, int age = 3600)
@@ -281,19 +493,6 @@ static int http_send_cached(int statuscode, const char* contenttype, const char*
     return statuscode;
 }
 
-static int http_send_static_file(const uint8_t* start, const uint8_t* end, String& contentType)
-{
-    size_t size = end > start ? end - start : 0;
-    int age     = 365 * 24 * 60 * 60;
-    return http_send_cached(200, contentType.c_str(), (const char*)start, size, age);
-}
-
-static int http_send_static_gzip_file(const uint8_t* start, const uint8_t* end, String& contentType)
-{
-    webServer.sendHeader("Content-Encoding", "gzip");
-    return http_send_static_file(start, end, contentType);
-}
-
 static void webSendHtmlHeader(const char* title, uint32_t httpdatalength, uint8_t gohome = 0)
 {
     char buffer[64];
@@ -509,14 +708,50 @@ static void http_handle_screenshot()
             }
         }
 
+        // Send a compressed image or a thumbnail, streamed while the screen is rendered
+        if(webServer.hasArg("q") && (webServer.hasArg("f") || webServer.hasArg("s"))) {
+            uint8_t format = webServer.arg("f") == "qoi" ? IMG_ENCODER_QOI : IMG_ENCODER_PNG;
+            uint8_t scale  = webServer.hasArg("s") ? webServer.arg("s").toInt() : 1;
+            if(scale < 1 || scale > IMG_ENCODER_MAX_SCALE) scale = 1;
+
+            img_encoder_t* enc = guiScreenshotEncoder(format, scale); // before the headers are sent
+            if(!enc) {
+                webServer.send(503, PSTR("text/plain"), PSTR(D_ERROR_OUT_OF_MEMORY));
+                return;
+            }
+
+            etag = (String)(modified);
+            http_send_etag(etag); // Send new tag with modification version
+#if defined(ARDUINO_ARCH_ESP32)
+            if(http_stream_available() && http_capture_begin(HTTP_CAPTURE_RESERVE)) {
+                size_t size = guiTakeScreenshot(enc, http_capture_write);
+                http_capture_send(img_encoder_mimetype(format), size);
+                return;
+            }
+#endif
+            webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+            webServer.send(200, img_encoder_mimetype(format), "");
+            guiTakeScreenshot(enc, httpClientWriteChunk);
+            webServer.sendContent(""); // last chunk
+            return;
+        }
+
         // Send actual bitmap
         if(webServer.hasArg("q")) {
             lv_disp_t* disp = lv_disp_get_default();
+            size_t size     = 66 + disp->driver.hor_res * disp->driver.ver_res * sizeof(lv_color_t);
             etag            = (String)(modified);
             http_send_etag(etag); // Send new tag with modification version
-            webServer.setContentLength(66 + disp->driver.hor_res * disp->driver.ver_res * sizeof(lv_color_t));
+#if defined(ARDUINO_ARCH_ESP32)
+            if(http_stream_available() && http_capture_begin(size)) {
+                guiTakeScreenshot(http_capture_write);
+                http_capture_send(F("image/bmp"), size);
+                return;
+            }
+#endif
+            webServer.setContentLength(size);
             webServer.send(200, "image/bmp", "");
-            guiTakeScreenshot();
+            guiTakeScreenshot(httpClientWrite); // not enough memory to capture it
             webServer.client().stop();
             return;
         }
@@ -530,7 +765,7 @@ static void http_handle_screenshot()
     html[min(i++, len)] = haspDevice.get_hostname();
     html[min(i++, len)] = "</h1><hr>";
     html[min(i++, len)] = R"(
-<p class="c"><img loading="lazy" id="bmp" src="/screenshot?q=0"></p>
+<p class="c"><img loading="lazy" id="bmp" src="/screenshot?q=0&f=png"></p>
 <div class="dist">
 <a href="#" @click.prevent="upd('prev') " v-t="'screenshot.prev'"></a>
 <a href="#" @click.prevent="upd('') " v-t="'screenshot.refresh'"></a>
@@ -541,16 +776,160 @@ static void http_handle_screenshot()
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-static void add_json(String& data, JsonDocument& doc)
+#if HASP_USE_REMOTE_VIEW > 0
+static WiFiClient remoteViewClient;
+
+static void http_handle_remote_view()
+{ // http://plate01/remote
+    if(!http_is_authenticated("remote")) return;
+
+    // Stream the display updates, the socket is kept after the request and fed from httpLoop
+    if(webServer.hasArg("q")) {
+        if(!remote_view_start()) {
+            webServer.send_P(503, PSTR("text/plain"), PSTR(D_ERROR_OUT_OF_MEMORY));
+            return;
+        }
+        remoteViewClient.stop(); // only one viewer
+        remoteViewClient = webServer.client();
+        remoteViewClient.print(F("HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                                 "Cache-Control: no-store\r\nConnection: close\r\n\r\n"));
+        http_client_set_nonblocking(remoteViewClient);
+        webServer.releaseClient();
+        return;
+    }
+
+    const char* html[10];
+    int i   = 0;
+    int len = (sizeof(html) / sizeof(html[0])) - 1;
+
+    html[min(i++, len)] = "<h1>";
+    html[min(i++, len)] = haspDevice.get_hostname();
+    html[min(i++, len)] = "</h1><hr>";
+    html[min(i++, len)] = R"(
+<p class="c"><canvas id="rv" style="max-width:100%"></canvas></p>
+<script>
+(async()=>{const c=document.getElementById("rv"),x=c.getContext("2d"),r=(await fetch("/remote?q=0")).body.getReader();
+let b=new Uint8Array(0);for(;;){const{done:d,value:v}=await r.read();if(d)break;const t=new Uint8Array(b.length+v.length);
+t.set(b);t.set(v,b.length);b=t;while(b.length>=14){const h=new DataView(b.buffer,b.byteOffset),n=h.getUint32(10,true);
+if(b.length<14+n)break;if(b[0]==83){c.width=h.getUint16(6,true);c.height=h.getUint16(8,true)}else{
+x.drawImage(await createImageBitmap(new Blob([b.slice(14,14+n)],{type:"image/png"})),h.getUint16(2,true),h.getUint16(4,true))}
+b=b.slice(14+n)}}})();
+</script>)";
+    html[min(i++, len)] = R"(<a v-t="'home.btn'" href="/"></a>)";
+    http_send_content(html, min(i, len));
+}
+
+/* Send the queued display updates without blocking the loop */
+static void http_remote_view_loop()
 {
-    char buffer[800];
-    size_t len = serializeJson(doc, buffer, sizeof(buffer));
-    if(doc.isNull()) return; // empty document
+    if(!remote_view_is_active()) return;
+
+    if(!remoteViewClient.connected()) {
+        remoteViewClient.stop();
+        remote_view_stop();
+        return;
+    }
 
-    buffer[len - 1] = ',';
-    char* start     = buffer + 1;
-    data += String(start);
-    doc.clear();
+    remote_view_loop();
+
+    size_t len;
+    const uint8_t* data = remote_view_peek(&len);
+    if(len > 1460) len = 1460; // one TCP segment per loop
+    if(len == 0) return;
+
+    int sent = http_client_write(remoteViewClient, data, len); // 0 when the socket is full, retried next loop
+    if(sent < 0) {
+        remoteViewClient.stop();
+        remote_view_stop();
+    } else {
+        remote_view_consume(sent);
+    }
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#if HASP_USE_EVENT_STREAM > 0
+static WiFiClient eventStreamClients[EVENT_STREAM_MAX_CLIENTS];
+
+static void http_handle_events()
+{ // http://plate01/events?topics=p1b*,idle
+    if(!http_is_authenticated("events")) return;
+
+    int8_t id = event_stream_open(webServer.arg(F("topics")).c_str());
+    if(id < 0) {
+        webServer.send_P(503, PSTR("text/plain"), PSTR("Too many event streams"));
+        return;
+    }
+
+    // The socket is kept after the request and fed from httpLoop
+    eventStreamClients[id] = webServer.client();
+    eventStreamClients[id].print(F("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                                   "Cache-Control: no-store\r\nConnection: keep-alive\r\n\r\n"));
+    http_client_set_nonblocking(eventStreamClients[id]);
+    webServer.releaseClient();
+}
+
+/* Send the queued events without blocking the loop */
+static void http_event_stream_loop()
+{
+    event_stream_loop();
+
+    for(uint8_t id = 0; id < EVENT_STREAM_MAX_CLIENTS; id++) {
+        if(!event_stream_is_open(id)) continue;
+
+        if(!eventStreamClients[id].connected()) {
+            eventStreamClients[id].stop();
+            event_stream_close(id);
+            continue;
+        }
+
+        size_t budget = 1460; // one TCP segment per client per loop
+        size_t len;
+        const uint8_t* data;
+        int sent = 0;
+        while(budget > 0 && (data = event_stream_peek(id, &len)) != NULL) {
+            if(len > budget) len = budget;
+            sent = http_client_write(eventStreamClients[id], data, len);
+            if(sent < 0) break;
+            event_stream_consume(id, sent); // the rest of a partial write is sent next loop
+            if((size_t)sent < len) break;   // the socket is full
+            budget -= sent;
+        }
+
+        if(sent < 0) {
+            eventStreamClients[id].stop();
+            event_stream_close(id);
+        }
+    }
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/* Sends each write as one chunk of a response with an unknown length */
+class HttpChunkedPrint : public Print {
+  public:
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t* buf, size_t size) override
+    {
+        return httpClientWriteChunk(buf, size);
+    }
+};
+
+/* Stream a JSON response in buffered chunks, fill() writes the document to the JsonStreamWriter */
+template <typename F> static void http_send_json_stream(const String& contentType, F fill)
+{
+    HttpChunkedPrint chunked;
+    WriteBufferingPrint buffered(chunked, HTTP_JSON_CHUNK_SIZE);
+    JsonStreamWriter json(buffered);
+
+    webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    webServer.send(200, contentType, "");
+    fill(json);
+    buffered.flush();
+    webServer.sendContent(""); // last chunk
 }
 
 static void add_license(JsonObject& obj, const char* title, const char* year, const char* author, const char* license,
@@ -574,32 +953,36 @@ static void webHandleApi()
 
     if(!strcasecmp(endpoint.c_str(), "files")) {
         String path = webServer.arg("dir");
-        webServer.send(200, contentType.c_str(), filesystem_list(HASP_FS, path.c_str(), 5).c_str());
+        http_send_json_stream(contentType,
+                              [&](JsonStreamWriter& json) { filesystem_list(json, HASP_FS, path.c_str(), 5); });
 
     } else if(!strcasecmp(endpoint.c_str(), "info")) {
-        String jsondata((char*)0);
-        jsondata.reserve(HTTP_PAGE_SIZE);
-        jsondata = "{";
+        // Each module fills the document in turn, only one of them is held in memory
+        http_send_json_stream(contentType, [&](JsonStreamWriter& json) {
+            json.begin_object();
 
-        hasp_get_info(doc);
-        add_json(jsondata, doc);
+            hasp_get_info(doc);
+            json.merge(doc.as<JsonObjectConst>());
+            doc.clear();
 
 #if HASP_USE_MQTT > 0
-        mqtt_get_info(doc);
-        add_json(jsondata, doc);
+            mqtt_get_info(doc);
+            json.merge(doc.as<JsonObjectConst>());
+            doc.clear();
 #endif
 
 #if HASP_USE_WIFI > 0 || HASP_USE_EHTERNET > 0
-        network_get_info(doc);
-        add_json(jsondata, doc);
+            network_get_info(doc);
+            json.merge(doc.as<JsonObjectConst>());
+            doc.clear();
 #endif
 
-        haspDevice.get_info(doc);
-        add_json(jsondata, doc);
-
-        jsondata[jsondata.length() - 1] = '}'; // Replace last comma with a bracket
+            haspDevice.get_info(doc);
+            json.merge(doc.as<JsonObjectConst>());
+            doc.clear();
 
-        webServer.send(200, contentType, jsondata);
+            json.end_object();
+        });
         return;
 
     } else if(!strcasecmp(endpoint.c_str(), "credits")) {
@@ -674,81 +1057,44 @@ static void webHandleApi()
             return;
         }
 
-        settings = doc.to<JsonObject>();
-        const __FlashStringHelper* module;
-
-        module = FPSTR(FP_HASP);
-        settings.createNestedObject(module);
-        haspGetConfig(settings[module]);
-
-        module = FPSTR(FP_GUI);
-        settings.createNestedObject(module);
-        guiGetConfig(settings[module]);
-
-        module = FPSTR(FP_DEBUG);
-        settings.createNestedObject(module);
-        debugGetConfig(settings[module]);
-
+        // Each module is serialized on its own, the document only holds one module at a time
+        http_send_json_stream(contentType, [&](JsonStreamWriter& json) {
+            auto add_module = [&](const __FlashStringHelper* module, bool (*get_config)(const JsonObject&)) {
+                settings = doc.to<JsonObject>();
+                get_config(settings);
+                configOutput(settings, TAG_HTTP); // Log current JSON config
+                json.key(module);
+                json.value(doc.as<JsonVariantConst>());
+            };
+
+            json.begin_object();
+            add_module(FPSTR(FP_HASP), haspGetConfig);
+            add_module(FPSTR(FP_GUI), guiGetConfig);
+            add_module(FPSTR(FP_DEBUG), debugGetConfig);
 #if HASP_USE_WIFI > 0
-        module = FPSTR(FP_WIFI);
-        settings.createNestedObject(module);
-        wifiGetConfig(settings[module]);
-
-        module = FPSTR(FP_TIME);
-        settings.createNestedObject(module);
-        timeGetConfig(settings[module]);
+            add_module(FPSTR(FP_WIFI), wifiGetConfig);
+            add_module(FPSTR(FP_TIME), timeGetConfig);
 #endif
 #if HASP_USE_WIREGUARD > 0
-        module = FPSTR(FP_WG);
-        settings.createNestedObject(module);
-        wgGetConfig(settings[module]);
+            add_module(FPSTR(FP_WG), wgGetConfig);
 #endif
 #if HASP_USE_MQTT > 0
-        module = FPSTR(FP_MQTT);
-        settings.createNestedObject(module);
-        mqttGetConfig(settings[module]);
+            add_module(FPSTR(FP_MQTT), mqttGetConfig);
 #endif
 #if HASP_USE_FTP > 0
-        module = FPSTR(FP_FTP);
-        settings.createNestedObject(module);
-        ftpGetConfig(settings[module]);
+            add_module(FPSTR(FP_FTP), ftpGetConfig);
 #endif
 #if HASP_USE_HTTP > 0
-        module = FPSTR(FP_HTTP);
-        settings.createNestedObject(module);
-        httpGetConfig(settings[module]);
+            add_module(FPSTR(FP_HTTP), httpGetConfig);
 #endif
 #if HASP_USE_ARDUINOOTA > 0 || HASP_USE_HTTP_UPDATE > 0
-        module = FPSTR(FP_OTA);
-        settings.createNestedObject(module);
-        otaGetConfig(settings[module]);
+            add_module(FPSTR(FP_OTA), otaGetConfig);
 #endif
 #if HASP_USE_GPIO > 0
-        module = FPSTR(FP_GPIO);
-        settings.createNestedObject(module);
-        gpioGetConfig(settings[module]);
-#endif
-        configOutput(settings, TAG_HTTP); // Log current JSON config
-
-        LOG_DEBUG(TAG_HTTP, "%s - %d", __FILE__, __LINE__);
-        // Mask non-blank passwords
-        // if(!settings[FPSTR(FP_CONFIG_PASS)].isNull() && settings[FPSTR(FP_CONFIG_PASS)].as<String>().length() != 0) {
-        //     settings[FPSTR(FP_CONFIG_PASS)] = D_PASSWORD_MASK;
-        // }
-
-        LOG_DEBUG(TAG_HTTP, "%s - %d", __FILE__, __LINE__);
-        doc.shrinkToFit();
-        LOG_DEBUG(TAG_HTTP, "%s - %d", __FILE__, __LINE__);
-        const size_t size = measureJson(doc) + 1;
-        LOG_DEBUG(TAG_HTTP, "%s - %d", __FILE__, __LINE__);
-        char jsondata[size];
-        LOG_DEBUG(TAG_HTTP, "%s - %d", __FILE__, __LINE__);
-        memset(jsondata, 0, size);
-        LOG_DEBUG(TAG_HTTP, "%s - %d", __FILE__, __LINE__);
-        serializeJson(doc, jsondata, size);
-        LOG_DEBUG(TAG_HTTP, "%s - %d", __FILE__, __LINE__);
-        webServer.send(200, contentType, jsondata);
-        LOG_DEBUG(TAG_HTTP, "%s - %d", __FILE__, __LINE__);
+            add_module(FPSTR(FP_GPIO), gpioGetConfig);
+#endif
+            json.end_object();
+        });
 
     } else {
         webServer.send(400, contentType, "Bad Request");
@@ -1107,6 +1453,72 @@ static void webHandleFirmwareUpload()
 }
 #endif
 
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+/* Send the headers like streamFile and len bytes from the file position, from httpLoop when possible.
+ * A HEAD request only gets the headers. The file is closed when done. */
+static void http_stream_file(File& file, const String& contentType, int code, size_t len)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    String name((char*)0);
+    name = file.name();
+    if(name.endsWith(F(".gz")) && contentType != F("application/x-gzip") &&
+       contentType != F("application/octet-stream"))
+        webServer.sendHeader(F("Content-Encoding"), F("gzip"));
+
+    webServer.setContentLength(len);
+    webServer.send(code, contentType, "");
+    if(webServer.method() != HTTP_HEAD && (len <= HTTP_STREAM_BUDGET || !http_stream_start(&file, NULL, len))) {
+        uint8_t buffer[512];
+        size_t read;
+        while(len > 0 && (read = file.read(buffer, min(sizeof(buffer), len))) > 0) {
+            if(webServer.client().write(buffer, read) != read) break;
+            len -= read;
+        }
+    } else if(webServer.method() != HTTP_HEAD) {
+        return; // sent from httpLoop
+    }
+#else
+    webServer.streamFile(file, contentType);
+#endif
+    file.close();
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+/* Single byte range of a file, returns 206 for a valid range, 416 if it is outside the file
+ * and 200 to ignore it and send the whole file */
+static int http_parse_range(const String& range, size_t size, size_t& start, size_t& len)
+{
+    if(!range.startsWith(F("bytes=")) || range.indexOf(',') >= 0) return 200; // multiple ranges are not supported
+
+    const char* spec = range.c_str() + 6;
+    char* end;
+    size_t first;
+    size_t last = size - 1;
+
+    if(*spec == '-') { // the last bytes
+        size_t suffix = strtoul(spec + 1, &end, 10);
+        if(end == spec + 1 || *end) return 200;
+        if(suffix == 0) return 416;
+        first = suffix < size ? size - suffix : 0;
+    } else {
+        first = strtoul(spec, &end, 10);
+        if(end == spec || *end != '-') return 200;
+        if(end[1]) {
+            spec = end + 1;
+            last = strtoul(spec, &end, 10);
+            if(end == spec || *end || last < first) return 200;
+            if(last >= size) last = size - 1;
+        }
+    }
+
+    if(size == 0 || first >= size) return 416;
+    start = first;
+    len   = last - first + 1;
+    return 206;
+}
+#endif
+#endif
+
 static inline int handleFilesystemFile(String path)
 {
     if(!http_is_authenticated()) return false;
@@ -1148,25 +1560,33 @@ static inline int handleFilesystemFile(String path)
             webServer.send(200, contentType, buffer);
 
         } else {
-            File file       = HASP_FS.open(path, "r");
-            time_t modified = file.getLastWrite();
+            File file   = HASP_FS.open(path, "r");
+            size_t size = file.size();
             String etag((char*)0);
             etag.reserve(64);
 
+#if defined(ARDUINO_ARCH_ESP32) && HTTP_ETAG_CONTENT_HASH > 0
+            char hash[12];
+            snprintf_P(hash, sizeof(hash), PSTR("%08x"), filesystem_get_crc(file)); // also valid without NTP
+            etag = hash;
+#else
+            time_t modified = file.getLastWrite();
+            if(modified > 0) etag = (String)(modified);
+#endif
+
             if(webServer.hasHeader("If-None-Match")) {
-                etag = webServer.header("If-None-Match");
-                etag.replace("\"", "");
-                LOG_DEBUG(TAG_HTTP, F("If-None-Match: %s"), etag.c_str());
-                if(modified > 0 && modified == atol(etag.c_str())) { // Not Changed
-                    file.close();                                    // Skip reading the file contents
-                    http_send_etag(etag);                            // Reuse same ETag
-                    webServer.send(304, contentType, "");            // Use correct mimetype
-                    return 304;                                      // Not Modified
+                String match = webServer.header("If-None-Match");
+                match.replace("\"", "");
+                LOG_DEBUG(TAG_HTTP, F("If-None-Match: %s"), match.c_str());
+                if(etag.length() > 0 && match == etag) { // Not Changed
+                    file.close();                         // Skip reading the file contents
+                    http_send_etag(etag);                 // Reuse same ETag
+                    webServer.send(304, contentType, ""); // Use correct mimetype
+                    return 304;                           // Not Modified
                 }
             }
 
-            etag = (String)(modified);
-            http_send_etag(etag); // Send new tag with modification datetime
+            http_send_etag(etag); // Send new tag with content hash or modification datetime
 
             /* Only needed for brotli encoding. Gzip is handled automatically in streamfile() */
             /* Brotli is not supported over HTTP/1.1 */
@@ -1177,10 +1597,34 @@ static inline int handleFilesystemFile(String path)
 
             // } else {
             // Stream other files directly from filesystem
-            webServer.streamFile(file, contentType);
+            int code   = 200;
+            size_t len = size;
+#if defined(ARDUINO_ARCH_ESP32)
+            size_t start = 0;
+            webServer.sendHeader(F("Accept-Ranges"), F("bytes"));
+
+            // A Range only applies to the version in If-Range
+            if(webServer.hasHeader("Range") &&
+               (!webServer.hasHeader("If-Range") || webServer.header("If-Range").indexOf(etag) >= 0))
+                code = http_parse_range(webServer.header("Range"), size, start, len);
+
+            if(code == 416) {
+                file.close();
+                webServer.sendHeader(F("Content-Range"), String(F("bytes */")) + size);
+                webServer.send(416, PSTR("text/plain"), "");
+                return 416;
+            }
+            if(code == 206) {
+                char range[48];
+                snprintf_P(range, sizeof(range), PSTR("bytes %u-%u/%u"), start, start + len - 1, size);
+                webServer.sendHeader(F("Content-Range"), range);
+                file.seek(start);
+            }
+#endif
+            http_stream_file(file, contentType, code, len);
             LOG_DEBUG(TAG_HTTP, F("If-None-Match: %s"), etag.c_str());
             //}
-            file.close();
+            return code;
         }
 
         return 200; // OK
@@ -1250,6 +1694,9 @@ static void handleFileUpload()
         case UPLOAD_FILE_END: {
             if(fsUploadFile) {
                 LOG_INFO(TAG_HTTP, F("Uploaded %s (%u bytes)"), fsUploadFile.name(), upload->totalSize);
+#if defined(ARDUINO_ARCH_ESP32)
+                filesystem_changed(fsUploadFile.path());
+#endif
                 fsUploadFile.close();
 
                 // Redirect to /config/hasp page. This flushes the web buffer and frees the memory
@@ -1293,6 +1740,9 @@ static void handleFileDelete()
         result = HASP_FS.rmdir(path);
     } else {
         result = HASP_FS.remove(path);
+#if defined(ARDUINO_ARCH_ESP32)
+        filesystem_changed(path.c_str());
+#endif
     }
     if(result) {
         webServer.send(200, mimetype, String(""));
@@ -1342,6 +1792,282 @@ static void handleFileCreate()
     webServer.send(200, PSTR("text/plain"), "");
 }
 
+#if defined(ARDUINO_ARCH_ESP32)
+static CommandBatch* commandBatch = NULL;
+
+/* The commands of POST /api/command/ are applied while the body is received. The web server runs in the main
+ * loop, which holds the gui lock, so the screen is not rendered until the whole batch has been applied. */
+static void http_handle_command_raw()
+{
+    HTTPRaw& raw = webServer.raw();
+
+    switch(raw.status) {
+        case RAW_START:
+            delete commandBatch;
+            commandBatch = NULL;
+            if(http_config.password[0] != '\0' && !webServer.authenticate(http_config.username, http_config.password))
+                return; // the reply requests authentication
+            commandBatch = new CommandBatch(TAG_HTTP);
+            break;
+
+        case RAW_WRITE:
+            if(commandBatch) commandBatch->write(raw.buf, raw.currentSize);
+            break;
+
+        case RAW_END:
+            if(commandBatch) commandBatch->end();
+            break;
+
+        default:
+            LOG_WARNING(TAG_HTTP, F("Command batch aborted"));
+            delete commandBatch;
+            commandBatch = NULL;
+    }
+}
+
+static void http_handle_command()
+{
+    if(!http_is_authenticated("command")) {
+        delete commandBatch;
+        commandBatch = NULL;
+        return;
+    }
+
+    if(!commandBatch) { // no body received
+        webServer.send(400, PSTR("text/plain"), "Bad Request");
+        return;
+    }
+
+    LOG_VERBOSE(TAG_HTTP, F("Applied %u commands in %u us, %u failed"), commandBatch->count(),
+                commandBatch->duration(), commandBatch->failed());
+
+    http_send_json_stream(http_get_content_type(F(".json")), [](JsonStreamWriter& json) {
+        json.begin_object();
+        json.key("count");
+        json.number(commandBatch->count());
+        json.key("failed");
+        json.number(commandBatch->failed());
+        json.key("duration");
+        json.number(commandBatch->duration());
+
+        json.key("slowest");
+        json.begin_object();
+        json.key("line");
+        json.number(commandBatch->slowest_line());
+        json.key("duration");
+        json.number(commandBatch->slowest_duration());
+        json.end_object();
+
+        json.key("errors"); // line numbers of the first failed commands
+        json.begin_array();
+        for(uint16_t i = 0; i < commandBatch->failed() && i < COMMAND_BATCH_MAX_ERRORS; i++)
+            json.number(commandBatch->error_line(i));
+        json.end_array();
+        json.end_object();
+    });
+
+    delete commandBatch;
+    commandBatch = NULL;
+}
+
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+/* Upload in parts that can be resumed after a dropped connection
+ *   POST /api/upload/?path=/pages.jsonl&offset=0&size=12345 with the bytes of the part as body
+ *   GET  /api/upload/?path=/pages.jsonl returns the number of bytes received, to continue from
+ * The offset and size can also be given as a "Content-Range: bytes 0-4095/12345" header.
+ * A file is written to "<path>~" and renamed when all bytes are received, the temporary file survives a reboot.
+ * With unzip the archive is extracted into the folder of path while it is received, only kept in memory.
+ * With update=flash or update=spiffs the parts are a firmware or filesystem image, written to the update partition.
+ * An update can be resumed until a reboot, it is applied when all bytes are received and the device restarts.
+ */
+static struct
+{
+    char path[64];
+    size_t received;
+    size_t size; // 0 if unknown, the upload ends with the first part
+    int status;  // reply of the current part
+    int update;  // U_FLASH or U_SPIFFS for a firmware update, -1 for a file
+    File file;
+    Unzipper* unzip;
+} httpUpload = {"", 0, 0, 0, -1};
+
+static void http_upload_reset()
+{
+    if(httpUpload.file) httpUpload.file.close();
+    if(httpUpload.update >= 0 && Update.isRunning()) Update.abort();
+    httpUpload.update = -1;
+    delete httpUpload.unzip;
+    httpUpload.unzip    = NULL;
+    httpUpload.path[0]  = '\0';
+    httpUpload.received = 0;
+    httpUpload.size     = 0;
+}
+
+static void http_upload_temp_path(const char* path, char* temp, size_t size)
+{
+    snprintf_P(temp, size, PSTR("%s~"), path);
+}
+
+/* Check the part and continue the current upload, or the temporary file of an earlier one */
+static int http_upload_start()
+{
+    String path   = webServer.arg("path");
+    size_t offset = webServer.arg("offset").toInt();
+    size_t size   = webServer.arg("size").toInt();
+    bool unzip    = webServer.hasArg("unzip");
+    int update    = webServer.arg("update") == "flash" ? U_FLASH : webServer.arg("update") == "spiffs" ? U_SPIFFS : -1;
+    char temp[sizeof(httpUpload.path) + 1];
+
+    if(webServer.hasHeader("Content-Range")) {
+        unsigned int start, total;
+        if(sscanf(webServer.header("Content-Range").c_str(), "bytes %u-%*u/%u", &start, &total) == 2) {
+            offset = start;
+            size   = total;
+        }
+    }
+    if(update >= 0) path = update == U_FLASH ? F("/update/flash") : F("/update/spiffs"); // for the GET request
+    if(!path.startsWith("/") || path.length() >= sizeof(httpUpload.path)) return 400;
+
+    if(offset == 0 || path != httpUpload.path || unzip != (httpUpload.unzip != NULL) || update != httpUpload.update) {
+        http_upload_reset();
+        strncpy(httpUpload.path, path.c_str(), sizeof(httpUpload.path));
+        http_upload_temp_path(httpUpload.path, temp, sizeof(temp));
+
+        if(offset == 0) {
+            if(unzip) {
+                String folder = path.substring(0, path.lastIndexOf('/') + 1);
+                httpUpload.unzip = new Unzipper(HASP_FS, folder.c_str());
+            } else if(update >= 0) {
+                size_t max = update == U_FLASH ? (ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000 : UPDATE_SIZE_UNKNOWN;
+                if(!Update.begin(max, update, -1, 0U)) {
+                    LOG_ERROR(TAG_HTTP, F("Update begin failed: %s"), Update.errorString());
+                    return 500;
+                }
+                httpUpload.update = update;
+            }
+        } else if(!unzip && update < 0) { // resume from the temporary file
+            File file = HASP_FS.open(temp, "r");
+            if(file) httpUpload.received = file.size();
+            file.close();
+        }
+    }
+    if(size > 0) httpUpload.size = size;
+    if(offset != httpUpload.received) return 416; // the reply has the offset to continue from
+
+    if(!httpUpload.unzip && httpUpload.update < 0 && !httpUpload.file) {
+        http_upload_temp_path(httpUpload.path, temp, sizeof(temp));
+        httpUpload.file = HASP_FS.open(temp, offset == 0 ? "w" : "a");
+        if(!httpUpload.file) return 500;
+    }
+
+    haspProgressMsg(httpUpload.path);
+    return 200;
+}
+
+static void http_handle_upload_raw()
+{
+    HTTPRaw& raw = webServer.raw();
+
+    switch(raw.status) {
+        case RAW_START:
+            httpUpload.status = 401;
+            if(http_config.password[0] != '\0' && !webServer.authenticate(http_config.username, http_config.password))
+                return; // the reply requests authentication
+            httpUpload.status = http_upload_start();
+            break;
+
+        case RAW_WRITE:
+            if(httpUpload.status != 200) return;
+            if(httpUpload.unzip) {
+                if(!httpUpload.unzip->write(raw.buf, raw.currentSize)) httpUpload.status = 422;
+            } else if(httpUpload.update >= 0) {
+                if(Update.write(raw.buf, raw.currentSize) != raw.currentSize) httpUpload.status = 500;
+            } else if(httpUpload.file.write(raw.buf, raw.currentSize) != raw.currentSize) {
+                httpUpload.status = 500;
+            }
+            if(httpUpload.status == 200) httpUpload.received += raw.currentSize;
+            if(httpUpload.size > 0) haspProgressVal(httpUpload.received * 100 / httpUpload.size);
+            break;
+
+        case RAW_END:
+            break;
+
+        default: // keep what was received, the client can continue from there
+            LOG_WARNING(TAG_HTTP, F("Upload of %s interrupted at %u bytes"), httpUpload.path, httpUpload.received);
+            if(httpUpload.file) httpUpload.file.close();
+            haspProgressVal(255);
+    }
+}
+
+static void http_handle_upload()
+{
+    if(!http_is_authenticated("upload")) return;
+
+    StaticJsonDocument<256> doc;
+    int status  = 200;
+    bool reboot = false;
+
+    if(webServer.method() == HTTP_GET) {
+        String path = webServer.arg("path");
+        doc["path"] = path;
+        if(path == httpUpload.path) {
+            doc["received"] = httpUpload.received;
+        } else {
+            char temp[sizeof(httpUpload.path) + 1];
+            http_upload_temp_path(path.c_str(), temp, sizeof(temp));
+            File file       = HASP_FS.open(temp, "r");
+            doc["received"] = file ? file.size() : 0;
+            file.close();
+        }
+
+    } else {
+        status            = httpUpload.status;
+        httpUpload.status = 0;
+        if(status == 0) status = 400; // no body received
+
+        bool complete   = status == 200 && (httpUpload.size == 0 || httpUpload.received >= httpUpload.size);
+        doc["path"]     = httpUpload.path;
+        doc["received"] = httpUpload.received;
+        doc["size"]     = httpUpload.size;
+
+        if(complete && httpUpload.unzip) {
+            if(!httpUpload.unzip->end()) status = 422;
+            doc["files"]  = httpUpload.unzip->files();
+            doc["failed"] = httpUpload.unzip->failed();
+        } else if(complete && httpUpload.update >= 0) {
+            if(Update.end(true)) { // true to set the size to the current progress
+                haspProgressMsg(D_OTA_UPDATE_APPLY);
+                reboot = true;
+            } else {
+                LOG_ERROR(TAG_HTTP, F("Update failed: %s"), Update.errorString());
+                status = 422;
+            }
+        } else if(complete) {
+            char temp[sizeof(httpUpload.path) + 1];
+            http_upload_temp_path(httpUpload.path, temp, sizeof(temp));
+            httpUpload.file.close();
+            if(!filesystem_replace(HASP_FS, temp, httpUpload.path)) status = 500;
+            filesystem_changed(httpUpload.path);
+        }
+        doc["complete"] = complete && status == 200;
+
+        if(complete) {
+            LOG_INFO(TAG_HTTP, F("Uploaded %s (%u bytes)"), httpUpload.path, httpUpload.received);
+            http_upload_reset();
+            haspProgressVal(255);
+        } else if(status == 422 || status == 500) {
+            http_upload_reset(); // the upload can not continue
+        }
+    }
+
+    char buffer[256];
+    serializeJson(doc, buffer, sizeof(buffer));
+    webServer.send(status, http_get_content_type(F(".json")), buffer);
+    if(reboot) dispatch_reboot(true); // Save the current config
+}
+#endif
+#endif
+
 static void handleFileList()
 {
     if(!http_is_authenticated("filelist")) return;
@@ -1355,59 +2081,39 @@ static void handleFileList()
     // LOG_TRACE(TAG_HTTP, F("handleFileList: %s"), path.c_str());
     // path.clear();
 
+    http_send_json_stream(F("text/json"), [&](JsonStreamWriter& json) {
+        json.begin_array();
 #if defined(ARDUINO_ARCH_ESP32)
-    File root = HASP_FS.open(path.c_str(), FILE_READ);
-    File file = root.openNextFile();
-    String output((char*)0);
-    output.reserve(HTTP_PAGE_SIZE);
-    output = "[";
+        File root = HASP_FS.open(path.c_str(), FILE_READ);
+        File file = root.openNextFile();
 
-    while(file) {
-        if(output != "[") {
-            output += ',';
-        }
-        bool isDir = file.isDirectory();
-        output += F("{\"type\":\"");
-        output += (isDir) ? "dir" : "file";
-        output += F("\",\"name\":\"");
-        if(file.name()[0] == '/') {
-            output += &(file.name()[1]);
-        } else {
-            output += file.name();
+        while(file) {
+            json.begin_object();
+            json.key("type");
+            json.value(file.isDirectory() ? "dir" : "file");
+            json.key("name");
+            json.value(file.name()[0] == '/' ? &(file.name()[1]) : file.name());
+            json.end_object();
+
+            // file.close();
+            file = root.openNextFile();
         }
-        output += F("\"}");
-
-        // file.close();
-        file = root.openNextFile();
-    }
-    output += "]";
-    webServer.send(200, PSTR("text/json"), output);
 #elif defined(ARDUINO_ARCH_ESP8266)
-    Dir dir = HASP_FS.openDir(path);
-    String output((char*)0);
-    output.reserve(HTTP_PAGE_SIZE);
-    output = "[";
-
-    while(dir.next()) {
-        File entry = dir.openFile("r");
-        if(output != "[") {
-            output += ',';
-        }
-        bool isDir = false;
-        output += F("{\"type\":\"");
-        output += (isDir) ? "dir" : "file";
-        output += F("\",\"name\":\"");
-        if(entry.name()[0] == '/') {
-            output += &(entry.name()[1]);
-        } else {
-            output += entry.name();
+        Dir dir = HASP_FS.openDir(path);
+
+        while(dir.next()) {
+            File entry = dir.openFile("r");
+            json.begin_object();
+            json.key("type");
+            json.value("file");
+            json.key("name");
+            json.value(entry.name()[0] == '/' ? &(entry.name()[1]) : entry.name());
+            json.end_object();
+            entry.close();
         }
-        output += F("\"}");
-        entry.close();
-    }
-    output += "]";
-    webServer.send(200, PSTR("text/json"), output);
 #endif
+        json.end_array();
+    });
 }
 #endif
 
@@ -2376,42 +3082,109 @@ static void http_handle_wireguard()
 
 #endif // HASP_USE_WIREGUARD
 
-static inline int handleFirmwareFile(String path)
+#if defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_IDF_TARGET_ESP32S2) || defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
+/* Content hashes of the embedded files are passed by tools/auto_firmware_version.py, 0 = calculate on first use */
+#ifndef HTTP_ETAG_EDIT_HTM
+#define HTTP_ETAG_EDIT_HTM 0
+#endif
+#ifndef HTTP_ETAG_LOGO_SVG
+#define HTTP_ETAG_LOGO_SVG 0
+#endif
+#ifndef HTTP_ETAG_STYLE_CSS
+#define HTTP_ETAG_STYLE_CSS 0
+#endif
+#ifndef HTTP_ETAG_SCRIPT_JS
+#define HTTP_ETAG_SCRIPT_JS 0
+#endif
+#ifndef HTTP_ETAG_EN_JSON
+#define HTTP_ETAG_EN_JSON 0
+#endif
+#ifndef HTTP_ETAG_MAIN_JS
+#define HTTP_ETAG_MAIN_JS 0
+#endif
+#ifndef HTTP_ETAG_PETITE_VUE_HASP_JS
+#define HTTP_ETAG_PETITE_VUE_HASP_JS 0
+#endif
+
+typedef struct
+{
+    const char* path;
+    const uint8_t* start;
+    const uint8_t* end;
+    bool gzip;
+    uint32_t etag; // crc32 of the content
+} http_static_file_t;
+
+static http_static_file_t http_static_files[] = {
+    {"/edit.htm", EDIT_HTM_GZ_START, EDIT_HTM_GZ_END, true, HTTP_ETAG_EDIT_HTM},
+    {"/logo.svg", LOGO_SVG_GZ_START, LOGO_SVG_GZ_END, true, HTTP_ETAG_LOGO_SVG},            // 300 bytes
+    {"/style.css", STYLE_CSS_GZ_START, STYLE_CSS_GZ_END, true, HTTP_ETAG_STYLE_CSS},        // 11 kB
+    {"/vars.css", HTTP_VARS_CSS, HTTP_VARS_CSS + sizeof(HTTP_VARS_CSS) - 1, false, 0},      // theme colors
+    {"/script.js", SCRIPT_JS_GZ_START, SCRIPT_JS_GZ_END, true, HTTP_ETAG_SCRIPT_JS},        // 3 kB
+    {"/en.json", EN_JSON_GZ_START, EN_JSON_GZ_END, true, HTTP_ETAG_EN_JSON},                // 2 kB
+    {"/main.js", MAIN_JS_GZ_START, MAIN_JS_GZ_END, true, HTTP_ETAG_MAIN_JS},                // 9 kB
+    {"/petite-vue.hasp.js", PETITE_VUE_HASP_JS_GZ_START, PETITE_VUE_HASP_JS_GZ_END, true,
+     HTTP_ETAG_PETITE_VUE_HASP_JS},                                                         // 9 kB
+    // {"/hasp.htm", HASP_HTM_GZ_START, HASP_HTM_GZ_END, true, 0},                          // 39 kB
+    // {"/ace.js", ACE_JS_GZ_START, ACE_JS_GZ_END, true, 0},                                // 96 kB
+};
+
+static http_static_file_t* http_find_static_file(String path)
 {
-    String contentType((char*)0);
-    contentType = http_get_content_type(path);
     if(path.startsWith("/static/")) {
         path = path.substring(7);
     }
 
+    for(http_static_file_t& file : http_static_files) {
+        if(path == file.path) return &file;
+    }
+    return NULL;
+}
+
+static void http_get_static_etag(http_static_file_t* file, char* etag, size_t size)
+{
+    if(file->etag == 0) file->etag = crc32_le(0, file->start, file->end - file->start);
+    snprintf_P(etag, size, PSTR("\"%08x\""), file->etag);
+}
+
+/* The embedded files only change with the firmware, a revalidation is answered without reading anything */
+static bool http_send_static_not_modified(http_static_file_t* file)
+{
+    char etag[16];
+    http_get_static_etag(file, etag, sizeof(etag));
+    if(!strstr(webServer.header("If-None-Match").c_str(), etag)) return false;
+
+    webServer.sendHeader("ETag", etag);
+    http_send_cache_header(0, HTTP_STATIC_MAX_AGE);
+    webServer.send(304, http_get_content_type(file->path), "");
+    return true;
+}
+
+static int http_send_static_file(http_static_file_t* file, String& contentType)
+{
+    char etag[16];
+    http_get_static_etag(file, etag, sizeof(etag));
+    webServer.sendHeader("ETag", etag);
+    if(file->gzip) webServer.sendHeader("Content-Encoding", "gzip");
+
+    size_t size = file->end > file->start ? file->end - file->start : 0;
+    return http_send_cached(200, contentType.c_str(), (const char*)file->start, size, HTTP_STATIC_MAX_AGE);
+}
+#endif // CONFIG_IDF_TARGET_ESP32
+
+static inline int handleFirmwareFile(String path)
+{
+    String contentType((char*)0);
+    contentType = http_get_content_type(path);
+
 #if defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_IDF_TARGET_ESP32S2) || defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
-    if(path == F("/edit.htm")) {
-        return http_send_static_gzip_file(EDIT_HTM_GZ_START, EDIT_HTM_GZ_END, contentType);
-        // } else if(path == F("/hasp.htm")) { // 39 kB
-        //     return http_send_static_gzip_file(HASP_HTM_GZ_START, HASP_HTM_GZ_END, contentType);
-    } else if(path == F("/logo.svg")) { // 300 bytes
-        return http_send_static_gzip_file(LOGO_SVG_GZ_START, LOGO_SVG_GZ_END, contentType);
-    } else if(path == F("/style.css")) { // 11 kB
-        return http_send_static_gzip_file(STYLE_CSS_GZ_START, STYLE_CSS_GZ_END, contentType);
-    } else if(path == F("/vars.css")) {
-        return http_send_static_file(HTTP_VARS_CSS, HTTP_VARS_CSS + sizeof(HTTP_VARS_CSS) - 1, contentType);
-    } else if(path == F("/script.js")) { // 3 kB
-        return http_send_static_gzip_file(SCRIPT_JS_GZ_START, SCRIPT_JS_GZ_END, contentType);
-    } else if(path == F("/en.json")) { // 2 kB
-        return http_send_static_gzip_file(EN_JSON_GZ_START, EN_JSON_GZ_END, contentType);
-    } else if(path == F("/main.js")) { // 9 kB
-        return http_send_static_gzip_file(MAIN_JS_GZ_START, MAIN_JS_GZ_END, contentType);
-    } else if(path == F("/petite-vue.hasp.js")) { // 9 kB
-        return http_send_static_gzip_file(PETITE_VUE_HASP_JS_GZ_START, PETITE_VUE_HASP_JS_GZ_END, contentType);
-#if ESP_FLASH_SIZE > 4
-        // } else if(path == F("/ace.js")) { // 96 kB
-        //     return http_send_static_gzip_file(ACE_JS_GZ_START, ACE_JS_GZ_END, contentType);
-#endif
+    if(http_static_file_t* file = http_find_static_file(path)) {
+        return http_send_static_file(file, contentType);
     }
 #endif // ARDUINO_ARCH_ESP32
 
     if(path == F("/favicon.ico")) {
-        return http_send_cached(204, contentType.c_str(), "", 0, 365 * 24 * 60 * 60); // No content
+        return http_send_cached(204, contentType.c_str(), "", 0, HTTP_STATIC_MAX_AGE); // No content
     }
 
     return 404;
@@ -2445,6 +3218,15 @@ static void httpHandleFile(String path)
 { // webServer 404
     int statuscode = 404;
 
+#if defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_IDF_TARGET_ESP32S2) || defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
+    // Answer a cached embedded file before looking for a replacement on the filesystem
+    http_static_file_t* file = http_find_static_file(path);
+    if(file && webServer.hasHeader("If-None-Match")) {
+        if(!http_is_authenticated()) return; // authentication requested
+        if(http_send_static_not_modified(file)) statuscode = 304;
+    }
+#endif
+
 #if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
     if(statuscode == 404) {
         statuscode = handleFilesystemFile(path);
@@ -2463,7 +3245,7 @@ static void httpHandleFile(String path)
     // String(webServer.client().remoteIP()).c_str());
 #endif
 
-    if(statuscode < 300 || statuscode == 304) return; // OK or Not Modified
+    if(statuscode < 300 || statuscode == 304 || statuscode == 416) return; // OK, Not Modified or bad Range
 
     httpHandleInvalidRequest(statuscode, path);
 }
@@ -2697,7 +3479,7 @@ void httpSetup()
     LOG_DEBUG(TAG_HTTP, F(D_BULLET "Read %s => %s (%d bytes)"), FP_CONFIG_PASS, password.c_str(), password.length());
 
     // ask server to track these headers
-    const char* headerkeys[] = {"Content-Length", "If-None-Match",
+    const char* headerkeys[] = {"Content-Length", "If-None-Match", "Content-Range", "Range", "If-Range",
                                 "Cookie"}; // "Authentication" is automatically checked
     size_t headerkeyssize    = sizeof(headerkeys) / sizeof(char*);
     webServer.collectHeaders(headerkeys, headerkeyssize);
@@ -2707,6 +3489,15 @@ void httpSetup()
     // webServer.on("/vars.css", webSendCssVars);
     // webServer.on("/js", webSendJavascript);
     webServer.on(UriBraces("/api/config/{}/"), webHandleApiConfig);
+#if defined(ARDUINO_ARCH_ESP32)
+    webServer.on("/api/command/", HTTP_POST, http_handle_command, http_handle_command_raw);
+    webServer.on("/api/command", HTTP_POST, http_handle_command, http_handle_command_raw);
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+    webServer.on("/api/upload/", HTTP_GET, http_handle_upload);
+    webServer.on("/api/upload/", HTTP_POST, http_handle_upload, http_handle_upload_raw);
+    webServer.on("/api/upload", HTTP_POST, http_handle_upload, http_handle_upload_raw);
+#endif
+#endif
     webServer.on(UriBraces("/api/{}/"), webHandleApi);
 
     webServer.on(UriBraces("/config/{}/"), HTTP_GET, []() { httpHandleFile(F("/hasp.htm")); }); // SPA Route
@@ -2768,6 +3559,12 @@ void httpSetup()
 
     webServer.on("/", http_handle_root);
     webServer.on("/screenshot", http_handle_screenshot);
+#if HASP_USE_REMOTE_VIEW > 0
+    webServer.on("/remote", http_handle_remote_view);
+#endif
+#if HASP_USE_EVENT_STREAM > 0
+    webServer.on("/events", http_handle_events);
+#endif
 #ifdef HTTP_LEGACY
     webServer.on("/info", http_handle_info);
     webServer.on("/reboot", http_handle_reboot);
@@ -2813,6 +3610,15 @@ IRAM_ATTR void httpLoop(void)
     dnsServer.processNextRequest();
 #endif
     webServer.handleClient();
+#if HASP_USE_REMOTE_VIEW > 0
+    http_remote_view_loop();
+#endif
+#if HASP_USE_EVENT_STREAM > 0
+    http_event_stream_loop();
+#endif
+#if defined(ARDUINO_ARCH_ESP32)
+    http_stream_loop();
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2872,6 +3678,14 @@ bool httpSetConfig(const JsonObject& settings)
 }
 #endif // HASP_USE_CONFIG
 
+/* Write one chunk of a response started with CONTENT_LENGTH_UNKNOWN */
+size_t httpClientWriteChunk(const uint8_t* buf, size_t size)
+{
+    if(!webServer.client() || !webServer.client().connected()) return 0;
+    webServer.sendContent((const char*)buf, size);
+    return size;
+}
+
 size_t httpClientWrite(const uint8_t* buf, size_t size)
 {
     /***** Sending 16Kb at once freezes on STM32 EthernetClient *****/
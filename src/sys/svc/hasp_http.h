@@ -29,7 +29,8 @@ IRAM_ATTR void httpLoop(void);
 void httpStart(void);
 void httpStop(void);
 
-size_t httpClientWrite(const uint8_t* buf, size_t size); // Screenshot Write Data
+size_t httpClientWrite(const uint8_t* buf, size_t size);      // Screenshot Write Data
+size_t httpClientWriteChunk(const uint8_t* buf, size_t size); // Chunked Write Data
 
 #if HASP_USE_CONFIG > 0
 bool httpGetConfig(const JsonObject& settings);
@@ -0,0 +1,213 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasplib.h"
+
+#if HASP_USE_REMOTE_VIEW > 0
+
+#include "hasp_debug.h"
+#include "hasp_gui.h"
+#include "hasp/hasp_img_encoder.h"
+#include "hasp_remote_view.h"
+
+static struct
+{
+    bool active;
+    bool frame_open; // the current lvgl refresh is being sent
+    bool has_pending;
+    uint32_t frame_time;
+    lv_area_t pending; // skipped areas, to be rendered again
+    img_encoder_t* enc;
+    uint8_t* buf;
+    size_t head; // first byte to send
+    size_t tail; // end of the queued messages
+} remote_view;
+
+static void remote_view_put_header(uint8_t* dest, char type, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h,
+                                   uint32_t len)
+{
+    uint16_t values[] = {(uint16_t)x, (uint16_t)y, (uint16_t)w, (uint16_t)h};
+
+    dest[0] = type;
+    dest[1] = IMG_ENCODER_PNG;
+    for(uint8_t i = 0; i < 4; i++) {
+        dest[2 + i * 2] = values[i] & 0xFF;
+        dest[3 + i * 2] = values[i] >> 8;
+    }
+    for(uint8_t i = 0; i < 4; i++) dest[10 + i] = (len >> (i * 8)) & 0xFF;
+}
+
+/* Encoder output, fails when the queue is full */
+static size_t remote_view_write(const uint8_t* buf, size_t len)
+{
+    if(REMOTE_VIEW_BUFSIZE - remote_view.tail < len) return 0;
+    memcpy(remote_view.buf + remote_view.tail, buf, len);
+    remote_view.tail += len;
+    return len;
+}
+
+/* Queue one rectangle, the rows of color_p are stride pixels apart */
+static bool remote_view_encode(const lv_area_t* area, const lv_color_t* color_p, lv_coord_t stride)
+{
+    if(remote_view.head > 0) { // move the unsent bytes to the front
+        memmove(remote_view.buf, remote_view.buf + remote_view.head, remote_view.tail - remote_view.head);
+        remote_view.tail -= remote_view.head;
+        remote_view.head = 0;
+    }
+
+    size_t start      = remote_view.tail;
+    lv_coord_t width  = lv_area_get_width(area);
+    lv_coord_t height = lv_area_get_height(area);
+    if(REMOTE_VIEW_BUFSIZE - start < REMOTE_VIEW_HEADER_SIZE) return false;
+
+    remote_view.tail += REMOTE_VIEW_HEADER_SIZE;
+    size_t len = 0;
+    if(img_encoder_begin(remote_view.enc, width, height, remote_view_write)) {
+        for(lv_coord_t y = 0; y < height; y++, color_p += stride)
+            img_encoder_push(remote_view.enc, (const uint16_t*)color_p, 1);
+        len = img_encoder_end(remote_view.enc);
+    }
+
+    if(len == 0) {
+        remote_view.tail = start; // drop the partial message
+        return false;
+    }
+    remote_view_put_header(remote_view.buf + start, 'R', area->x1, area->y1, width, height, len);
+    return true;
+}
+
+static void remote_view_defer(const lv_area_t* area)
+{
+    if(remote_view.has_pending)
+        _lv_area_join(&remote_view.pending, &remote_view.pending, area);
+    else
+        lv_area_copy(&remote_view.pending, area);
+    remote_view.has_pending = true;
+}
+
+static inline bool remote_view_has_room()
+{
+    return remote_view.tail - remote_view.head < REMOTE_VIEW_BUFSIZE / 2;
+}
+
+/* Queue an area in slices, the part that doesn't fit is deferred */
+static void remote_view_send(const lv_area_t* area, const lv_color_t* color_p, lv_coord_t stride)
+{
+    // Slices of at most a quarter of the queue uncompressed always fit once the queue is half empty
+    lv_coord_t rows = REMOTE_VIEW_BUFSIZE / 4 / (lv_area_get_width(area) * 3);
+    lv_area_t slice = *area;
+    if(rows < 1) rows = 1;
+
+    while(slice.y1 <= area->y2) {
+        slice.y2 = LV_MATH_MIN(slice.y1 + rows - 1, area->y2);
+        if(!remote_view_encode(&slice, color_p + (slice.y1 - area->y1) * stride, stride)) break;
+        slice.y1 = slice.y2 + 1;
+    }
+    if(slice.y1 <= area->y2) {
+        slice.y2 = area->y2;
+        remote_view_defer(&slice);
+    }
+}
+
+/* Called from the flush callback after the pixels were handed to the display driver */
+void remote_view_flush(lv_disp_drv_t* disp, const lv_area_t* area, const lv_color_t* color_p)
+{
+    if(!remote_view.active) return;
+
+    if(!remote_view.frame_open && millis() - remote_view.frame_time >= REMOTE_VIEW_PERIOD &&
+       remote_view_has_room()) {
+        remote_view.frame_open = true;
+        remote_view.frame_time = millis();
+    }
+
+    if(remote_view.frame_open)
+        remote_view_send(area, color_p, lv_area_get_width(area));
+    else
+        remote_view_defer(area);
+
+    if(lv_disp_flush_is_last(disp)) remote_view.frame_open = false;
+}
+
+/* Send the skipped areas once the viewer has caught up */
+void remote_view_loop(void)
+{
+    if(!remote_view.active || !remote_view.has_pending || remote_view.frame_open) return;
+    if(millis() - remote_view.frame_time < REMOTE_VIEW_PERIOD || !remote_view_has_room()) return;
+
+    lv_area_t area          = remote_view.pending;
+    remote_view.has_pending = false;
+
+#if HASP_USE_SHADOW_FB > 0
+    lv_coord_t width, height;
+    if(const lv_color_t* fb = gui_shadow_fb_get(&width, &height)) { // read them back, nothing is rendered
+        remote_view.frame_time = millis();
+        remote_view_send(&area, fb + area.y1 * width + area.x1, width);
+        return;
+    }
+#endif
+
+    lv_disp_t* disp = lv_disp_get_default();
+    if(disp->driver.sw_rotate && disp->driver.rotated != LV_DISP_ROT_NONE)
+        lv_obj_invalidate(lv_scr_act()); // the flushed areas are in display coordinates
+    else
+        _lv_inv_area(disp, &area);
+}
+
+bool remote_view_start(void)
+{
+    remote_view_stop();
+
+    // The flushed areas are in display coordinates when lvgl rotates the pixels itself
+    lv_disp_t* disp   = lv_disp_get_default();
+    lv_coord_t width  = disp->driver.sw_rotate ? disp->driver.hor_res : lv_disp_get_hor_res(disp);
+    lv_coord_t height = disp->driver.sw_rotate ? disp->driver.ver_res : lv_disp_get_ver_res(disp);
+
+    // The encoder buffers fit the widest area and are reused for every slice of the session
+    remote_view.buf = (uint8_t*)hasp_malloc(REMOTE_VIEW_BUFSIZE);
+    remote_view.enc = (img_encoder_t*)hasp_calloc(1, sizeof(img_encoder_t));
+    if(!remote_view.buf || !remote_view.enc ||
+       !img_encoder_init(remote_view.enc, IMG_ENCODER_PNG, width, 1, LV_COLOR_16_SWAP != 0)) {
+        LOG_ERROR(TAG_GUI, F(D_ERROR_OUT_OF_MEMORY));
+        remote_view_stop();
+        return false;
+    }
+
+    lv_area_t area    = {0, 0, (lv_coord_t)(width - 1), (lv_coord_t)(height - 1)};
+    remote_view_put_header(remote_view.buf, 'S', 0, 0, width, height, 0);
+    remote_view.tail = REMOTE_VIEW_HEADER_SIZE;
+
+    remote_view.frame_time = millis() - REMOTE_VIEW_PERIOD;
+    remote_view.active     = true;
+    remote_view_defer(&area); // send the first frame
+    LOG_VERBOSE(TAG_GUI, F("Remote view started"));
+    return true;
+}
+
+void remote_view_stop(void)
+{
+    if(remote_view.active) LOG_VERBOSE(TAG_GUI, F("Remote view stopped"));
+
+    if(remote_view.enc) img_encoder_free(remote_view.enc);
+    hasp_free(remote_view.buf);
+    hasp_free(remote_view.enc);
+    memset(&remote_view, 0, sizeof(remote_view));
+}
+
+bool remote_view_is_active(void)
+{
+    return remote_view.active;
+}
+
+const uint8_t* remote_view_peek(size_t* len)
+{
+    *len = remote_view.tail - remote_view.head;
+    return remote_view.buf + remote_view.head;
+}
+
+void remote_view_consume(size_t len)
+{
+    remote_view.head += len;
+    if(remote_view.head >= remote_view.tail) remote_view.head = remote_view.tail = 0;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_REMOTE_VIEW_H
+#define HASP_REMOTE_VIEW_H
+
+#include "hasplib.h"
+
+#if HASP_USE_REMOTE_VIEW > 0
+
+/* Live view of the display
+ *
+ * The areas flushed to the display are compressed to PNG and queued as messages for a single viewer:
+ *   byte 0      'S' screen size or 'R' rectangle
+ *   byte 1      image format of a rectangle, IMG_ENCODER_PNG
+ *   byte 2-9    x, y, width, height as little endian uint16
+ *   byte 10-13  payload length as little endian uint32, followed by the payload
+ * A new frame is only accepted every REMOTE_VIEW_PERIOD ms and while the queue is half empty. Areas that
+ * are skipped are collected and read from the shadow framebuffer once the viewer catches up, or invalidated
+ * so only they are rendered again when there is no shadow framebuffer.
+ */
+
+#ifndef REMOTE_VIEW_PERIOD
+#define REMOTE_VIEW_PERIOD 100 // [ms] minimum time between frames
+#endif
+#ifndef REMOTE_VIEW_BUFSIZE
+#define REMOTE_VIEW_BUFSIZE (24 * 1024) // queued messages
+#endif
+#define REMOTE_VIEW_HEADER_SIZE 14
+
+/* ===== Default Event Processors ===== */
+bool remote_view_start(void);
+void remote_view_stop(void);
+void remote_view_loop(void);
+
+/* ===== Special Event Processors ===== */
+void remote_view_flush(lv_disp_drv_t* disp, const lv_area_t* area, const lv_color_t* color_p);
+
+/* ===== Getter and Setter Functions ===== */
+bool remote_view_is_active(void);
+const uint8_t* remote_view_peek(size_t* len); // queued bytes to send
+void remote_view_consume(size_t len);         // bytes that were sent
+
+#endif
+#endif
@@ -0,0 +1,66 @@
+# Helpers for the screenshot tests, the plate sends a 16-bit BI_BITFIELDS bitmap
+import struct
+
+
+def read_bitmap(response):
+    """Return the width, height and RGB565 pixels of a screenshot, top row first"""
+    data = response.content
+    assert data[:2] == b"BM"
+
+    (offset,) = struct.unpack_from("<I", data, 10)
+    width, height = struct.unpack_from("<ii", data, 18)
+    (bpp,) = struct.unpack_from("<H", data, 28)
+    masks = struct.unpack_from("<III", data, 54)
+    top_down = height < 0
+    height = abs(height)
+
+    assert bpp == 16
+    assert masks == (0xF800, 0x07E0, 0x001F)  # little endian RGB565, whatever the panel byte order is
+    assert len(data) == offset + width * height * 2
+
+    pixels = list(struct.unpack_from("<%dH" % (width * height), data, offset))
+    if not top_down:
+        rows = [pixels[y * width : (y + 1) * width] for y in range(height)]
+        pixels = [pixel for row in reversed(rows) for pixel in row]
+    return width, height, pixels
+
+
+def blend565(fg, bg, opa):
+    """lv_color_mix() of two RGB565 colors, like the software renderer and the gpu blend kernels"""
+    if opa <= 2:  # LV_OPA_MIN, not drawn
+        return bg
+    if opa > 253:  # LV_OPA_MAX, copied
+        return fg
+
+    def mix(shift, mask):
+        value = ((fg >> shift) & mask) * opa + ((bg >> shift) & mask) * (255 - opa) + 128
+        return ((value * 0x8081) >> 23) << shift
+
+    return mix(11, 0x1F) | mix(5, 0x3F) | mix(0, 0x1F)
+
+
+def reference_frame(width, height, background, rects=()):
+    """Expected frame: the background color with the [x, y, w, h, rgb565] or [x, y, w, h, rgb565, opa]
+    rectangles drawn on top"""
+    frame = [background] * (width * height)
+    for x, y, w, h, color, *opa in rects:
+        for row in range(max(y, 0), min(y + h, height)):
+            for col in range(max(x, 0), min(x + w, width)):
+                i = row * width + col
+                frame[i] = blend565(color, frame[i], opa[0]) if opa else color
+    return frame
+
+
+def check_frame(response, background, rects=()):
+    """Compare every pixel of the screenshot against the reference frame"""
+    width, height, pixels = read_bitmap(response)
+    expected = reference_frame(width, height, background, rects)
+
+    wrong = [i for i in range(width * height) if pixels[i] != expected[i]]
+    if wrong:
+        i = wrong[0]
+        raise AssertionError(
+            "{} of {} pixels differ, first at ({},{}) is {} instead of {}".format(
+                len(wrong), width * height, i % width, i // width, pixels[i], expected[i]
+            )
+        )
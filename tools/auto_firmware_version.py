@@ -1,4 +1,4 @@
-import gzip, pkg_resources
+import glob, gzip, os, pkg_resources, zlib
 
 Import("env")
 
@@ -40,29 +40,43 @@ commit_hash = r.head().decode("utf-8")[0:7]
 with open("data/edit.htm", "r", encoding="utf-8") as f:
     html=f.read()
 html = html.replace("COMMIT_HASH", commit_hash)
-with gzip.open('data/static/edit.htm.gz', 'wb') as f:
+with gzip.GzipFile('data/static/edit.htm.gz', 'wb', mtime=0) as f:
   f.write(html.encode('utf-8'))
 
 with open("data/main.js", "r", encoding="utf-8") as f:
     html=f.read()
 html = html.replace("COMMIT_HASH", commit_hash)
-with gzip.open('data/static/main.js.gz', 'wb') as f:
+with gzip.GzipFile('data/static/main.js.gz', 'wb', mtime=0) as f:
   f.write(html.encode('utf-8'))
 
 with open("data/script.js", "r", encoding="utf-8") as f:
     html=f.read()
 html = html.replace("COMMIT_HASH", commit_hash)
-with gzip.open('data/static/script.js.gz', 'wb') as f:
+with gzip.GzipFile('data/static/script.js.gz', 'wb', mtime=0) as f:
   f.write(html.encode('utf-8'))
 
 with open("data/en.json", "r", encoding="utf-8") as f:
     html=f.read()
 html = html.replace("COMMIT_HASH", commit_hash)
-with gzip.open('data/static/en.json.gz', 'wb') as f:
+with gzip.GzipFile('data/static/en.json.gz', 'wb', mtime=0) as f:
   f.write(html.encode('utf-8'))
 
 with open("data/style.css", "r", encoding="utf-8") as f:
     html=f.read()
 html = html.replace("COMMIT_HASH", commit_hash)
-with gzip.open('data/static/style.css.gz', 'wb') as f:
+with gzip.GzipFile('data/static/style.css.gz', 'wb', mtime=0) as f:
   f.write(html.encode('utf-8'))
+
+# Content hash of the embedded web files, used as ETag so unchanged files are not downloaded again
+def get_static_etags():
+    build_flags = []
+    for filename in sorted(glob.glob("data/static/*.gz")):
+        name = os.path.basename(filename)[:-3].replace(".", "_").replace("-", "_").upper()
+        with open(filename, "rb") as f:
+            crc = zlib.crc32(f.read()) & 0xFFFFFFFF
+        build_flags.append("-D HTTP_ETAG_" + name + "=0x%08x" % crc)
+    return build_flags
+
+env.Append(
+    BUILD_FLAGS=get_static_etags()
+)
@@ -0,0 +1,59 @@
+# Compare applying a batch of commands over HTTP and over MQTT
+#
+# Usage: python tools/command_bench.py <plate ip> <mqtt broker> <plate name> [count] [mqtt user] [mqtt password]
+#
+# The same commands are sent as one POST to /api/command/ and as separate MQTT messages.
+# The MQTT run ends when the plate has published the state requested after the last command.
+
+import sys
+import threading
+import time
+
+import paho.mqtt.client as mqtt
+import requests
+
+plate_ip = sys.argv[1]
+broker = sys.argv[2]
+plate = sys.argv[3]
+count = int(sys.argv[4]) if len(sys.argv) > 4 else 200
+
+setup = '{"page":1,"id":250,"obj":"label","x":0,"y":0,"text":"bench"}'
+commands = ["p1b250.text=%d" % i for i in range(count)]
+
+
+def bench_http():
+    body = "\n".join([setup] + commands)
+    start = time.perf_counter()
+    reply = requests.post("http://%s/api/command/" % plate_ip, data=body.encode(), timeout=60)
+    elapsed = time.perf_counter() - start
+    result = reply.json()
+    print("http  %4d commands %7.1f ms, %d failed, %.1f ms on the plate" %
+          (result["count"], elapsed * 1000, result["failed"], result["duration"] / 1000))
+
+
+def bench_mqtt():
+    done = threading.Event()
+    client = mqtt.Client()
+    if len(sys.argv) > 6:
+        client.username_pw_set(sys.argv[5], sys.argv[6])
+    client.on_message = lambda c, u, msg: done.set()
+    client.connect(broker)
+    client.subscribe("hasp/%s/state/p1b250" % plate)
+    client.loop_start()
+
+    topic = "hasp/%s/command" % plate
+    client.publish(topic + "/jsonl", setup, qos=1)
+    start = time.perf_counter()
+    for command in commands:
+        client.publish(topic, command, qos=1)
+    client.publish(topic, "p1b250.text", qos=1)  # the reply marks the end of the batch
+    done.wait(60)
+    elapsed = time.perf_counter() - start
+
+    client.loop_stop()
+    client.disconnect()
+    print("mqtt  %4d commands %7.1f ms" % (count, elapsed * 1000))
+
+
+bench_http()
+bench_mqtt()
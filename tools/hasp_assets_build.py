@@ -0,0 +1,87 @@
+# Pack a folder into an image of the read-only assets partition, its files are used in place from flash
+#
+# Usage: python tools/hasp_assets_build.py [--swap] [--size 2048K] <folder> <assets.bin>
+#
+# The path of a file in the folder is its path on the L: drive, e.g. <folder>/fonts/roboto_24.bin is L:/fonts/roboto_24.bin
+# png and jpg images are stored as the uncompressed .bin the plate shows in place, logo.png becomes logo.png.bin and
+# the pages keep referencing logo.png. Use --swap for displays built with LV_COLOR_16_SWAP.
+# Flash the image into a partition table with an assets partition, e.g. user_setups/esp32/partitions_16MB_assets.csv:
+#   parttool.py --port <port> write_partition --partition-name assets --input assets.bin
+# On Linux copy assets.bin into the root of the L: drive instead.
+
+import argparse
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import hasp_image_convert  # noqa: E402
+
+MAGIC = b"HAST"
+VERSION = 1
+NAME_SIZE = 56  # including the terminating zero
+HEADER_SIZE = 12
+ENTRY_SIZE = NAME_SIZE + 8
+ALIGN = 4
+
+
+def parse_size(text):
+    text = text.upper()
+    if text.endswith("K"):
+        return int(text[:-1]) * 1024
+    if text.endswith("M"):
+        return int(text[:-1]) * 1024 * 1024
+    return int(text, 0)
+
+
+def collect(folder, swap):
+    files = {}
+    for root, dirs, names in os.walk(folder):
+        for name in names:
+            path = os.path.join(root, name)
+            key = "/" + os.path.relpath(path, folder).replace(os.sep, "/")
+            if os.path.splitext(name)[1].lower() in (".png", ".jpg", ".jpeg"):
+                data = hasp_image_convert.encode(path, False, swap)
+                if data is None:
+                    continue
+                key += ".bin"
+            else:
+                with open(path, "rb") as f:
+                    data = f.read()
+            if len(key.encode()) >= NAME_SIZE:
+                print("%s: path longer than %d characters, skipped" % (key, NAME_SIZE - 1))
+                continue
+            files[key.encode()] = data
+    return files
+
+
+def build(files):
+    names = sorted(files)  # binary search on the plate
+    offset = HEADER_SIZE + len(names) * ENTRY_SIZE
+    index = b""
+    data = b""
+    for name in names:
+        offset += -offset % ALIGN
+        data += b"\0" * (-(HEADER_SIZE + len(names) * ENTRY_SIZE + len(data)) % ALIGN)
+        index += struct.pack("<%dsII" % NAME_SIZE, name, offset, len(files[name]))
+        data += files[name]
+        offset += len(files[name])
+    return struct.pack("<4sHHI", MAGIC, VERSION, len(names), offset) + index + data
+
+
+parser = argparse.ArgumentParser(description="Build the image of the assets partition")
+parser.add_argument("--swap", action="store_true", help="swap the color bytes of images, for LV_COLOR_16_SWAP")
+parser.add_argument("--size", help="size of the partition, e.g. 2048K")
+parser.add_argument("folder")
+parser.add_argument("output")
+args = parser.parse_args()
+
+files = collect(args.folder, args.swap)
+image = build(files)
+if args.size and len(image) > parse_size(args.size):
+    print("%d bytes do not fit in a partition of %s" % (len(image), args.size))
+    sys.exit(1)
+
+with open(args.output, "wb") as f:
+    f.write(image)
+print("%s: %d files, %d bytes" % (args.output, len(files), len(image)))
@@ -0,0 +1,257 @@
+# Reduce binary fonts to the characters used in a pages file, like the fontsubset command on the plate
+#
+# Usage: python tools/hasp_font_subset.py [--keep CHARS] [--icons src/font/md-icons.json] <pages.jsonl> <font folder> <output folder>
+#
+# The text, txt, options and value_str attributes are drawn with the text_font and value_font of the object,
+# objects without a font attribute count for every font. <font folder>/<name>.bin is written to <output folder>/<name>.bin
+# with those characters, the --keep characters and the kerning between them, values set at runtime need theirs in --keep.
+# With --icons the MDI icons used in the pages are listed by name.
+
+import argparse
+import json
+import os
+import struct
+
+KEEP = " 0123456789.,:;-+/%°"  # same as FONT_SUBSET_KEEP
+TEXT_KEYS = ("text", "txt", "options")
+VALUE_KEYS = ("value_str",)
+
+HEAD = struct.Struct("<IHHHhHhHhhHHBBBBBBBBBBhH")
+CMAP = struct.Struct("<IIHHHBB")
+FORMAT0_FULL, SPARSE_FULL, FORMAT0_TINY, SPARSE_TINY = range(4)
+
+
+def is_key(key, name):
+    return key.startswith(name) and key[len(name):].isdigit() or key == name
+
+
+def text_of(value):
+    if isinstance(value, list):  # btnmatrix options
+        return "".join(text_of(item) for item in value)
+    if isinstance(value, bool):
+        return "true" if value else "false"
+    return str(value)
+
+
+def read_pages(path):
+    with open(path, encoding="utf-8") as f:
+        data = f.read()
+    decoder = json.JSONDecoder()
+    pos = 0
+    while True:
+        while pos < len(data) and data[pos] in " \t\r\n":
+            pos += 1
+        if pos >= len(data):
+            return
+        try:
+            obj, pos = decoder.raw_decode(data, pos)
+        except ValueError as e:
+            print("%s: %s" % (path, e))
+            return
+        if isinstance(obj, dict):
+            yield obj
+
+
+def scan(path):
+    fonts = {}
+    common = set(KEEP)
+    for obj in read_pages(path):
+        text = "".join(text_of(v) for k, v in obj.items() if any(is_key(k, n) for n in TEXT_KEYS))
+        value = "".join(text_of(v) for k, v in obj.items() if any(is_key(k, n) for n in VALUE_KEYS))
+        text_fonts = [str(v) for k, v in obj.items() if is_key(k, "text_font")]
+        value_fonts = [str(v) for k, v in obj.items() if is_key(k, "value_font")]
+        for letters, names in ((text, text_fonts), (value, value_fonts)):
+            if not names:
+                common.update(letters)
+            for name in names:
+                fonts.setdefault(name, set()).update(letters)
+    return {name: sorted(ord(c) for c in letters | common) for name, letters in fonts.items()}
+
+
+def table(data, pos, label):
+    length, name = struct.unpack_from("<I4s", data, pos)
+    if name != label.encode() or length < 8 or pos + length > len(data):
+        raise ValueError("no %s table" % label)
+    return data[pos : pos + length]
+
+
+def glyph_id(cmap, letter):
+    (count,) = struct.unpack_from("<I", cmap, 8)
+    for i in range(count):
+        offset, start, length, gid_start, entries, fmt, _ = CMAP.unpack_from(cmap, 12 + i * CMAP.size)
+        rcp = letter - start
+        if rcp < 0 or rcp >= length:
+            continue
+        if fmt == FORMAT0_TINY:
+            return gid_start + rcp
+        if fmt == FORMAT0_FULL:
+            return gid_start + cmap[offset + rcp]
+        ofs = struct.unpack_from("<%dH" % entries, cmap, offset)
+        if rcp not in ofs:
+            return 0
+        n = ofs.index(rcp)
+        if fmt == SPARSE_TINY:
+            return gid_start + n
+        return gid_start + struct.unpack_from("<H", cmap, offset + entries * 2 + n * 2)[0]
+    return 0
+
+
+def pad(data):
+    return data + b"\0" * (-len(data) % 4)
+
+
+def block(label, data):
+    data = pad(data)
+    return struct.pack("<I4s", len(data) + 8, label.encode()) + data
+
+
+def ram(glyphs, glyf, cmap):
+    return glyphs * 8 + glyf + cmap  # lv_font_fmt_txt_glyph_dsc_t is 8 bytes
+
+
+def kern_subset(kern, id_format, gids):
+    new_ids = {gid: i for i, gid in enumerate(gids) if i > 0}
+    (fmt,) = struct.unpack_from("<B", kern, 8)
+    if fmt == 0:  # pairs of glyph ids sorted by the left and the right one
+        (count,) = struct.unpack_from("<I", kern, 12)
+        size = "B" if id_format == 0 else "H"
+        ids = struct.unpack_from("<%d%s" % (count * 2, size), kern, 16)
+        values = struct.unpack_from("<%db" % count, kern, 16 + count * 2 * struct.calcsize(size))
+        pairs = sorted(
+            (new_ids[ids[i * 2]], new_ids[ids[i * 2 + 1]], values[i])
+            for i in range(count)
+            if ids[i * 2] in new_ids and ids[i * 2 + 1] in new_ids
+        )
+        body = struct.pack("<I", len(pairs))
+        body += struct.pack("<%d%s" % (len(pairs) * 2, size), *[g for p in pairs for g in p[:2]])
+        body += struct.pack("<%db" % len(pairs), *[p[2] for p in pairs])
+    elif fmt == 3:  # classes of the left and right glyph, the values are kept
+        length, rows, cols = struct.unpack_from("<HBB", kern, 12)
+        left = kern[16 : 16 + length]
+        right = kern[16 + length : 16 + length * 2]
+        values = kern[16 + length * 2 : 16 + length * 2 + rows * cols]
+        if len(values) != rows * cols:
+            raise ValueError("kern table too short")
+        body = struct.pack("<HBB", len(gids), rows, cols)
+        body += bytes(left[g] if g < length else 0 for g in gids)
+        body += bytes(right[g] if g < length else 0 for g in gids)
+        body += values
+    else:
+        raise ValueError("unknown kern format %d" % fmt)
+    return block("kern", kern[8:12] + body)
+
+
+def subset(data, letters):
+    head = table(data, 0, "head")
+    cmap = table(data, len(head), "cmap")
+    loca = table(data, len(head) + len(cmap), "loca")
+    glyf = table(data, len(head) + len(cmap) + len(loca), "glyf")
+
+    header = list(HEAD.unpack_from(head, 8))
+    (loca_count,) = struct.unpack_from("<I", loca, 8)
+    size = "H" if header[12] == 0 else "I"
+    offsets = list(struct.unpack_from("<%d%s" % (loca_count, size), loca, 12)) + [len(glyf)]
+
+    found = []
+    gids = [0]
+    for letter in letters:
+        gid = glyph_id(cmap, letter)
+        if 0 < gid < loca_count:
+            found.append(letter)
+            gids.append(gid)
+
+    tables = []
+    i = 0
+    while i < len(found):
+        end = i
+        while end < len(found) and found[end] - found[i] < 0xFFFF:
+            end += 1
+        tables.append((found[i], found[end - 1] - found[i] + 1, i + 1, found[i:end]))
+        i = end
+
+    subtables = b""
+    lists = b""
+    data_offset = 12 + len(tables) * CMAP.size
+    for start, length, gid_start, entries in tables:
+        subtables += CMAP.pack(data_offset + len(lists), start, length, gid_start, len(entries), SPARSE_TINY, 0)
+        lists += struct.pack("<%dH" % len(entries), *[c - start for c in entries])
+    new_cmap = block("cmap", struct.pack("<I", len(tables)) + subtables + lists)
+
+    records = b""
+    new_offsets = []
+    for gid in gids:
+        new_offsets.append(8 + len(records))
+        records += glyf[offsets[gid] : offsets[gid + 1]]
+    new_loca = block("loca", struct.pack("<I%dI" % len(gids), len(gids), *new_offsets))
+    new_glyf = block("glyf", records)
+
+    new_kern = b""
+    if header[1] > 4:
+        kern = table(data, len(head) + len(cmap) + len(loca) + len(glyf), "kern")
+        new_kern = kern_subset(kern, header[13], gids)
+
+    header[1] = 5 if new_kern else 4
+    header[12] = 1
+    new_head = head[:8] + HEAD.pack(*header) + head[8 + HEAD.size :]
+
+    before = (len(data), ram(loca_count, len(glyf), len(cmap)), loca_count)
+    after_data = new_head + new_cmap + new_loca + new_glyf + new_kern
+    after = (len(after_data), ram(len(gids), len(new_glyf), len(new_cmap)), len(gids))
+    return after_data, before, after, [c for c in letters if c not in found]
+
+
+def icon_names(path):
+    from jsmin import jsmin  # the file has comments
+
+    with open(path, encoding="utf-8") as f:
+        icons = json.loads(jsmin(f.read()))["icons"]
+    names = {}
+    for name, value in icons.items():
+        target = value.split("=>")[-1]
+        names[int(target, 16)] = name
+    return names
+
+
+parser = argparse.ArgumentParser(description="Reduce binary fonts to the characters used in the pages")
+parser.add_argument("--keep", default=KEEP, help="characters of values set at runtime, default '%s'" % KEEP)
+parser.add_argument("--icons", help="md-icons.json to list the icons used by name")
+parser.add_argument("pages")
+parser.add_argument("fonts")
+parser.add_argument("output")
+args = parser.parse_args()
+
+KEEP = args.keep
+names = icon_names(args.icons) if args.icons else {}
+os.makedirs(args.output, exist_ok=True)
+
+total_before = [0, 0]
+total_after = [0, 0]
+for name, letters in sorted(scan(args.pages).items()):
+    path = os.path.join(args.fonts, name + ".bin")
+    if not os.path.isfile(path):
+        print("%s: not a binary font, skipped" % name)
+        continue
+    with open(path, "rb") as f:
+        data = f.read()
+    try:
+        result, before, after, missing = subset(data, letters)
+    except (ValueError, struct.error) as e:
+        print("%s: %s" % (path, e))
+        continue
+    with open(os.path.join(args.output, name + ".bin"), "wb") as f:
+        f.write(result)
+
+    print(
+        "%s: %d of %d glyphs, flash %d => %d bytes, ram %d => %d bytes"
+        % (name, after[2], before[2], before[0], after[0], before[1], after[1])
+    )
+    icons = [names.get(c, "U+%04X" % c) for c in letters if 0xE000 <= c <= 0xF8FF and c not in missing]
+    if icons:
+        print("  icons: %s" % ", ".join(icons))
+    if missing:
+        print("  not in the font: %s" % " ".join("U+%04X" % c for c in missing))
+    for i in range(2):
+        total_before[i] += before[i]
+        total_after[i] += after[i]
+
+print("saved %d bytes of flash and %d bytes of ram" % (total_before[0] - total_after[0], total_before[1] - total_after[1]))
@@ -0,0 +1,131 @@
+# Convert png and jpg images to the LVGL .bin format that is drawn without decoding
+#
+# Usage: python tools/hasp_image_convert.py [--rle] [--swap] <image> [<image> ...]
+#
+# Writes <image>.bin next to each image, e.g. logo.png.bin for logo.png. Upload both files, the pages keep
+# referencing logo.png and the plate reads the .bin instead. Images with transparency get an alpha byte per pixel.
+# Use --swap for displays built with LV_COLOR_16_SWAP, the colors of the SPI panels are stored byte swapped.
+# Use --rle to run-length encode the pixels, smaller files for images with areas of a single color.
+
+import argparse
+import struct
+import sys
+
+from PIL import Image
+
+LV_IMG_CF_TRUE_COLOR = 4
+LV_IMG_CF_TRUE_COLOR_ALPHA = 5
+IMAGE_STREAM_FLAG_RLE = 0x01  # lv_img_header_t.reserved
+MAX_SIZE = 2047
+MAX_RUN = 127
+
+
+def header(cf, flags, width, height):
+    return struct.pack("<I", cf | flags << 8 | width << 10 | height << 21)
+
+
+def png_depth(path):
+    with open(path, "rb") as f:
+        ihdr = f.read(26)
+    return ihdr[24] if ihdr[:8] == b"\x89PNG\r\n\x1a\n" else 8
+
+
+def rgba_pixels(image, depth):
+    """Pillow drops the transparent color of 16-bit and 1, 2 or 4-bit grayscale png files"""
+    key = image.info.get("transparency")
+    if image.mode in ("I;16", "I"):
+        sample = lambda v: (v >> 8, 255 if v != key else 0)
+    elif image.mode == "L" and isinstance(key, int) and depth < 8:
+        scaled = key * 255 // ((1 << depth) - 1)
+        sample = lambda v: (v, 255 if v != scaled else 0)
+    elif image.mode == "RGB" and isinstance(key, tuple) and depth == 16:
+        key = tuple(v >> 8 for v in key)  # only the upper 8 bits of the samples are left to compare
+        sample = None
+    else:
+        return image.convert("RGBA")
+
+    rgba = Image.new("RGBA", image.size)
+    for y in range(image.height):
+        for x in range(image.width):
+            v = image.getpixel((x, y))
+            if sample:
+                gray, a = sample(v)
+                rgba.putpixel((x, y), (gray, gray, gray, a))
+            else:
+                rgba.putpixel((x, y), v + (255 if v != key else 0,))
+    return rgba
+
+
+def pixels(rgba, alpha, swap):
+    order = ">H" if swap else "<H"
+    rows = []
+    for y in range(rgba.height):
+        row = []
+        for x in range(rgba.width):
+            r, g, b, a = rgba.getpixel((x, y))
+            px = struct.pack(order, (r >> 3) << 11 | (g >> 2) << 5 | b >> 3)
+            row.append(px + bytes([a]) if alpha else px)
+        rows.append(row)
+    return rows
+
+
+def rle(row):
+    out = bytearray()
+    x = 0
+    while x < len(row):
+        run = 1
+        while x + run < len(row) and run < MAX_RUN and row[x + run] == row[x]:
+            run += 1
+        if run > 1:
+            out += bytes([run]) + row[x]
+            x += run
+            continue
+
+        # Copy the pixels up to the next repeat
+        count = 1
+        while x + count < len(row) and count < MAX_RUN and (x + count + 1 == len(row) or row[x + count] != row[x + count + 1]):
+            count += 1
+        out += bytes([0x80 | count]) + b"".join(row[x:x + count])
+        x += count
+    return out
+
+
+def encode(path, use_rle, swap):
+    """LVGL .bin file of an image, None if it is too large"""
+    image = Image.open(path)
+    if image.width > MAX_SIZE or image.height > MAX_SIZE:
+        print("%s: larger than %d pixels, skipped" % (path, MAX_SIZE))
+        return None
+
+    rgba = rgba_pixels(image, png_depth(path))
+    alpha = rgba.getextrema()[3][0] < 255
+    cf = LV_IMG_CF_TRUE_COLOR_ALPHA if alpha else LV_IMG_CF_TRUE_COLOR
+
+    rows = pixels(rgba, alpha, swap)
+    if use_rle:
+        data = b"".join(rle(row) for row in rows)
+    else:
+        data = b"".join(b"".join(row) for row in rows)
+
+    print("%s.bin: %d x %d %s, %d bytes" % (path, image.width, image.height, "alpha" if alpha else "opaque", len(data) + 4))
+    return header(cf, IMAGE_STREAM_FLAG_RLE if use_rle else 0, image.width, image.height) + data
+
+
+def convert(path, use_rle, swap):
+    data = encode(path, use_rle, swap)
+    if data is None:
+        return False
+    with open(path + ".bin", "wb") as f:
+        f.write(data)
+    return True
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Convert png and jpg images to LVGL .bin files")
+    parser.add_argument("--rle", action="store_true", help="run-length encode the pixels")
+    parser.add_argument("--swap", action="store_true", help="swap the color bytes, for LV_COLOR_16_SWAP")
+    parser.add_argument("images", nargs="+")
+    args = parser.parse_args()
+
+    failed = [path for path in args.images if not convert(path, args.rle, args.swap)]
+    sys.exit(1 if failed else 0)
@@ -0,0 +1,110 @@
+# Compare the time the plate needs to open a png or jpg image and its converted .bin files
+#
+# Usage: python tools/image_decode_bench.py <image> <plate ip> [count]
+#
+# The image is converted with hasp_image_convert.py and uploaded <count> times in each format as /bench<n>,
+# every copy is a separate file so none of them comes from the image cache. The .bin files the plate writes for
+# the uploaded png or jpg copies are deleted to time the decoder itself. Each copy is shown in turn on page 1
+# and the times are taken from the "Image Decoder" section of /api/info.
+# Set HASP_SWAP=1 for displays built with LV_COLOR_16_SWAP.
+# Set HASP_USER and HASP_PASSWORD when the web interface is password protected.
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+import requests
+
+image = sys.argv[1]
+plate_ip = sys.argv[2]
+count = int(sys.argv[3]) if len(sys.argv) > 3 else 5
+swap = os.environ.get("HASP_SWAP") == "1"
+auth = (os.environ["HASP_USER"], os.environ["HASP_PASSWORD"]) if "HASP_PASSWORD" in os.environ else None
+base = "http://%s" % plate_ip
+ext = os.path.splitext(image)[1].lower()
+converter = os.path.join(os.path.dirname(os.path.abspath(__file__)), "hasp_image_convert.py")
+
+
+def convert(rle):
+    tmp = os.path.join(tempfile.mkdtemp(), "image" + ext)
+    with open(image, "rb") as src, open(tmp, "wb") as dst:
+        dst.write(src.read())
+    args = [sys.executable, converter, tmp] + (["--rle"] if rle else []) + (["--swap"] if swap else [])
+    subprocess.run(args, check=True, stdout=subprocess.DEVNULL)
+    with open(tmp + ".bin", "rb") as f:
+        return f.read()
+
+
+def upload(path, data):
+    headers = {"Content-Type": "application/octet-stream"}
+    reply = requests.post(base + "/api/upload/", params={"path": path}, data=data, headers=headers, auth=auth,
+                          timeout=30)
+    reply.raise_for_status()
+
+
+def delete_converted(path):
+    # Wait until the plate has written the .bin of the copy
+    for retry in range(50):
+        reply = requests.delete(base + "/edit", params={"path": path + ".bin"}, auth=auth, timeout=10)
+        if reply.status_code == 200:
+            return
+        time.sleep(0.2)
+    print("%s.bin was not written, is the converter disabled?" % path)
+
+
+def command(lines):
+    requests.post(base + "/api/command/", data="\n".join(lines).encode(), auth=auth, timeout=30).raise_for_status()
+
+
+def decoder_stats():
+    info = requests.get(base + "/api/info/", auth=auth, timeout=30).json()
+    stats = {}
+    for name, value in info.get("Image Decoder", {}).items():
+        times, ms = value.split(" x ")
+        stats[name] = (int(times), int(ms.split()[0]))
+    return stats
+
+
+def bench(label, paths, format):
+    before = decoder_stats()
+    for path in paths:
+        command(['p1b250.src="L:%s"' % path])
+        time.sleep(0.5)  # drawn with the next refresh
+    after = decoder_stats()
+
+    times, avg = after.get(format, (0, 0))
+    times0, avg0 = before.get(format, (0, 0))
+    if times == times0:
+        print("%-8s no %s images decoded" % (label, format))
+        return
+    ms = (times * avg - times0 * avg0) / (times - times0)
+    print("%-8s %3d x %7.1f ms (%s)" % (label, times - times0, ms, format))
+
+
+with open(image, "rb") as f:
+    encoded = f.read()
+native = {"raw": convert(False), "rle": convert(True)}
+
+print("uploading %d copies of %s" % (count, image))
+command(['{"page":1,"id":250,"obj":"img","x":0,"y":0}', "page 1"])
+
+encoded_paths = ["/bench%d%s" % (i, ext) for i in range(count)]
+for path in encoded_paths:
+    upload(path, encoded)
+for path in encoded_paths:
+    delete_converted(path)
+
+native_paths = {}
+for name, data in native.items():
+    native_paths[name] = ["/bench%d.%s.bin" % (i, name) for i in range(count)]
+    for path in native_paths[name]:
+        upload(path, data)
+
+print("%d x %d bytes, %d bytes raw .bin, %d bytes rle .bin" % (count, len(encoded), len(native["raw"]),
+                                                                 len(native["rle"])))
+bench(ext[1:], encoded_paths, "JPEG" if ext in (".jpg", ".jpeg") else "PNG")
+bench("raw .bin", native_paths["raw"], "BIN")
+bench("rle .bin", native_paths["rle"], "BIN RLE")
+command(["p1b250.delete"])
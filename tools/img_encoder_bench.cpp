@@ -0,0 +1,115 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host benchmark for the streaming screenshot encoder
+ *
+ * Build and run from the project folder:
+ *   g++ -O2 -Isrc tools/img_encoder_bench.cpp src/hasp/hasp_img_encoder.cpp src/drv/gpu/pixel_kernels.cpp \
+ *       -o img_encoder_bench
+ *   ./img_encoder_bench [output folder]
+ *
+ * A synthetic user interface frame is pushed in 10-row bands, like the lvgl flush callback does.
+ * When an output folder is given, the images are saved there to check them with an image viewer.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hasp/hasp_img_encoder.h"
+
+static std::vector<uint8_t> bench_output;
+
+static size_t bench_write(const uint8_t* buf, size_t len)
+{
+    bench_output.insert(bench_output.end(), buf, buf + len);
+    return len;
+}
+
+static uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b)
+{
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+static void fill_rect(std::vector<uint16_t>& fb, int stride, int x, int y, int w, int h, uint16_t color)
+{
+    for(int j = y; j < y + h; j++)
+        for(int i = x; i < x + w; i++) fb[j * stride + i] = color;
+}
+
+// Dark theme page: header, a grid of buttons with borders and anti-aliased looking labels, a gradient slider
+static std::vector<uint16_t> make_frame(int w, int h)
+{
+    std::vector<uint16_t> fb(w * h, rgb565(32, 32, 40));
+    std::mt19937 rng(w * h);
+
+    fill_rect(fb, w, 0, 0, w, h / 10, rgb565(40, 90, 160));
+    int bw = w / 4, bh = h / 5;
+    for(int row = 0; row < 3; row++) {
+        for(int col = 0; col < 3; col++) {
+            int x = 10 + col * (bw + 20), y = h / 10 + 10 + row * (bh + 10);
+            fill_rect(fb, w, x, y, bw, bh, rgb565(70, 140, 220));
+            fill_rect(fb, w, x + 2, y + 2, bw - 4, bh - 4, rgb565(50, 110, 190));
+            for(int c = 0; c < 6; c++) { // glyphs
+                int gx = x + 10 + c * 12, gy = y + bh / 2 - 6;
+                for(int j = 0; j < 12; j++)
+                    for(int i = 0; i < 8; i++)
+                        if(rng() % 3 == 0) fb[(gy + j) * w + gx + i] = rgb565(200 + rng() % 56, 220, 255);
+            }
+        }
+    }
+    for(int x = 0; x < w; x++) fill_rect(fb, w, x, h - h / 10, 1, h / 20, rgb565(x * 255 / w, 120, 255 - x * 255 / w));
+    return fb;
+}
+
+static void bench(int w, int h, uint8_t format, uint8_t scale, const char* folder)
+{
+    std::vector<uint16_t> fb = make_frame(w, h);
+    const int band           = 10;
+    const int rounds         = 20;
+    img_encoder_t enc;
+    size_t size = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    img_encoder_init(&enc, format, w, scale, false); // the buffers are reused by every round
+    for(int i = 0; i < rounds; i++) {
+        bench_output.clear();
+        img_encoder_begin(&enc, w, h, bench_write);
+        for(int y = 0; y < h; y += band) img_encoder_push(&enc, fb.data() + y * w, h - y < band ? h - y : band);
+        size = img_encoder_end(&enc);
+    }
+    img_encoder_free(&enc);
+    auto end  = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count() / rounds;
+
+    const char* ext = format == IMG_ENCODER_PNG ? "png" : "qoi";
+    printf("%4dx%-4d %s 1/%u %8zu bytes %5.1f%% of bmp %7.2f ms\n", w, h, ext, scale, size,
+           100.0 * size / (66 + w * h * 2), ms);
+
+    if(folder) {
+        std::string name = std::string(folder) + "/" + std::to_string(w) + "x" + std::to_string(h) + "_" +
+                           std::to_string(scale) + "." + ext;
+        FILE* file = fopen(name.c_str(), "wb");
+        if(file) {
+            fwrite(bench_output.data(), 1, bench_output.size(), file);
+            fclose(file);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* folder = argc > 1 ? argv[1] : NULL;
+    const int sizes[][2] = {{480, 320}, {800, 480}};
+
+    for(auto& size : sizes) {
+        printf("%4dx%-4d bmp      %8d bytes\n", size[0], size[1], 66 + size[0] * size[1] * 2);
+        bench(size[0], size[1], IMG_ENCODER_PNG, 1, folder);
+        bench(size[0], size[1], IMG_ENCODER_QOI, 1, folder);
+        bench(size[0], size[1], IMG_ENCODER_PNG, 4, folder);
+        bench(size[0], size[1], IMG_ENCODER_QOI, 4, folder);
+    }
+    return 0;
+}
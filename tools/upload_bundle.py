@@ -0,0 +1,74 @@
+# Upload a file or a ZIP bundle to one or more plates in parts, resuming after a dropped connection
+#
+# Usage: python tools/upload_bundle.py <file> <target path> <plate ip> [<plate ip> ...]
+#
+# A target path ending in .zip is extracted into its folder while it is received, e.g. /bundle.zip into /
+# A target of flash or spiffs writes a firmware or filesystem image, the plate reboots when it is complete
+# Set HASP_USER and HASP_PASSWORD when the web interface is password protected.
+
+import os
+import sys
+import time
+
+import requests
+
+PART_SIZE = 16 * 1024
+RETRIES = 5
+
+source = sys.argv[1]
+path = sys.argv[2]
+plates = sys.argv[3:]
+auth = (os.environ["HASP_USER"], os.environ["HASP_PASSWORD"]) if "HASP_PASSWORD" in os.environ else None
+
+with open(source, "rb") as f:
+    data = f.read()
+
+
+def upload(plate):
+    url = "http://%s/api/upload/" % plate
+    params = {"path": path}
+    status_path = path
+    if path in ("flash", "spiffs"):
+        params = {"update": path}
+        status_path = "/update/" + path
+    elif path.endswith(".zip"):
+        params["unzip"] = 1
+
+    offset = 0
+    retries = 0
+    while True:
+        part = data[offset:offset + PART_SIZE]
+        headers = {
+            "Content-Type": "application/octet-stream",
+            "Content-Range": "bytes %d-%d/%d" % (offset, offset + len(part) - 1, len(data)),
+        }
+        try:
+            reply = requests.post(url, params=params, data=part, headers=headers, auth=auth, timeout=30)
+            result = reply.json()
+        except (requests.RequestException, ValueError) as error:
+            retries += 1
+            if retries > RETRIES:
+                raise
+            print("%s: %s, resuming" % (plate, error))
+            time.sleep(retries)
+            result = requests.get(url, params={"path": status_path}, auth=auth, timeout=10).json()
+            offset = result["received"]
+            continue
+
+        if reply.status_code == 416:  # continue from what the plate has
+            offset = result["received"]
+            continue
+        if reply.status_code != 200:
+            print("%s: failed with %d %s" % (plate, reply.status_code, result))
+            return False
+
+        offset = result["received"]
+        retries = 0
+        if result["complete"]:
+            extra = " (%d files)" % result["files"] if "files" in result else ""
+            print("%s: %s uploaded%s" % (plate, path, extra))
+            return True
+
+
+ok = all([upload(plate) for plate in plates])
+sys.exit(0 if ok else 1)